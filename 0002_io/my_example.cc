@@ -7,10 +7,12 @@
 #include <parquet/arrow/writer.h>
 
 #include <iostream>
+
+#include "../0012_ipc_compression/ipc_compression.h"
 // (文档部分：包含)
 
 // (文档部分：生成初始文件)
-arrow::Status GenInitialFile() {
+arrow::Status GenInitialFile(const IpcCompressionOptions& ipc_compression) {
   // 创建一些8位整数数组和一个16位整数数组，就像基本的 Arrow 示例一样。
   arrow::Int8Builder int8builder;
   int8_t days_raw[5] = {1, 12, 17, 23, 28};
@@ -48,8 +50,10 @@ arrow::Status GenInitialFile() {
   // 为示例创建 IPC、CSV 和 Parquet 格式的测试文件。
   std::shared_ptr<arrow::io::FileOutputStream> outfile;
   ARROW_ASSIGN_OR_RAISE(outfile, arrow::io::FileOutputStream::Open("test_in.arrow"));
+  // IPC 文件按 ipc_compression 指定的编码压缩写入
+  ARROW_ASSIGN_OR_RAISE(auto ipc_write_options, MakeIpcWriteOptions(ipc_compression));
   ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ipc::RecordBatchWriter> ipc_writer,
-                        arrow::ipc::MakeFileWriter(outfile, schema));
+                        arrow::ipc::MakeFileWriter(outfile, schema, ipc_write_options));
   ARROW_RETURN_NOT_OK(ipc_writer->WriteTable(*table));
   ARROW_RETURN_NOT_OK(ipc_writer->Close());
 
@@ -72,7 +76,12 @@ arrow::Status RunMain() {
   // (文档部分：运行主函数)
   // (文档部分：生成文件)
   // 使用辅助函数生成各种格式的初始文件，不用担心，我们也会在本示例中写入一个表格。
-  ARROW_RETURN_NOT_OK(GenInitialFile());
+  // IPC 的压缩方式：UNCOMPRESSED、LZ4_FRAME 或 ZSTD，可以指定压缩级别和是否多线程压缩。
+  // 读取时不需要任何设置，读取器会自动解压。这里不压缩：Arrow 编译时不一定带了 LZ4/ZSTD，
+  // 要压缩时先用 arrow::util::Codec::IsAvailable 检查，编码的对比见 0012_ipc_compression。
+  IpcCompressionOptions ipc_compression;
+  ipc_compression.codec = arrow::Compression::UNCOMPRESSED;
+  ARROW_RETURN_NOT_OK(GenInitialFile(ipc_compression));
   // (文档部分：生成文件)
 
   // (文档部分：可读文件定义)
@@ -102,8 +111,10 @@ arrow::Status RunMain() {
   // (文档部分：Arrow 写入文件打开)
   // (文档部分：Arrow 写入器)
   // 使用输出文件和模式设置写入器。我们在这里定义了一切，准备就绪。
+  ARROW_ASSIGN_OR_RAISE(auto ipc_write_options, MakeIpcWriteOptions(ipc_compression));
   ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ipc::RecordBatchWriter> ipc_writer,
-                        arrow::ipc::MakeFileWriter(outfile, rbatch->schema()));
+                        arrow::ipc::MakeFileWriter(outfile, rbatch->schema(),
+                                                   ipc_write_options));
   // (文档部分：Arrow 写入器)
   // (文档部分：Arrow 写入)
   // 写入记录批次。
@@ -7,10 +7,12 @@
 #include <parquet/arrow/writer.h>
 
 #include <iostream>
+
+#include "../0012_ipc_compression/ipc_compression.h"
 // (Doc section: Includes)
 
 // (Doc section: GenInitialFile)
-arrow::Status GenInitialFile() {
+arrow::Status GenInitialFile(const IpcCompressionOptions& ipc_compression) {
   // Make a couple 8-bit integer arrays and a 16-bit integer array -- just like
   // basic Arrow example.
   arrow::Int8Builder int8builder;
@@ -49,8 +51,10 @@ arrow::Status GenInitialFile() {
   // Write out test files in IPC, CSV, and Parquet for the example to use.
   std::shared_ptr<arrow::io::FileOutputStream> outfile;
   ARROW_ASSIGN_OR_RAISE(outfile, arrow::io::FileOutputStream::Open("test_in.arrow"));
+  // The IPC file is compressed with the codec given in ipc_compression.
+  ARROW_ASSIGN_OR_RAISE(auto ipc_write_options, MakeIpcWriteOptions(ipc_compression));
   ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ipc::RecordBatchWriter> ipc_writer,
-                        arrow::ipc::MakeFileWriter(outfile, schema));
+                        arrow::ipc::MakeFileWriter(outfile, schema, ipc_write_options));
   ARROW_RETURN_NOT_OK(ipc_writer->WriteTable(*table));
   ARROW_RETURN_NOT_OK(ipc_writer->Close());
 
@@ -74,7 +78,13 @@ arrow::Status RunMain() {
   // (Doc section: Gen Files)
   // Generate initial files for each format with a helper function -- don't worry,
   // we'll also write a table in this example.
-  ARROW_RETURN_NOT_OK(GenInitialFile());
+  // Compression for the IPC files: UNCOMPRESSED, LZ4_FRAME or ZSTD, with an optional
+  // compression level and multi-threaded compression. Readers decompress automatically.
+  // We stay uncompressed here because an Arrow build may lack LZ4/ZSTD; check
+  // arrow::util::Codec::IsAvailable before picking a codec (see 0012_ipc_compression).
+  IpcCompressionOptions ipc_compression;
+  ipc_compression.codec = arrow::Compression::UNCOMPRESSED;
+  ARROW_RETURN_NOT_OK(GenInitialFile(ipc_compression));
   // (Doc section: Gen Files)
 
   // (Doc section: ReadableFile Definition)
@@ -108,8 +118,10 @@ arrow::Status RunMain() {
   // (Doc section: Arrow Writer)
   // Set up a writer with the output file -- and the schema! We're defining everything
   // here, loading to fire.
+  ARROW_ASSIGN_OR_RAISE(auto ipc_write_options, MakeIpcWriteOptions(ipc_compression));
   ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ipc::RecordBatchWriter> ipc_writer,
-                        arrow::ipc::MakeFileWriter(outfile, rbatch->schema()));
+                        arrow::ipc::MakeFileWriter(outfile, rbatch->schema(),
+                                                   ipc_write_options));
   // (Doc section: Arrow Writer)
   // (Doc section: Arrow Write)
   // Write the record batch.
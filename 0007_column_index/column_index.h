@@ -0,0 +1,397 @@
+// 列索引：对某一列只构建一次，之后可以反复查询。
+// HashIndex  - 开放寻址哈希表，做等值查找（例如按基金代码、按日期找行）
+// SortedIndex - 排序后的行号置换，做范围查找和 as-of 查找（<= 某个键的最后一行）
+// 两种索引都可以转换成一个单行的 RecordBatch（每列是 large_list），和 IPC 文件放在一起保存。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// 一段连续的行号（全局行号，跨 chunk 计数）
+struct RowSpan {
+  const int64_t* data = nullptr;
+  int64_t size = 0;
+
+  const int64_t* begin() const { return data; }
+  const int64_t* end() const { return data + size; }
+  bool empty() const { return size == 0; }
+};
+
+namespace column_index_internal {
+
+inline uint64_t Mix(uint64_t x) {
+  // splitmix64 的混合函数
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value, uint64_t>::type HashKey(T key) {
+  return Mix(static_cast<uint64_t>(key));
+}
+
+inline uint64_t HashKey(std::string_view key) {
+  // FNV-1a
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (unsigned char c : key) {
+    h ^= c;
+    h *= 0x100000001b3ULL;
+  }
+  return Mix(h);
+}
+
+// 只支持整数、日期时间（底层是整数）和字符串列；浮点数不适合做等值索引。
+template <typename ArrowType>
+constexpr bool IsIndexable() {
+  return arrow::is_integer_type<ArrowType>::value ||
+         arrow::is_temporal_type<ArrowType>::value ||
+         arrow::is_base_binary_type<ArrowType>::value;
+}
+
+// 把整个数组包装成一个只有一个元素的 large_list 数组（不拷贝 values）
+inline arrow::Result<std::shared_ptr<arrow::Array>> MakeListCell(
+    const std::shared_ptr<arrow::Array>& values) {
+  arrow::Int64Builder offset_builder;
+  ARROW_RETURN_NOT_OK(offset_builder.Append(0));
+  ARROW_RETURN_NOT_OK(offset_builder.Append(values->length()));
+  std::shared_ptr<arrow::Array> offsets;
+  ARROW_RETURN_NOT_OK(offset_builder.Finish(&offsets));
+  ARROW_ASSIGN_OR_RAISE(auto list, arrow::LargeListArray::FromArrays(*offsets, *values));
+  return list;
+}
+
+inline arrow::Result<std::shared_ptr<arrow::Array>> ListCellValues(
+    const arrow::RecordBatch& batch, const std::string& name) {
+  auto column = batch.GetColumnByName(name);
+  if (column == nullptr || column->type_id() != arrow::Type::LARGE_LIST || column->length() != 1) {
+    return arrow::Status::Invalid("index batch is missing list column '", name, "'");
+  }
+  return std::static_pointer_cast<arrow::LargeListArray>(column)->value_slice(0);
+}
+
+}  // namespace column_index_internal
+
+template <typename ArrowType>
+class HashIndex {
+  static_assert(column_index_internal::IsIndexable<ArrowType>(),
+                "HashIndex only supports integer, temporal and string columns");
+
+ public:
+  using ArrayType = typename arrow::TypeTraits<ArrowType>::ArrayType;
+  using BuilderType = typename arrow::TypeTraits<ArrowType>::BuilderType;
+  using KeyView = decltype(std::declval<const ArrayType&>().GetView(0));
+
+  // 扫描一遍列构建索引，null 不参与索引。
+  static arrow::Result<HashIndex> Build(const arrow::ChunkedArray& column) {
+    if (column.type()->id() != ArrowType::type_id) {
+      return arrow::Status::TypeError("HashIndex built over ", column.type()->ToString(),
+                                      " column");
+    }
+    HashIndex index;
+    index.type_ = column.type();
+
+    // 第一遍：给每一个不同的键分配一个组号，并记录每一行的组号
+    std::vector<KeyView> distinct;
+    std::vector<int32_t> row_group(column.length(), -1);
+    std::vector<int64_t> counts;
+    std::vector<int32_t> slots(16, -1);
+    uint64_t mask = slots.size() - 1;
+    int64_t row = 0;
+    for (const auto& chunk : column.chunks()) {
+      const auto& array = static_cast<const ArrayType&>(*chunk);
+      for (int64_t i = 0; i < array.length(); ++i, ++row) {
+        if (array.IsNull(i)) continue;
+        const KeyView key = array.GetView(i);
+        uint64_t pos = column_index_internal::HashKey(key) & mask;
+        while (slots[pos] >= 0 && distinct[slots[pos]] != key) pos = (pos + 1) & mask;
+        int32_t group = slots[pos];
+        if (group < 0) {
+          group = static_cast<int32_t>(distinct.size());
+          slots[pos] = group;
+          distinct.push_back(key);
+          counts.push_back(0);
+          // 装载因子超过 1/2 时扩容重排
+          if (distinct.size() * 2 > slots.size()) {
+            slots.assign(slots.size() * 2, -1);
+            mask = slots.size() - 1;
+            for (size_t g = 0; g < distinct.size(); ++g) {
+              uint64_t p = column_index_internal::HashKey(distinct[g]) & mask;
+              while (slots[p] >= 0) p = (p + 1) & mask;
+              slots[p] = static_cast<int32_t>(g);
+            }
+          }
+        }
+        row_group[row] = group;
+        ++counts[group];
+      }
+    }
+
+    // 第二遍：计数排序，把同一个键的行号放在一起（组内行号升序）
+    std::vector<int64_t> offsets(distinct.size() + 1, 0);
+    for (size_t g = 0; g < distinct.size(); ++g) offsets[g + 1] = offsets[g] + counts[g];
+    std::vector<int64_t> rows(offsets.back());
+    std::vector<int64_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (int64_t r = 0; r < column.length(); ++r) {
+      if (row_group[r] >= 0) rows[cursor[row_group[r]]++] = r;
+    }
+
+    BuilderType key_builder(index.type_, arrow::default_memory_pool());
+    ARROW_RETURN_NOT_OK(key_builder.Reserve(distinct.size()));
+    for (const auto& key : distinct) {
+      ARROW_RETURN_NOT_OK(key_builder.Append(key));
+    }
+    std::shared_ptr<arrow::Array> keys;
+    ARROW_RETURN_NOT_OK(key_builder.Finish(&keys));
+
+    arrow::Int32Builder slot_builder;
+    arrow::Int64Builder offset_builder, row_builder;
+    ARROW_RETURN_NOT_OK(slot_builder.AppendValues(slots));
+    ARROW_RETURN_NOT_OK(offset_builder.AppendValues(offsets));
+    ARROW_RETURN_NOT_OK(row_builder.AppendValues(rows));
+    std::shared_ptr<arrow::Array> slot_array, offset_array, row_array;
+    ARROW_RETURN_NOT_OK(slot_builder.Finish(&slot_array));
+    ARROW_RETURN_NOT_OK(offset_builder.Finish(&offset_array));
+    ARROW_RETURN_NOT_OK(row_builder.Finish(&row_array));
+    ARROW_RETURN_NOT_OK(index.Init(keys, slot_array, offset_array, row_array));
+    index.num_rows_ = column.length();
+    return index;
+  }
+
+  // 返回所有等于 key 的行号，行号升序；找不到时返回空
+  RowSpan Lookup(KeyView key) const {
+    uint64_t pos = column_index_internal::HashKey(key) & mask_;
+    while (true) {
+      const int32_t group = slots_[pos];
+      if (group < 0) return RowSpan();
+      if (keys_->GetView(group) == key) {
+        return RowSpan{rows_ + offsets_[group], offsets_[group + 1] - offsets_[group]};
+      }
+      pos = (pos + 1) & mask_;
+    }
+  }
+
+  int64_t num_keys() const { return keys_->length(); }
+  int64_t num_rows() const { return num_rows_; }
+
+  // 转成一个单行的 RecordBatch，方便写进 IPC 文件
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> ToRecordBatch() const {
+    std::vector<std::shared_ptr<arrow::Array>> cells;
+    for (const auto& values : {std::static_pointer_cast<arrow::Array>(keys_), slot_array_,
+                               offset_array_, row_array_}) {
+      ARROW_ASSIGN_OR_RAISE(auto cell, column_index_internal::MakeListCell(values));
+      cells.push_back(cell);
+    }
+    auto schema =
+        arrow::schema({arrow::field("keys", arrow::large_list(type_)),
+                       arrow::field("slots", arrow::large_list(arrow::int32())),
+                       arrow::field("offsets", arrow::large_list(arrow::int64())),
+                       arrow::field("rows", arrow::large_list(arrow::int64()))},
+                      arrow::key_value_metadata({"index_kind", "num_rows"},
+                                                {"hash", std::to_string(num_rows_)}));
+    return arrow::RecordBatch::Make(schema, 1, cells);
+  }
+
+  // 从 ToRecordBatch() 的结果恢复索引，不需要重新哈希，数组直接引用 batch 的内存
+  static arrow::Result<HashIndex> FromRecordBatch(const arrow::RecordBatch& batch) {
+    auto metadata = batch.schema()->metadata();
+    if (metadata == nullptr || metadata->Get("index_kind").ValueOr("") != "hash") {
+      return arrow::Status::Invalid("record batch does not hold a hash index");
+    }
+    HashIndex index;
+    ARROW_ASSIGN_OR_RAISE(auto keys, column_index_internal::ListCellValues(batch, "keys"));
+    ARROW_ASSIGN_OR_RAISE(auto slots, column_index_internal::ListCellValues(batch, "slots"));
+    ARROW_ASSIGN_OR_RAISE(auto offsets,
+                          column_index_internal::ListCellValues(batch, "offsets"));
+    ARROW_ASSIGN_OR_RAISE(auto rows, column_index_internal::ListCellValues(batch, "rows"));
+    if (keys->type_id() != ArrowType::type_id) {
+      return arrow::Status::TypeError("hash index keys are ", keys->type()->ToString());
+    }
+    index.type_ = keys->type();
+    ARROW_RETURN_NOT_OK(index.Init(keys, slots, offsets, rows));
+    index.num_rows_ = std::stoll(metadata->Get("num_rows").ValueOr("0"));
+    return index;
+  }
+
+ private:
+  arrow::Status Init(std::shared_ptr<arrow::Array> keys, std::shared_ptr<arrow::Array> slots,
+                     std::shared_ptr<arrow::Array> offsets,
+                     std::shared_ptr<arrow::Array> rows) {
+    if (slots->type_id() != arrow::Type::INT32 || offsets->type_id() != arrow::Type::INT64 ||
+        rows->type_id() != arrow::Type::INT64 || offsets->length() != keys->length() + 1 ||
+        slots->length() == 0 || (slots->length() & (slots->length() - 1)) != 0) {
+      return arrow::Status::Invalid("malformed hash index arrays");
+    }
+    keys_ = std::static_pointer_cast<ArrayType>(keys);
+    slot_array_ = std::move(slots);
+    offset_array_ = std::move(offsets);
+    row_array_ = std::move(rows);
+    slots_ = static_cast<const arrow::Int32Array&>(*slot_array_).raw_values();
+    offsets_ = static_cast<const arrow::Int64Array&>(*offset_array_).raw_values();
+    rows_ = static_cast<const arrow::Int64Array&>(*row_array_).raw_values();
+    mask_ = static_cast<uint64_t>(slot_array_->length() - 1);
+    return arrow::Status::OK();
+  }
+
+  std::shared_ptr<arrow::DataType> type_;
+  std::shared_ptr<ArrayType> keys_;
+  std::shared_ptr<arrow::Array> slot_array_, offset_array_, row_array_;
+  const int32_t* slots_ = nullptr;
+  const int64_t* offsets_ = nullptr;
+  const int64_t* rows_ = nullptr;
+  uint64_t mask_ = 0;
+  int64_t num_rows_ = 0;
+};
+
+template <typename ArrowType>
+class SortedIndex {
+  static_assert(column_index_internal::IsIndexable<ArrowType>(),
+                "SortedIndex only supports integer, temporal and string columns");
+
+ public:
+  using ArrayType = typename arrow::TypeTraits<ArrowType>::ArrayType;
+  using KeyView = decltype(std::declval<const ArrayType&>().GetView(0));
+
+  // 用 arrow::compute::SortIndices 做一次稳定排序，null 放在最后并且不参与索引。
+  static arrow::Result<SortedIndex> Build(const arrow::ChunkedArray& column) {
+    if (column.type()->id() != ArrowType::type_id) {
+      return arrow::Status::TypeError("SortedIndex built over ", column.type()->ToString(),
+                                      " column");
+    }
+    SortedIndex index;
+    index.num_rows_ = column.length();
+    // 没有 chunk 的列（例如空表的列）Concatenate 会失败，直接建一个空索引
+    if (column.num_chunks() == 0) {
+      ARROW_ASSIGN_OR_RAISE(auto empty_keys, arrow::MakeEmptyArray(column.type()));
+      ARROW_ASSIGN_OR_RAISE(auto empty_rows, arrow::MakeEmptyArray(arrow::int64()));
+      ARROW_RETURN_NOT_OK(index.Init(empty_keys, empty_rows));
+      return index;
+    }
+    ARROW_ASSIGN_OR_RAISE(auto indices, arrow::compute::SortIndices(column));
+    indices = indices->Slice(0, column.length() - column.null_count());
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum sorted,
+                          arrow::compute::Take(arrow::Datum(column), arrow::Datum(indices)));
+    ARROW_ASSIGN_OR_RAISE(auto keys,
+                          arrow::Concatenate(sorted.chunked_array()->chunks()));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum rows,
+                          arrow::compute::Cast(arrow::Datum(indices), arrow::int64()));
+    if (keys->length() == 0) {
+      ARROW_ASSIGN_OR_RAISE(keys, arrow::MakeEmptyArray(column.type()));
+    }
+    ARROW_RETURN_NOT_OK(index.Init(keys, rows.make_array()));
+    return index;
+  }
+
+  // 键落在闭区间 [lo, hi] 内的所有行号，按键有序（同键按行号升序）
+  RowSpan Range(KeyView lo, KeyView hi) const {
+    const int64_t first = LowerBound(lo);
+    const int64_t last = UpperBound(hi);
+    if (last <= first) return RowSpan();
+    return RowSpan{rows_ + first, last - first};
+  }
+
+  // as-of 查找：键 <= key 的最后一行（同键时取行号最大的那一行），不存在时返回 -1
+  int64_t AsOf(KeyView key) const {
+    const int64_t pos = UpperBound(key);
+    return pos == 0 ? -1 : rows_[pos - 1];
+  }
+
+  int64_t num_rows() const { return num_rows_; }
+
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> ToRecordBatch() const {
+    ARROW_ASSIGN_OR_RAISE(auto key_cell, column_index_internal::MakeListCell(keys_));
+    ARROW_ASSIGN_OR_RAISE(auto row_cell, column_index_internal::MakeListCell(row_array_));
+    auto schema = arrow::schema({arrow::field("keys", arrow::large_list(keys_->type())),
+                                 arrow::field("rows", arrow::large_list(arrow::int64()))},
+                                arrow::key_value_metadata({"index_kind", "num_rows"},
+                                                          {"sorted", std::to_string(num_rows_)}));
+    return arrow::RecordBatch::Make(schema, 1, {key_cell, row_cell});
+  }
+
+  static arrow::Result<SortedIndex> FromRecordBatch(const arrow::RecordBatch& batch) {
+    auto metadata = batch.schema()->metadata();
+    if (metadata == nullptr || metadata->Get("index_kind").ValueOr("") != "sorted") {
+      return arrow::Status::Invalid("record batch does not hold a sorted index");
+    }
+    ARROW_ASSIGN_OR_RAISE(auto keys, column_index_internal::ListCellValues(batch, "keys"));
+    ARROW_ASSIGN_OR_RAISE(auto rows, column_index_internal::ListCellValues(batch, "rows"));
+    if (keys->type_id() != ArrowType::type_id) {
+      return arrow::Status::TypeError("sorted index keys are ", keys->type()->ToString());
+    }
+    SortedIndex index;
+    ARROW_RETURN_NOT_OK(index.Init(keys, rows));
+    index.num_rows_ = std::stoll(metadata->Get("num_rows").ValueOr("0"));
+    return index;
+  }
+
+ private:
+  arrow::Status Init(std::shared_ptr<arrow::Array> keys, std::shared_ptr<arrow::Array> rows) {
+    if (rows->type_id() != arrow::Type::INT64 || rows->length() != keys->length()) {
+      return arrow::Status::Invalid("malformed sorted index arrays");
+    }
+    keys_ = std::static_pointer_cast<ArrayType>(keys);
+    row_array_ = std::move(rows);
+    rows_ = static_cast<const arrow::Int64Array&>(*row_array_).raw_values();
+    return arrow::Status::OK();
+  }
+
+  // 第一个键 >= key 的位置
+  int64_t LowerBound(KeyView key) const {
+    int64_t lo = 0, hi = keys_->length();
+    while (lo < hi) {
+      const int64_t mid = lo + (hi - lo) / 2;
+      if (keys_->GetView(mid) < key) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  // 第一个键 > key 的位置
+  int64_t UpperBound(KeyView key) const {
+    int64_t lo = 0, hi = keys_->length();
+    while (lo < hi) {
+      const int64_t mid = lo + (hi - lo) / 2;
+      if (key < keys_->GetView(mid)) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return lo;
+  }
+
+  std::shared_ptr<ArrayType> keys_;
+  std::shared_ptr<arrow::Array> row_array_;
+  const int64_t* rows_ = nullptr;
+  int64_t num_rows_ = 0;
+};
+
+// 把索引写成 IPC 文件，一般命名为 "<数据文件>.<列名>.idx"，和数据文件放在一起。
+inline arrow::Status WriteIndexFile(const std::string& path,
+                                    const std::shared_ptr<arrow::RecordBatch>& batch) {
+  ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::FileOutputStream::Open(path));
+  ARROW_ASSIGN_OR_RAISE(auto writer, arrow::ipc::MakeFileWriter(outfile, batch->schema()));
+  ARROW_RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+  return writer->Close();
+}
+
+// 读取索引文件。使用内存映射，索引数组直接指向映射的内存，加载几乎不花时间。
+inline arrow::Result<std::shared_ptr<arrow::RecordBatch>> ReadIndexFile(
+    const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto infile,
+                        arrow::io::MemoryMappedFile::Open(path, arrow::io::FileMode::READ));
+  ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(infile));
+  return reader->ReadRecordBatch(0);
+}
@@ -0,0 +1,179 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "../fund_panel/fund_panel.h"
+#include "column_index.h"
+// (文档部分: 包含)
+
+// 写出面板数据的 IPC 文件，和 0002_io 里的 GenInitialFile() 一样
+arrow::Status WritePanelFile(const std::string& path,
+                             const std::shared_ptr<arrow::Table>& table) {
+  ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::FileOutputStream::Open(path));
+  ARROW_ASSIGN_OR_RAISE(auto ipc_writer, arrow::ipc::MakeFileWriter(outfile, table->schema()));
+  ARROW_RETURN_NOT_OK(ipc_writer->WriteTable(*table));
+  return ipc_writer->Close();
+}
+
+arrow::Result<std::shared_ptr<arrow::Table>> ReadPanelFile(const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  ARROW_ASSIGN_OR_RAISE(auto ipc_reader, arrow::ipc::RecordBatchFileReader::Open(infile));
+  return ipc_reader->ToTable();
+}
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+arrow::Status RunMain() {
+  // (文档部分: 准备数据)
+  // 2000 只基金 × 750 个交易日，150 万行
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 2000;
+  panel_options.num_days = 750;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  ARROW_RETURN_NOT_OK(WritePanelFile("fund_panel.arrow", panel));
+  ARROW_ASSIGN_OR_RAISE(auto table, ReadPanelFile("fund_panel.arrow"));
+  auto fund_code = table->GetColumnByName("fund_code");
+  auto date = table->GetColumnByName("date");
+  std::cout << "rows: " << table->num_rows() << std::endl;
+  // (文档部分: 准备数据)
+
+  // (文档部分: 构建索引)
+  // 索引只需要构建一次：基金代码用哈希索引，日期用排序索引
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto code_index, HashIndex<arrow::StringType>::Build(*fund_code));
+  std::cout << "build hash index on fund_code: " << ElapsedMs(start_time) << " ms, "
+            << code_index.num_keys() << " keys" << std::endl;
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto date_index, SortedIndex<arrow::Date32Type>::Build(*date));
+  std::cout << "build sorted index on date: " << ElapsedMs(start_time) << " ms" << std::endl;
+  // (文档部分: 构建索引)
+
+  // (文档部分: 保存和加载索引)
+  // 索引和 IPC 数据文件放在一起，下次启动直接加载，不用重新构建
+  ARROW_ASSIGN_OR_RAISE(auto code_index_batch, code_index.ToRecordBatch());
+  ARROW_RETURN_NOT_OK(WriteIndexFile("fund_panel.arrow.fund_code.idx", code_index_batch));
+  ARROW_ASSIGN_OR_RAISE(auto date_index_batch, date_index.ToRecordBatch());
+  ARROW_RETURN_NOT_OK(WriteIndexFile("fund_panel.arrow.date.idx", date_index_batch));
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(code_index_batch, ReadIndexFile("fund_panel.arrow.fund_code.idx"));
+  ARROW_ASSIGN_OR_RAISE(code_index,
+                        HashIndex<arrow::StringType>::FromRecordBatch(*code_index_batch));
+  ARROW_ASSIGN_OR_RAISE(date_index_batch, ReadIndexFile("fund_panel.arrow.date.idx"));
+  ARROW_ASSIGN_OR_RAISE(date_index,
+                        SortedIndex<arrow::Date32Type>::FromRecordBatch(*date_index_batch));
+  std::cout << "load both indexes from disk: " << ElapsedMs(start_time) << " ms" << std::endl;
+  // (文档部分: 保存和加载索引)
+
+  // (文档部分: 等值查找)
+  // 随机挑选 200 个基金代码，对比 "index" 函数（每次都线性扫描整列）和哈希索引
+  const int num_queries = 200;
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> pick_fund(1, panel_options.num_funds);
+  std::vector<std::string> codes;
+  for (int i = 0; i < num_queries; ++i) codes.push_back(FundCode(pick_fund(rng)));
+
+  int64_t checksum_scan = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (const auto& code : codes) {
+    arrow::compute::IndexOptions index_options;
+    index_options.value = arrow::MakeScalar(code);
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum first_row,
+                          arrow::compute::CallFunction("index", {fund_code}, &index_options));
+    checksum_scan += first_row.scalar_as<arrow::Int64Scalar>().value;
+  }
+  double scan_ms = ElapsedMs(start_time);
+
+  int64_t checksum_index = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (const auto& code : codes) {
+    RowSpan rows = code_index.Lookup(code);
+    // 哈希索引返回全部匹配行，这里只取第一行和 "index" 的结果对比
+    checksum_index += rows.empty() ? -1 : rows.data[0];
+  }
+  double index_ms = ElapsedMs(start_time);
+  if (checksum_scan != checksum_index) {
+    return arrow::Status::Invalid("hash index disagrees with the index function");
+  }
+  std::cout << num_queries << " equality lookups, index function: " << scan_ms
+            << " ms, hash index: " << index_ms << " ms" << std::endl;
+  // (文档部分: 等值查找)
+
+  // (文档部分: 范围查找)
+  // 范围查找：取某个日期区间内的所有行，对比 compute 过滤和排序索引
+  std::uniform_int_distribution<int> pick_day(0, panel_options.num_days - 21);
+  std::vector<std::pair<int32_t, int32_t>> ranges;
+  for (int i = 0; i < num_queries; ++i) {
+    int first = pick_day(rng);
+    ranges.emplace_back(TradingDay(panel_options.start_date, first),
+                        TradingDay(panel_options.start_date, first + 20));
+  }
+
+  int64_t rows_scan = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (const auto& range : ranges) {
+    ARROW_ASSIGN_OR_RAISE(
+        arrow::Datum lower,
+        arrow::compute::CallFunction(
+            "greater_equal", {date, std::make_shared<arrow::Date32Scalar>(range.first)}));
+    ARROW_ASSIGN_OR_RAISE(
+        arrow::Datum upper,
+        arrow::compute::CallFunction(
+            "less_equal", {date, std::make_shared<arrow::Date32Scalar>(range.second)}));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum mask, arrow::compute::And(lower, upper));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum selected, arrow::compute::Filter(table, mask));
+    rows_scan += selected.table()->num_rows();
+  }
+  scan_ms = ElapsedMs(start_time);
+
+  int64_t rows_index = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (const auto& range : ranges) {
+    RowSpan rows = date_index.Range(range.first, range.second);
+    // 拿到行号以后用 Take 取出对应的行
+    auto indices = std::make_shared<arrow::Int64Array>(
+        rows.size, arrow::Buffer::Wrap(rows.data, rows.size));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum selected, arrow::compute::Take(table, indices));
+    rows_index += selected.table()->num_rows();
+  }
+  index_ms = ElapsedMs(start_time);
+  if (rows_scan != rows_index) {
+    return arrow::Status::Invalid("sorted index disagrees with the filter");
+  }
+  std::cout << num_queries << " date range queries (" << rows_index
+            << " rows), filter: " << scan_ms << " ms, sorted index: " << index_ms << " ms"
+            << std::endl;
+  // (文档部分: 范围查找)
+
+  // (文档部分: as-of 查找)
+  // as-of 查找：某个日期（可能是非交易日）当天或之前最近的一行
+  int32_t saturday = TradingDay(panel_options.start_date, 100);
+  while ((saturday + 4) % 7 != 6) ++saturday;
+  int64_t row = date_index.AsOf(saturday);
+  std::cout << "as-of " << saturday << ": row " << row << ", date "
+            << table->GetColumnByName("date")->GetScalar(row).ValueOrDie()->ToString()
+            << std::endl;
+  // (文档部分: as-of 查找)
+
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
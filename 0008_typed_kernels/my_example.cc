@@ -0,0 +1,171 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/buffer_builder.h>
+#include <arrow/compute/api.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "typed_kernels.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+// 生成一条随机游走的净值序列，每 2500 天重新从 1 开始（相当于把很多只基金首尾相接），
+// 避免超长序列连乘后上溢或下溢
+arrow::Result<std::shared_ptr<arrow::Array>> MakeNavSeries(int64_t length) {
+  std::mt19937_64 rng(42);
+  std::normal_distribution<double> daily_return(0.0003, 0.01);
+  arrow::TypedBufferBuilder<double> builder;
+  ARROW_RETURN_NOT_OK(builder.Reserve(length));
+  double nav = 1.0;
+  for (int64_t i = 0; i < length; ++i) {
+    nav = i % 2500 == 0 ? 1.0 : nav * (1.0 + daily_return(rng));
+    builder.UnsafeAppend(nav);
+  }
+  return typed::FinishArray<arrow::DoubleType>(&builder);
+}
+
+// 和 0006_cal_sharpe_ratio/my_example.cc 一样的 Datum 计算路径
+arrow::Result<double> DatumSharpeRatio(const std::shared_ptr<arrow::Array>& nav) {
+  auto now_nav = nav->Slice(1, nav->length() - 1);
+  auto pre_nav = nav->Slice(0, nav->length() - 1);
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum diff,
+                        arrow::compute::CallFunction("subtract", {now_nav, pre_nav}));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum returns,
+                        arrow::compute::CallFunction("divide", {diff, pre_nav}));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum avg_return,
+                        arrow::compute::CallFunction("mean", {returns}));
+  arrow::compute::VarianceOptions variance_options;
+  variance_options.ddof = 1;
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum avg_std,
+                        arrow::compute::CallFunction("stddev", {returns}, &variance_options));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum daily_sharpe_ratio,
+                        arrow::compute::CallFunction("divide", {avg_return, avg_std}));
+  ARROW_ASSIGN_OR_RAISE(
+      arrow::Datum sharpe_ratio,
+      arrow::compute::CallFunction("multiply",
+                                   {daily_sharpe_ratio, arrow::MakeScalar(std::sqrt(252.0))}));
+  return sharpe_ratio.scalar_as<arrow::DoubleScalar>().value;
+}
+
+// 对一种类型分别用 Datum 路径和强类型路径求和、求均值、求方差、逐元素相加
+template <typename ArrowType>
+arrow::Status CompareAggregates(int64_t length, int repeats) {
+  using CType = typed::CType<ArrowType>;
+  std::mt19937_64 rng(7);
+  std::uniform_int_distribution<int> dist(-1000, 1000);
+  arrow::TypedBufferBuilder<CType> builder;
+  ARROW_RETURN_NOT_OK(builder.Reserve(length));
+  for (int64_t i = 0; i < length; ++i) builder.UnsafeAppend(static_cast<CType>(dist(rng)));
+  ARROW_ASSIGN_OR_RAISE(auto array, typed::FinishArray<ArrowType>(&builder));
+
+  arrow::Datum sum, mean, variance, added;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    ARROW_ASSIGN_OR_RAISE(sum, arrow::compute::Sum(array));
+    ARROW_ASSIGN_OR_RAISE(mean, arrow::compute::Mean(array));
+    ARROW_ASSIGN_OR_RAISE(variance, arrow::compute::Variance(array));
+    ARROW_ASSIGN_OR_RAISE(added, arrow::compute::CallFunction("add", {array, array}));
+  }
+  const double datum_ms = ElapsedMs(start_time) / repeats;
+
+  ARROW_ASSIGN_OR_RAISE(const CType* values, typed::RawValues<ArrowType>(*array));
+  typed::AccType<ArrowType> typed_sum = 0;
+  double typed_mean = 0, typed_variance = 0;
+  std::shared_ptr<arrow::Array> typed_added;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    typed_sum = typed::Sum<ArrowType>(values, length);
+    typed_mean = typed::Mean<ArrowType>(values, length);
+    typed_variance = typed::Variance<ArrowType>(values, length);
+    arrow::TypedBufferBuilder<CType> out;
+    ARROW_RETURN_NOT_OK(typed::Add<ArrowType>(values, values, length, &out));
+    ARROW_ASSIGN_OR_RAISE(typed_added, typed::FinishArray<ArrowType>(&out));
+  }
+  const double typed_ms = ElapsedMs(start_time) / repeats;
+
+  // 整数结果应该完全一样，浮点结果只允许舍入误差
+  const double datum_sum = std::static_pointer_cast<arrow::NumericScalar<
+      typename arrow::CTypeTraits<typed::AccType<ArrowType>>::ArrowType>>(sum.scalar())
+                               ->value;
+  const double datum_mean = mean.scalar_as<arrow::DoubleScalar>().value;
+  const double datum_variance = variance.scalar_as<arrow::DoubleScalar>().value;
+  if (std::abs(datum_sum - static_cast<double>(typed_sum)) > 1e-6 * std::abs(datum_sum) ||
+      std::abs(datum_mean - typed_mean) > 1e-9 ||
+      std::abs(datum_variance - typed_variance) > 1e-9 * datum_variance ||
+      !added.make_array()->Equals(*typed_added)) {
+    return arrow::Status::Invalid("typed kernels disagree with compute for ",
+                                  ArrowType::type_name());
+  }
+  std::cout << ArrowType::type_name() << ": sum/mean/variance/add datum " << datum_ms
+            << " ms, typed " << typed_ms << " ms" << std::endl;
+  return arrow::Status::OK();
+}
+
+arrow::Status RunMain() {
+  // (文档部分: 夏普比率)
+  const int64_t length = 10 * 1000 * 1000;
+  const int repeats = 10;
+  ARROW_ASSIGN_OR_RAISE(auto nav, MakeNavSeries(length));
+
+  double datum_sharpe = 0;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    ARROW_ASSIGN_OR_RAISE(datum_sharpe, DatumSharpeRatio(nav));
+  }
+  const double datum_ms = ElapsedMs(start_time) / repeats;
+
+  // 中间结果落地到 TypedBufferBuilder 的版本
+  ARROW_ASSIGN_OR_RAISE(const double* nav_values, typed::RawValues<arrow::DoubleType>(*nav));
+  double builder_sharpe = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    arrow::TypedBufferBuilder<double> returns;
+    ARROW_RETURN_NOT_OK(typed::Returns<arrow::DoubleType>(nav_values, length, &returns));
+    const double mean = typed::Mean<arrow::DoubleType>(returns.data(), returns.length());
+    const double stddev = typed::Stddev<arrow::DoubleType>(returns.data(), returns.length(), 1);
+    builder_sharpe = mean / stddev * std::sqrt(252.0);
+  }
+  const double builder_ms = ElapsedMs(start_time) / repeats;
+
+  // 完全融合的版本，收益率不落地
+  double fused_sharpe = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    fused_sharpe = typed::SharpeRatio<arrow::DoubleType>(nav_values, length);
+  }
+  const double fused_ms = ElapsedMs(start_time) / repeats;
+
+  std::cout << "the result of sharpe ratio : datum " << datum_sharpe << ", typed "
+            << builder_sharpe << ", fused " << fused_sharpe << std::endl;
+  std::cout << "the consume time of sharpe ratio over " << length
+            << " navs: datum " << datum_ms << " ms, typed " << builder_ms << " ms, fused "
+            << fused_ms << " ms" << std::endl;
+  // (文档部分: 夏普比率)
+
+  // (文档部分: 各类型聚合)
+  ARROW_RETURN_NOT_OK(CompareAggregates<arrow::Int32Type>(length, repeats));
+  ARROW_RETURN_NOT_OK(CompareAggregates<arrow::Int64Type>(length, repeats));
+  ARROW_RETURN_NOT_OK(CompareAggregates<arrow::FloatType>(length, repeats));
+  ARROW_RETURN_NOT_OK(CompareAggregates<arrow::DoubleType>(length, repeats));
+  // (文档部分: 各类型聚合)
+
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
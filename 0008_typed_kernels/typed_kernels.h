@@ -0,0 +1,239 @@
+// 针对已知 schema 的强类型计算函数（只有头文件）。
+// 对 Int32Type、Int64Type、FloatType、DoubleType 实例化，直接在原始指针或
+// TypedBufferBuilder 上计算，不经过 Datum 和运行时类型分发，编译器可以把整条计算链内联并向量化。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/buffer_builder.h>
+
+#include <cmath>
+#include <type_traits>
+
+namespace typed {
+
+template <typename ArrowType>
+struct KernelTraits;
+
+// 求和时用的累加类型，和 arrow::compute::Sum 的结果类型一致
+template <>
+struct KernelTraits<arrow::Int32Type> {
+  using c_type = int32_t;
+  using acc_type = int64_t;
+};
+template <>
+struct KernelTraits<arrow::Int64Type> {
+  using c_type = int64_t;
+  using acc_type = int64_t;
+};
+template <>
+struct KernelTraits<arrow::FloatType> {
+  using c_type = float;
+  using acc_type = double;
+};
+template <>
+struct KernelTraits<arrow::DoubleType> {
+  using c_type = double;
+  using acc_type = double;
+};
+
+template <typename ArrowType>
+using CType = typename KernelTraits<ArrowType>::c_type;
+template <typename ArrowType>
+using AccType = typename KernelTraits<ArrowType>::acc_type;
+
+// 多路累加器的路数。浮点加法不满足结合律，编译器不会自己改写单个累加器的循环，
+// 这里显式拆成 8 路独立累加，循环体就可以直接映射成 SIMD 指令。
+// GCC 默认 -ffp-contract=fast，开 -march=native 后会把乘加合并成 FMA，最后几位和不合并时不同；
+// CMakeLists.txt 加了 -ffp-contract=off，结果只由累加顺序决定，和 -march 无关。
+constexpr int kLanes = 8;
+
+template <typename ArrowType>
+inline AccType<ArrowType> Sum(const CType<ArrowType>* values, int64_t length) {
+  using Acc = AccType<ArrowType>;
+  Acc lanes[kLanes] = {};
+  int64_t i = 0;
+  for (; i + kLanes <= length; i += kLanes) {
+    for (int j = 0; j < kLanes; ++j) lanes[j] += static_cast<Acc>(values[i + j]);
+  }
+  Acc sum = 0;
+  for (int j = 0; j < kLanes; ++j) sum += lanes[j];
+  for (; i < length; ++i) sum += static_cast<Acc>(values[i]);
+  return sum;
+}
+
+template <typename ArrowType>
+inline double Mean(const CType<ArrowType>* values, int64_t length) {
+  return static_cast<double>(Sum<ArrowType>(values, length)) / static_cast<double>(length);
+}
+
+// 两遍算法：先求均值，再求离差平方和，和 arrow::compute::Variance 一样支持 ddof
+template <typename ArrowType>
+inline double Variance(const CType<ArrowType>* values, int64_t length, int ddof = 0) {
+  const double mean = Mean<ArrowType>(values, length);
+  double lanes[kLanes] = {};
+  int64_t i = 0;
+  for (; i + kLanes <= length; i += kLanes) {
+    for (int j = 0; j < kLanes; ++j) {
+      const double d = static_cast<double>(values[i + j]) - mean;
+      lanes[j] += d * d;
+    }
+  }
+  double m2 = 0;
+  for (int j = 0; j < kLanes; ++j) m2 += lanes[j];
+  for (; i < length; ++i) {
+    const double d = static_cast<double>(values[i]) - mean;
+    m2 += d * d;
+  }
+  return m2 / static_cast<double>(length - ddof);
+}
+
+template <typename ArrowType>
+inline double Stddev(const CType<ArrowType>* values, int64_t length, int ddof = 0) {
+  return std::sqrt(Variance<ArrowType>(values, length, ddof));
+}
+
+// 逐元素运算，out 可以和输入重叠在同一位置（原地计算）
+template <typename ArrowType>
+inline void Add(const CType<ArrowType>* left, const CType<ArrowType>* right, int64_t length,
+                CType<ArrowType>* out) {
+  for (int64_t i = 0; i < length; ++i) out[i] = left[i] + right[i];
+}
+
+template <typename ArrowType>
+inline void Subtract(const CType<ArrowType>* left, const CType<ArrowType>* right,
+                     int64_t length, CType<ArrowType>* out) {
+  for (int64_t i = 0; i < length; ++i) out[i] = left[i] - right[i];
+}
+
+// 整数除法和 "divide" 一样向零取整，调用方要保证除数不为 0
+template <typename ArrowType>
+inline void Divide(const CType<ArrowType>* left, const CType<ArrowType>* right,
+                   int64_t length, CType<ArrowType>* out) {
+  for (int64_t i = 0; i < length; ++i) out[i] = left[i] / right[i];
+}
+
+// 滞后 periods 期：out[i] = values[i - periods]，前 periods 个位置填 fill
+template <typename ArrowType>
+inline void Lag(const CType<ArrowType>* values, int64_t length, int64_t periods,
+                CType<ArrowType> fill, CType<ArrowType>* out) {
+  const int64_t head = periods < length ? periods : length;
+  for (int64_t i = 0; i < head; ++i) out[i] = fill;
+  for (int64_t i = head; i < length; ++i) out[i] = values[i - periods];
+}
+
+// 日收益率 (nav[i + 1] - nav[i]) / nav[i]，也就是 lag + subtract + divide 融合成一个循环，
+// 输出 length - 1 个 double
+template <typename ArrowType>
+inline void Returns(const CType<ArrowType>* nav, int64_t length, double* out) {
+  for (int64_t i = 0; i + 1 < length; ++i) {
+    const double prev = static_cast<double>(nav[i]);
+    out[i] = (static_cast<double>(nav[i + 1]) - prev) / prev;
+  }
+}
+
+// 从净值直接算年化夏普比率，中间的收益率序列不落地：
+// 第一遍求收益率均值，第二遍求收益率的样本标准差（ddof = 1），两遍都是可以向量化的循环。
+template <typename ArrowType>
+inline double SharpeRatio(const CType<ArrowType>* nav, int64_t length,
+                          double periods_per_year = 252.0) {
+  const int64_t n = length - 1;
+  double lanes[kLanes] = {};
+  int64_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (int j = 0; j < kLanes; ++j) {
+      const double prev = static_cast<double>(nav[i + j]);
+      lanes[j] += (static_cast<double>(nav[i + j + 1]) - prev) / prev;
+    }
+  }
+  double sum = 0;
+  for (int j = 0; j < kLanes; ++j) sum += lanes[j];
+  for (; i < n; ++i) {
+    const double prev = static_cast<double>(nav[i]);
+    sum += (static_cast<double>(nav[i + 1]) - prev) / prev;
+  }
+  const double mean = sum / static_cast<double>(n);
+
+  for (int j = 0; j < kLanes; ++j) lanes[j] = 0;
+  for (i = 0; i + kLanes <= n; i += kLanes) {
+    for (int j = 0; j < kLanes; ++j) {
+      const double prev = static_cast<double>(nav[i + j]);
+      const double d = (static_cast<double>(nav[i + j + 1]) - prev) / prev - mean;
+      lanes[j] += d * d;
+    }
+  }
+  double m2 = 0;
+  for (int j = 0; j < kLanes; ++j) m2 += lanes[j];
+  for (; i < n; ++i) {
+    const double prev = static_cast<double>(nav[i]);
+    const double d = (static_cast<double>(nav[i + 1]) - prev) / prev - mean;
+    m2 += d * d;
+  }
+  const double stddev = std::sqrt(m2 / static_cast<double>(n - 1));
+  return mean / stddev * std::sqrt(periods_per_year);
+}
+
+// (TypedBufferBuilder 版本)
+// 结果直接追加到 TypedBufferBuilder 里，先 Reserve 再在可写指针上计算，最后 UnsafeAdvance，
+// 不会逐个元素调用 Append。
+
+template <typename ArrowType>
+arrow::Status Add(const CType<ArrowType>* left, const CType<ArrowType>* right, int64_t length,
+                  arrow::TypedBufferBuilder<CType<ArrowType>>* out) {
+  ARROW_RETURN_NOT_OK(out->Reserve(length));
+  Add<ArrowType>(left, right, length, out->mutable_data() + out->length());
+  out->UnsafeAdvance(length);
+  return arrow::Status::OK();
+}
+
+template <typename ArrowType>
+arrow::Status Divide(const CType<ArrowType>* left, const CType<ArrowType>* right,
+                     int64_t length, arrow::TypedBufferBuilder<CType<ArrowType>>* out) {
+  ARROW_RETURN_NOT_OK(out->Reserve(length));
+  Divide<ArrowType>(left, right, length, out->mutable_data() + out->length());
+  out->UnsafeAdvance(length);
+  return arrow::Status::OK();
+}
+
+template <typename ArrowType>
+arrow::Status Lag(const CType<ArrowType>* values, int64_t length, int64_t periods,
+                  CType<ArrowType> fill, arrow::TypedBufferBuilder<CType<ArrowType>>* out) {
+  ARROW_RETURN_NOT_OK(out->Reserve(length));
+  Lag<ArrowType>(values, length, periods, fill, out->mutable_data() + out->length());
+  out->UnsafeAdvance(length);
+  return arrow::Status::OK();
+}
+
+template <typename ArrowType>
+arrow::Status Returns(const CType<ArrowType>* nav, int64_t length,
+                      arrow::TypedBufferBuilder<double>* out) {
+  if (length < 2) return arrow::Status::OK();
+  ARROW_RETURN_NOT_OK(out->Reserve(length - 1));
+  Returns<ArrowType>(nav, length, out->mutable_data() + out->length());
+  out->UnsafeAdvance(length - 1);
+  return arrow::Status::OK();
+}
+
+// 从 Arrow 数组取出原始指针。这些函数不处理 null，遇到含 null 的数组直接报错。
+template <typename ArrowType>
+arrow::Result<const CType<ArrowType>*> RawValues(const arrow::Array& array) {
+  if (array.type_id() != ArrowType::type_id) {
+    return arrow::Status::TypeError("expected ", ArrowType::type_name(), " array, got ",
+                                    array.type()->ToString());
+  }
+  if (array.null_count() != 0) {
+    return arrow::Status::Invalid("typed kernels require arrays without nulls");
+  }
+  return static_cast<const arrow::NumericArray<ArrowType>&>(array).raw_values();
+}
+
+// 把 TypedBufferBuilder 里的结果变成 Arrow 数组，不拷贝
+template <typename ArrowType>
+arrow::Result<std::shared_ptr<arrow::Array>> FinishArray(
+    arrow::TypedBufferBuilder<CType<ArrowType>>* builder) {
+  const int64_t length = builder->length();
+  std::shared_ptr<arrow::Buffer> values;
+  ARROW_RETURN_NOT_OK(builder->Finish(&values));
+  return std::make_shared<arrow::NumericArray<ArrowType>>(length, std::move(values));
+}
+
+}  // namespace typed
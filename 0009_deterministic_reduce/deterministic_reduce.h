@@ -0,0 +1,327 @@
+// 可复现的并行归约：sum / mean / variance 的结果与线程数、ChunkedArray 的分块方式都无关，
+// 每次运行逐位相同。
+//
+// kPairwise：按全局下标把数据切成固定大小的块（和 chunk 边界无关），块内按下标模 8
+//            分到 8 路累加器，块与块之间按固定形状的二叉树合并。线程只决定谁来算哪一块，
+//            不影响任何一次加法的操作数和顺序。结果依赖 block_size，但同一个 block_size 下固定。
+// kExact：   超累加器（superaccumulator），把每个 double 精确地累加到定点整数上，
+//            加法满足结合律，最后只舍入一次，结果与顺序无关，也与 block_size 无关。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/util/bit_util.h>
+#include <arrow/util/parallel.h>
+#include <arrow/util/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace deterministic {
+
+enum class Mode { kPairwise, kExact };
+
+struct ReduceOptions {
+  Mode mode = Mode::kPairwise;
+  // 并行任务数，0 表示用 CPU 线程池的容量
+  int num_threads = 0;
+  // 固定形状归约树的叶子大小，必须是 8 的倍数
+  int64_t block_size = 16384;
+  // 为 nullptr 时使用全局 CPU 线程池
+  arrow::internal::Executor* executor = nullptr;
+};
+
+// 精确累加 double 的超累加器。每个 limb 存 32 位，权重为 2^(32 * k - 1074)，
+// 用 int64 存储留出进位空间，每累加 2^30 次做一次进位。
+class ExactAccumulator {
+ public:
+  void Add(double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    const int exponent = static_cast<int>((bits >> 52) & 0x7ff);
+    if (exponent == 0x7ff) {
+      // inf 或 nan 单独记录
+      if ((bits & ((uint64_t(1) << 52) - 1)) != 0) {
+        has_nan_ = true;
+      } else if (bits >> 63) {
+        has_neg_inf_ = true;
+      } else {
+        has_pos_inf_ = true;
+      }
+      return;
+    }
+    uint64_t mantissa = bits & ((uint64_t(1) << 52) - 1);
+    // x = mantissa * 2^(position - 1074)
+    int position = 0;
+    if (exponent != 0) {
+      mantissa |= uint64_t(1) << 52;
+      position = exponent - 1;
+    }
+    const int limb = position / 32;
+    const unsigned __int128 shifted = static_cast<unsigned __int128>(mantissa)
+                                      << (position % 32);
+    const int64_t d0 = static_cast<int64_t>(shifted & 0xffffffff);
+    const int64_t d1 = static_cast<int64_t>((shifted >> 32) & 0xffffffff);
+    const int64_t d2 = static_cast<int64_t>(shifted >> 64);
+    if (bits >> 63) {
+      limbs_[limb] -= d0;
+      limbs_[limb + 1] -= d1;
+      limbs_[limb + 2] -= d2;
+    } else {
+      limbs_[limb] += d0;
+      limbs_[limb + 1] += d1;
+      limbs_[limb + 2] += d2;
+    }
+    if (++pending_ == kMaxPending) Normalize();
+  }
+
+  void Merge(ExactAccumulator other) {
+    Normalize();
+    other.Normalize();
+    for (int k = 0; k < kNumLimbs; ++k) limbs_[k] += other.limbs_[k];
+    has_nan_ |= other.has_nan_;
+    has_pos_inf_ |= other.has_pos_inf_;
+    has_neg_inf_ |= other.has_neg_inf_;
+    pending_ = 1;
+  }
+
+  // 把精确结果舍入成最近的 double（结果为次正规数时可能有一次额外舍入）
+  double Round() const {
+    if (has_nan_ || (has_pos_inf_ && has_neg_inf_)) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (has_pos_inf_) return std::numeric_limits<double>::infinity();
+    if (has_neg_inf_) return -std::numeric_limits<double>::infinity();
+
+    ExactAccumulator copy = *this;
+    copy.Normalize();
+    // Normalize 之后除最高位 limb 外都在 [0, 2^32)，符号由最高位 limb 决定
+    const bool negative = copy.limbs_[kNumLimbs - 1] < 0;
+    uint32_t digits[kNumLimbs];
+    if (negative) {
+      // 取相反数：逐位取反加一
+      int64_t carry = 1;
+      for (int k = 0; k < kNumLimbs; ++k) {
+        const int64_t v = (~copy.limbs_[k] & 0xffffffff) + carry;
+        digits[k] = static_cast<uint32_t>(v & 0xffffffff);
+        carry = v >> 32;
+      }
+    } else {
+      for (int k = 0; k < kNumLimbs; ++k) digits[k] = static_cast<uint32_t>(copy.limbs_[k]);
+    }
+    int top = kNumLimbs - 1;
+    while (top >= 0 && digits[top] == 0) --top;
+    if (top < 0) return 0.0;
+    const int low = std::max(top - 2, 0);
+    unsigned __int128 head = 0;
+    for (int k = top; k >= low; --k) head = (head << 32) | digits[k];
+    // 更低的 limb 只影响舍入方向，合并成一个粘滞位
+    bool sticky = false;
+    for (int k = 0; k < low; ++k) sticky |= digits[k] != 0;
+    if (sticky) head |= 1;
+    const double magnitude = std::ldexp(static_cast<double>(head), 32 * low - 1074);
+    return negative ? -magnitude : magnitude;
+  }
+
+ private:
+  static constexpr int kNumLimbs = 68;
+  static constexpr int64_t kMaxPending = int64_t(1) << 30;
+
+  void Normalize() {
+    for (int k = 0; k < kNumLimbs - 1; ++k) {
+      const int64_t carry = limbs_[k] >> 32;
+      limbs_[k] -= carry * (int64_t(1) << 32);
+      limbs_[k + 1] += carry;
+    }
+    pending_ = 0;
+  }
+
+  int64_t limbs_[kNumLimbs] = {};
+  int64_t pending_ = 0;
+  bool has_nan_ = false;
+  bool has_pos_inf_ = false;
+  bool has_neg_inf_ = false;
+};
+
+namespace internal {
+
+// 固定形状的二叉树合并 partials[begin, end)
+inline double PairwiseCombine(const std::vector<double>& partials, size_t begin, size_t end) {
+  if (end - begin == 1) return partials[begin];
+  if (end == begin) return 0.0;
+  const size_t mid = begin + (end - begin) / 2;
+  return PairwiseCombine(partials, begin, mid) + PairwiseCombine(partials, mid, end);
+}
+
+// 按全局下标 [begin, end) 依次访问各个 chunk 中对应的连续片段：
+// visit(values, validity 或 nullptr, validity 的 bit 偏移, 片段长度, 片段起点的全局下标)
+template <typename Visit>
+void VisitRange(const arrow::ChunkedArray& column, const std::vector<int64_t>& chunk_starts,
+                int64_t begin, int64_t end, Visit&& visit) {
+  size_t c = std::upper_bound(chunk_starts.begin(), chunk_starts.end(), begin) -
+             chunk_starts.begin() - 1;
+  while (begin < end) {
+    const auto& chunk = static_cast<const arrow::DoubleArray&>(*column.chunk(c));
+    const int64_t local = begin - chunk_starts[c];
+    const int64_t length = std::min(chunk.length() - local, end - begin);
+    const uint8_t* validity = chunk.null_count() == 0 ? nullptr : chunk.null_bitmap_data();
+    visit(chunk.raw_values() + local, validity, chunk.offset() + local, length, begin);
+    begin += length;
+    ++c;
+  }
+}
+
+struct BlockPartial {
+  double sum = 0.0;
+  int64_t count = 0;
+};
+
+// 一个块内的归约：第 i 个元素固定加到 lanes[i % 8]，空值按 0 计入且不计数
+template <typename Map>
+BlockPartial ReduceBlock(const arrow::ChunkedArray& column,
+                         const std::vector<int64_t>& chunk_starts, int64_t begin, int64_t end,
+                         Map&& map) {
+  double lanes[8] = {};
+  int64_t count = 0;
+  VisitRange(column, chunk_starts, begin, end,
+             [&](const double* values, const uint8_t* validity, int64_t bit_offset,
+                 int64_t length, int64_t global) {
+               int64_t i = 0;
+               if (validity == nullptr) {
+                 for (; i < length && ((global + i) & 7) != 0; ++i) {
+                   lanes[(global + i) & 7] += map(values[i]);
+                 }
+                 for (; i + 8 <= length; i += 8) {
+                   for (int j = 0; j < 8; ++j) lanes[j] += map(values[i + j]);
+                 }
+                 for (; i < length; ++i) lanes[(global + i) & 7] += map(values[i]);
+                 count += length;
+               } else {
+                 for (; i < length; ++i) {
+                   const bool valid = arrow::bit_util::GetBit(validity, bit_offset + i);
+                   lanes[(global + i) & 7] += valid ? map(values[i]) : 0.0;
+                   count += valid;
+                 }
+               }
+             });
+  BlockPartial partial;
+  partial.sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+                ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+  partial.count = count;
+  return partial;
+}
+
+template <typename Map>
+arrow::Result<BlockPartial> Reduce(const arrow::ChunkedArray& column,
+                                   const ReduceOptions& options, Map&& map) {
+  if (column.type()->id() != arrow::Type::DOUBLE) {
+    return arrow::Status::TypeError("deterministic reductions expect float64, got ",
+                                    column.type()->ToString());
+  }
+  if (options.block_size <= 0 || options.block_size % 8 != 0) {
+    return arrow::Status::Invalid("block_size must be a positive multiple of 8");
+  }
+  std::vector<int64_t> chunk_starts;
+  int64_t start = 0;
+  for (const auto& chunk : column.chunks()) {
+    chunk_starts.push_back(start);
+    start += chunk->length();
+  }
+  const int64_t length = column.length();
+  const int64_t num_blocks = (length + options.block_size - 1) / options.block_size;
+  arrow::internal::Executor* executor =
+      options.executor != nullptr ? options.executor : arrow::internal::GetCpuThreadPool();
+  int num_tasks = options.num_threads > 0 ? options.num_threads : executor->GetCapacity();
+  num_tasks = static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(num_tasks, num_blocks)));
+  if (num_blocks == 0) return BlockPartial();
+
+  // 第 t 个任务处理第 t, t + T, t + 2T ... 块，不同的任务数只是改变分工
+  std::vector<int64_t> counts(num_tasks, 0);
+  BlockPartial result;
+  if (options.mode == Mode::kPairwise) {
+    std::vector<double> partials(num_blocks);
+    ARROW_RETURN_NOT_OK(arrow::internal::ParallelFor(
+        num_tasks,
+        [&](int task) {
+          for (int64_t b = task; b < num_blocks; b += num_tasks) {
+            const int64_t begin = b * options.block_size;
+            const int64_t end = std::min(length, begin + options.block_size);
+            BlockPartial partial = ReduceBlock(column, chunk_starts, begin, end, map);
+            partials[b] = partial.sum;
+            counts[task] += partial.count;
+          }
+          return arrow::Status::OK();
+        },
+        executor));
+    result.sum = PairwiseCombine(partials, 0, partials.size());
+  } else {
+    std::vector<ExactAccumulator> accumulators(num_tasks);
+    ARROW_RETURN_NOT_OK(arrow::internal::ParallelFor(
+        num_tasks,
+        [&](int task) {
+          ExactAccumulator& acc = accumulators[task];
+          for (int64_t b = task; b < num_blocks; b += num_tasks) {
+            const int64_t begin = b * options.block_size;
+            const int64_t end = std::min(length, begin + options.block_size);
+            VisitRange(column, chunk_starts, begin, end,
+                       [&](const double* values, const uint8_t* validity, int64_t bit_offset,
+                           int64_t n, int64_t) {
+                         for (int64_t i = 0; i < n; ++i) {
+                           if (validity == nullptr ||
+                               arrow::bit_util::GetBit(validity, bit_offset + i)) {
+                             acc.Add(map(values[i]));
+                             ++counts[task];
+                           }
+                         }
+                       });
+          }
+          return arrow::Status::OK();
+        },
+        executor));
+    for (int t = 1; t < num_tasks; ++t) accumulators[0].Merge(accumulators[t]);
+    result.sum = accumulators[0].Round();
+  }
+  for (int64_t c : counts) result.count += c;
+  return result;
+}
+
+}  // namespace internal
+
+// 非空元素之和
+inline arrow::Result<double> Sum(const arrow::ChunkedArray& column,
+                                 const ReduceOptions& options = ReduceOptions()) {
+  ARROW_ASSIGN_OR_RAISE(auto partial,
+                        internal::Reduce(column, options, [](double v) { return v; }));
+  return partial.sum;
+}
+
+// 非空元素的均值，没有非空元素时返回 NaN
+inline arrow::Result<double> Mean(const arrow::ChunkedArray& column,
+                                  const ReduceOptions& options = ReduceOptions()) {
+  ARROW_ASSIGN_OR_RAISE(auto partial,
+                        internal::Reduce(column, options, [](double v) { return v; }));
+  if (partial.count == 0) return std::numeric_limits<double>::quiet_NaN();
+  return partial.sum / static_cast<double>(partial.count);
+}
+
+// 两遍算法的方差，ddof 的含义和 arrow::compute::VarianceOptions 一样
+inline arrow::Result<double> Variance(const arrow::ChunkedArray& column, int ddof = 0,
+                                      const ReduceOptions& options = ReduceOptions()) {
+  ARROW_ASSIGN_OR_RAISE(double mean, Mean(column, options));
+  ARROW_ASSIGN_OR_RAISE(auto partial, internal::Reduce(column, options, [mean](double v) {
+                          const double d = v - mean;
+                          return d * d;
+                        }));
+  if (partial.count <= ddof) return std::numeric_limits<double>::quiet_NaN();
+  return partial.sum / static_cast<double>(partial.count - ddof);
+}
+
+inline arrow::Result<double> Stddev(const arrow::ChunkedArray& column, int ddof = 0,
+                                    const ReduceOptions& options = ReduceOptions()) {
+  ARROW_ASSIGN_OR_RAISE(double variance, Variance(column, ddof, options));
+  return std::sqrt(variance);
+}
+
+}  // namespace deterministic
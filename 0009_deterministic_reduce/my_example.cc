@@ -0,0 +1,152 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/util/thread_pool.h>
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "deterministic_reduce.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+// 打印 double 的原始位，用来比较结果是否逐位相同
+std::string Bits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  std::ostringstream out;
+  out << std::hex << std::setw(16) << std::setfill('0') << bits;
+  return out.str();
+}
+
+// 生成日收益率序列，约 1% 的空值（停牌）
+arrow::Result<std::shared_ptr<arrow::Array>> MakeReturns(int64_t length) {
+  std::mt19937_64 rng(42);
+  std::normal_distribution<double> daily_return(0.0003, 0.01);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  arrow::DoubleBuilder builder;
+  ARROW_RETURN_NOT_OK(builder.Reserve(length));
+  for (int64_t i = 0; i < length; ++i) {
+    const double r = daily_return(rng);
+    if (uniform(rng) < 0.01) {
+      builder.UnsafeAppendNull();
+    } else {
+      builder.UnsafeAppend(r);
+    }
+  }
+  return builder.Finish();
+}
+
+// 把同一份数据切成不同的 chunk，模拟不同的读取方式
+std::shared_ptr<arrow::ChunkedArray> Rechunk(const std::shared_ptr<arrow::Array>& array,
+                                             int64_t chunk_length) {
+  arrow::ArrayVector chunks;
+  for (int64_t offset = 0; offset < array->length(); offset += chunk_length) {
+    chunks.push_back(array->Slice(offset, chunk_length));
+  }
+  return std::make_shared<arrow::ChunkedArray>(chunks);
+}
+
+struct Stats {
+  double sum;
+  double mean;
+  double stddev;
+};
+
+arrow::Result<Stats> ArrowStats(const std::shared_ptr<arrow::ChunkedArray>& column) {
+  arrow::compute::VarianceOptions variance_options;
+  variance_options.ddof = 1;
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum sum, arrow::compute::Sum(column));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum mean, arrow::compute::Mean(column));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum stddev, arrow::compute::Stddev(column, variance_options));
+  return Stats{sum.scalar_as<arrow::DoubleScalar>().value,
+               mean.scalar_as<arrow::DoubleScalar>().value,
+               stddev.scalar_as<arrow::DoubleScalar>().value};
+}
+
+arrow::Result<Stats> DeterministicStats(const arrow::ChunkedArray& column,
+                                        const deterministic::ReduceOptions& options) {
+  ARROW_ASSIGN_OR_RAISE(double sum, deterministic::Sum(column, options));
+  ARROW_ASSIGN_OR_RAISE(double mean, deterministic::Mean(column, options));
+  ARROW_ASSIGN_OR_RAISE(double stddev, deterministic::Stddev(column, 1, options));
+  return Stats{sum, mean, stddev};
+}
+
+arrow::Status RunMain() {
+  const int64_t length = 20 * 1000 * 1000;
+  ARROW_ASSIGN_OR_RAISE(auto returns, MakeReturns(length));
+  const std::vector<int64_t> chunk_lengths = {length, 1 << 20, 65536, 9973};
+  const std::vector<int> thread_counts = {1, 2, 4, 8};
+
+  // (文档部分: Arrow 计算路径)
+  // 同一份数据用不同的分块方式求和，Arrow 的结果在最后几位可能不一样
+  std::cout << "arrow compute:" << std::endl;
+  for (int64_t chunk_length : chunk_lengths) {
+    auto column = Rechunk(returns, chunk_length);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ARROW_ASSIGN_OR_RAISE(auto stats, ArrowStats(column));
+    double ms = ElapsedMs(start_time);
+    std::cout << "  chunks " << std::setw(5) << column->num_chunks() << ": sum "
+              << Bits(stats.sum) << " mean " << Bits(stats.mean) << " stddev "
+              << Bits(stats.stddev) << "  " << ms << " ms" << std::endl;
+  }
+  // (文档部分: Arrow 计算路径)
+
+  // (文档部分: 可复现路径)
+  // 可复现路径：所有分块方式 × 所有线程数的结果都必须逐位相同
+  for (auto mode : {deterministic::Mode::kPairwise, deterministic::Mode::kExact}) {
+    std::cout << (mode == deterministic::Mode::kPairwise ? "pairwise:" : "exact:")
+              << std::endl;
+    bool first = true;
+    Stats expected{};
+    for (int threads : thread_counts) {
+      ARROW_ASSIGN_OR_RAISE(auto pool, arrow::internal::ThreadPool::Make(threads));
+      for (int64_t chunk_length : chunk_lengths) {
+        auto column = Rechunk(returns, chunk_length);
+        deterministic::ReduceOptions options;
+        options.mode = mode;
+        options.num_threads = threads;
+        options.executor = pool.get();
+        auto start_time = std::chrono::high_resolution_clock::now();
+        ARROW_ASSIGN_OR_RAISE(auto stats, DeterministicStats(*column, options));
+        double ms = ElapsedMs(start_time);
+        std::cout << "  threads " << threads << " chunks " << std::setw(5)
+                  << column->num_chunks() << ": sum " << Bits(stats.sum) << " mean "
+                  << Bits(stats.mean) << " stddev " << Bits(stats.stddev) << "  " << ms
+                  << " ms" << std::endl;
+        if (first) {
+          expected = stats;
+          first = false;
+        } else if (Bits(stats.sum) != Bits(expected.sum) ||
+                   Bits(stats.mean) != Bits(expected.mean) ||
+                   Bits(stats.stddev) != Bits(expected.stddev)) {
+          return arrow::Status::Invalid("deterministic reduction is not reproducible");
+        }
+      }
+    }
+    std::cout << "  mean " << std::setprecision(17) << expected.mean << " stddev "
+              << expected.stddev << std::setprecision(6) << std::endl;
+  }
+  // (文档部分: 可复现路径)
+
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
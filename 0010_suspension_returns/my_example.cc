@@ -0,0 +1,141 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "suspension_returns.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+// 生成带停牌的净值序列：偶尔出现 5~120 天的连续停牌，另外有零星的缺失值。
+// 每 2500 天重新从 1 开始，避免超长序列连乘后溢出。
+arrow::Result<std::shared_ptr<arrow::ChunkedArray>> MakeSuspendedNav(int64_t length,
+                                                                     int64_t chunk_length) {
+  std::mt19937_64 rng(42);
+  std::normal_distribution<double> daily_return(0.0003, 0.01);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::uniform_int_distribution<int> suspension_days(5, 120);
+  arrow::DoubleBuilder builder;
+  ARROW_RETURN_NOT_OK(builder.Reserve(length));
+  double nav = 1.0;
+  int64_t suspended_until = 0;
+  for (int64_t i = 0; i < length; ++i) {
+    nav = i % 2500 == 0 ? 1.0 : nav * (1.0 + daily_return(rng));
+    if (i >= suspended_until && uniform(rng) < 0.002) {
+      suspended_until = i + suspension_days(rng);
+    }
+    if (i < suspended_until || uniform(rng) < 0.01) {
+      builder.UnsafeAppendNull();
+    } else {
+      builder.UnsafeAppend(std::round(nav * 1e4) / 1e4);
+    }
+  }
+  ARROW_ASSIGN_OR_RAISE(auto array, builder.Finish());
+  arrow::ArrayVector chunks;
+  for (int64_t offset = 0; offset < length; offset += chunk_length) {
+    chunks.push_back(array->Slice(offset, chunk_length));
+  }
+  return std::make_shared<arrow::ChunkedArray>(chunks);
+}
+
+// 和 0006_cal_sharpe_ratio/my_example.cc 一样用 subtract / divide 计算收益率
+arrow::Result<arrow::Datum> ArrowReturns(const std::shared_ptr<arrow::ChunkedArray>& nav) {
+  auto now_nav = nav->Slice(1, nav->length() - 1);
+  auto pre_nav = nav->Slice(0, nav->length() - 1);
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum diff,
+                        arrow::compute::CallFunction("subtract", {now_nav, pre_nav}));
+  return arrow::compute::CallFunction("divide", {diff, pre_nav});
+}
+
+arrow::Result<double> SharpeRatio(const arrow::Datum& returns) {
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum mean, arrow::compute::Mean(returns));
+  arrow::compute::VarianceOptions variance_options;
+  variance_options.ddof = 1;
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum stddev, arrow::compute::Stddev(returns, variance_options));
+  return mean.scalar_as<arrow::DoubleScalar>().value /
+         stddev.scalar_as<arrow::DoubleScalar>().value * std::sqrt(252.0);
+}
+
+// 比较两组收益率：先去掉 null 再近似比较（两种算法的舍入方式不同）
+arrow::Status CheckSame(const arrow::Datum& expected, const arrow::Datum& actual,
+                        const std::string& name) {
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum left, arrow::compute::DropNull(expected));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum right, arrow::compute::DropNull(actual));
+  auto options = arrow::EqualOptions::Defaults().atol(1e-12);
+  if (!left.chunked_array()->ApproxEquals(*right.chunked_array(), options)) {
+    return arrow::Status::Invalid(name, " returns disagree with the arrow compute path");
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status RunMain() {
+  const int64_t length = 10 * 1000 * 1000;
+  ARROW_ASSIGN_OR_RAISE(auto nav, MakeSuspendedNav(length, 1 << 20));
+  std::cout << "navs: " << nav->length() << ", missing: " << nav->null_count() << std::endl;
+
+  // (文档部分: 跳过)
+  // kSkip：前后两天任意一天缺失，收益率就是 null
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum arrow_skip, ArrowReturns(nav));
+  double arrow_ms = ElapsedMs(start_time);
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto skip, SimpleReturns(*nav, GapPolicy::kSkip));
+  double bitmap_ms = ElapsedMs(start_time);
+  ARROW_RETURN_NOT_OK(CheckSame(arrow_skip, skip, "skip"));
+  ARROW_ASSIGN_OR_RAISE(double sharpe, SharpeRatio(skip));
+  std::cout << "skip:           arrow " << arrow_ms << " ms, bitmap words " << bitmap_ms
+            << " ms, sharpe " << sharpe << std::endl;
+  // (文档部分: 跳过)
+
+  // (文档部分: 向前填充)
+  // kForwardFill：对应 Arrow 的 fill_null_forward 之后再算收益率
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum filled,
+                        arrow::compute::CallFunction("fill_null_forward", {nav}));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum arrow_filled, ArrowReturns(filled.chunked_array()));
+  arrow_ms = ElapsedMs(start_time);
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto forward_fill, SimpleReturns(*nav, GapPolicy::kForwardFill));
+  bitmap_ms = ElapsedMs(start_time);
+  ARROW_RETURN_NOT_OK(CheckSame(arrow_filled, forward_fill, "forward fill"));
+  ARROW_ASSIGN_OR_RAISE(sharpe, SharpeRatio(forward_fill));
+  std::cout << "forward fill:   arrow " << arrow_ms << " ms, bitmap words " << bitmap_ms
+            << " ms, sharpe " << sharpe << std::endl;
+  // (文档部分: 向前填充)
+
+  // (文档部分: 复合)
+  // kCarryCompound：对应先 drop_null 再算收益率，但结果仍然和原来的日期对齐
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum dropped, arrow::compute::DropNull(nav));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum arrow_carry, ArrowReturns(dropped.chunked_array()));
+  arrow_ms = ElapsedMs(start_time);
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto carry, SimpleReturns(*nav, GapPolicy::kCarryCompound));
+  bitmap_ms = ElapsedMs(start_time);
+  ARROW_RETURN_NOT_OK(CheckSame(arrow_carry, carry, "carry compound"));
+  ARROW_ASSIGN_OR_RAISE(sharpe, SharpeRatio(carry));
+  std::cout << "carry compound: arrow " << arrow_ms << " ms, bitmap words " << bitmap_ms
+            << " ms, sharpe " << sharpe << std::endl;
+  // (文档部分: 复合)
+
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
@@ -0,0 +1,139 @@
+// 处理停牌和缺失净值的收益率计算。
+// 按 64 位一组扫描 validity bitmap（arrow::internal::OptionalBitBlockCounter）：
+// 整组都有效时走没有分支的快速循环，整组都缺失时直接整段设置结果，只有混合的组才逐个元素处理。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/util/bit_block_counter.h>
+#include <arrow/util/bit_util.h>
+#include <arrow/util/bitmap_ops.h>
+
+#include <algorithm>
+
+enum class GapPolicy {
+  // 当天或前一天缺失时收益率为 null，和 Arrow 的逐元素 null 传播一样
+  kSkip,
+  // 缺失的净值用上一个有效净值填充：停牌期间收益率为 0，复牌当天是相对停牌前的收益率
+  kForwardFill,
+  // 停牌期间收益率为 null，复牌当天把整个停牌期间的收益复合到这一天
+  // （0006 里 cal_sharpe_ratio.cpp 跳过无效行的做法就是这种语义）
+  kCarryCompound,
+};
+
+// 跨 chunk 计算时需要带过去的状态
+struct ReturnsState {
+  // 上一个有效净值
+  double last_valid = 0.0;
+  bool has_last_valid = false;
+  // 上一个元素（不论是否有效）是否有效，kSkip 使用
+  bool previous_valid = false;
+};
+
+namespace suspension_internal {
+
+// 处理 [begin, end) 这一段，输入全部有效
+inline void AllValidRun(const double* nav, int64_t begin, int64_t end, GapPolicy policy,
+                        ReturnsState* state, double* out, uint8_t* out_bitmap) {
+  // 第一个元素相对于前一个有效净值
+  const bool first_valid =
+      policy == GapPolicy::kSkip ? state->previous_valid : state->has_last_valid;
+  out[begin] = nav[begin] / state->last_valid - 1.0;
+  arrow::bit_util::SetBitTo(out_bitmap, begin, first_valid);
+  // 后面的元素都有前一天的净值，这个循环没有分支，可以向量化
+  for (int64_t i = begin + 1; i < end; ++i) out[i] = nav[i] / nav[i - 1] - 1.0;
+  arrow::bit_util::SetBitsTo(out_bitmap, begin + 1, end - begin - 1, true);
+  state->last_valid = nav[end - 1];
+  state->has_last_valid = true;
+  state->previous_valid = true;
+}
+
+// 处理 [begin, end) 这一段，输入全部缺失
+inline void AllNullRun(int64_t begin, int64_t end, GapPolicy policy, ReturnsState* state,
+                       double* out, uint8_t* out_bitmap) {
+  std::fill(out + begin, out + end, 0.0);
+  arrow::bit_util::SetBitsTo(out_bitmap, begin, end - begin,
+                             policy == GapPolicy::kForwardFill && state->has_last_valid);
+  state->previous_valid = false;
+}
+
+// 有效和缺失混合的一段，逐个元素处理。缺失的位置把净值当作上一个有效净值，
+// 这样所有情况都是同一个公式，只用条件选择，不需要分支。
+inline void MixedRun(const double* nav, const uint8_t* validity, int64_t validity_offset,
+                     int64_t begin, int64_t end, GapPolicy policy, ReturnsState* state,
+                     double* out, uint8_t* out_bitmap) {
+  const bool skip = policy == GapPolicy::kSkip;
+  const bool forward_fill = policy == GapPolicy::kForwardFill;
+  double last_valid = state->last_valid;
+  bool has_last_valid = state->has_last_valid;
+  bool previous_valid = state->previous_valid;
+  for (int64_t i = begin; i < end; ++i) {
+    const bool valid = arrow::bit_util::GetBit(validity, validity_offset + i);
+    const double value = valid ? nav[i] : last_valid;
+    out[i] = value / last_valid - 1.0;
+    const bool out_valid = valid ? (skip ? previous_valid : has_last_valid)
+                                 : (forward_fill && has_last_valid);
+    arrow::bit_util::SetBitTo(out_bitmap, i, out_valid);
+    last_valid = value;
+    has_last_valid |= valid;
+    previous_valid = valid;
+  }
+  state->last_valid = last_valid;
+  state->has_last_valid = has_last_valid;
+  state->previous_valid = previous_valid;
+}
+
+}  // namespace suspension_internal
+
+// 计算一段净值的简单收益率，结果和输入等长，第一个元素（没有前一天）为 null。
+// state 保存上一段的末尾状态，连续调用就可以处理 ChunkedArray。
+inline arrow::Result<std::shared_ptr<arrow::DoubleArray>> SimpleReturns(
+    const arrow::DoubleArray& nav, GapPolicy policy, ReturnsState* state,
+    arrow::MemoryPool* pool = arrow::default_memory_pool()) {
+  const int64_t length = nav.length();
+  ARROW_ASSIGN_OR_RAISE(auto values, arrow::AllocateBuffer(length * sizeof(double), pool));
+  ARROW_ASSIGN_OR_RAISE(auto bitmap, arrow::AllocateEmptyBitmap(length, pool));
+  double* out = reinterpret_cast<double*>(values->mutable_data());
+  uint8_t* out_bitmap = bitmap->mutable_data();
+  const double* in = nav.raw_values();
+  const uint8_t* validity = nav.null_count() == 0 ? nullptr : nav.null_bitmap_data();
+
+  // 每次取 64 位，根据其中有效位的个数选择处理方式
+  arrow::internal::OptionalBitBlockCounter counter(validity, nav.offset(), length);
+  int64_t position = 0;
+  while (position < length) {
+    const arrow::internal::BitBlockCount block = counter.NextBlock();
+    const int64_t end = position + block.length;
+    if (block.AllSet()) {
+      suspension_internal::AllValidRun(in, position, end, policy, state, out, out_bitmap);
+    } else if (block.NoneSet()) {
+      suspension_internal::AllNullRun(position, end, policy, state, out, out_bitmap);
+    } else {
+      suspension_internal::MixedRun(in, validity, nav.offset(), position, end, policy, state,
+                                    out, out_bitmap);
+    }
+    position = end;
+  }
+
+  const int64_t null_count = length - arrow::internal::CountSetBits(out_bitmap, 0, length);
+  return std::make_shared<arrow::DoubleArray>(length, std::shared_ptr<arrow::Buffer>(
+                                                          std::move(values)),
+                                              std::move(bitmap), null_count);
+}
+
+inline arrow::Result<std::shared_ptr<arrow::ChunkedArray>> SimpleReturns(
+    const arrow::ChunkedArray& nav, GapPolicy policy,
+    arrow::MemoryPool* pool = arrow::default_memory_pool()) {
+  if (nav.type()->id() != arrow::Type::DOUBLE) {
+    return arrow::Status::TypeError("SimpleReturns expects float64 navs, got ",
+                                    nav.type()->ToString());
+  }
+  ReturnsState state;
+  arrow::ArrayVector chunks;
+  for (const auto& chunk : nav.chunks()) {
+    ARROW_ASSIGN_OR_RAISE(
+        auto returns,
+        SimpleReturns(static_cast<const arrow::DoubleArray&>(*chunk), policy, &state, pool));
+    chunks.push_back(returns);
+  }
+  return std::make_shared<arrow::ChunkedArray>(chunks, arrow::float64());
+}
@@ -0,0 +1,387 @@
+// 定点数形式存储净值：净值最多 4~6 位小数，用 int32 / int64 乘以 10^scale 存储，
+// 或者转换成 Arrow 的 decimal128。解析只用整数运算，收益率也在整数上计算差分。
+// 列的 scale 记录在字段元数据 "scale" 里。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/buffer_builder.h>
+#include <arrow/util/bit_util.h>
+#include <arrow/util/int_util_overflow.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace fixed_point {
+
+constexpr int64_t kPowersOfTen[] = {1,
+                                    10,
+                                    100,
+                                    1000,
+                                    10000,
+                                    100000,
+                                    1000000,
+                                    10000000,
+                                    100000000,
+                                    1000000000,
+                                    10000000000LL,
+                                    100000000000LL,
+                                    1000000000000LL};
+constexpr int kMaxScale = 12;
+
+// 带 scale 元数据的字段
+inline std::shared_ptr<arrow::Field> Field(const std::string& name,
+                                           std::shared_ptr<arrow::DataType> type, int scale) {
+  return arrow::field(name, std::move(type), true,
+                      arrow::key_value_metadata({"scale"}, {std::to_string(scale)}));
+}
+
+// 读取字段元数据中的 scale
+inline arrow::Result<int> ScaleOf(const arrow::Field& field) {
+  if (field.metadata() == nullptr || !field.metadata()->Contains("scale")) {
+    return arrow::Status::Invalid("field '", field.name(), "' has no fixed-point scale");
+  }
+  ARROW_ASSIGN_OR_RAISE(auto scale, field.metadata()->Get("scale"));
+  return std::stoi(scale);
+}
+
+// 把 "1.2345"、"-0.5"、"3" 这样的十进制字符串解析成 value * 10^scale 的整数。
+// 小数位多于 scale 时按第 scale + 1 位四舍五入，空字符串或非法字符返回 false。
+inline bool Parse(const char* begin, const char* end, int scale, int64_t* out) {
+  while (begin < end && *begin == ' ') ++begin;
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\r')) --end;
+  if (begin == end) return false;
+  bool negative = false;
+  if (*begin == '-' || *begin == '+') {
+    negative = *begin == '-';
+    ++begin;
+  }
+  int64_t value = 0;
+  int digits = 0;
+  while (begin < end && *begin >= '0' && *begin <= '9') {
+    value = value * 10 + (*begin++ - '0');
+    if (++digits > 18 - scale) return false;
+  }
+  int fraction = 0;
+  bool round_up = false;
+  if (begin < end && *begin == '.') {
+    ++begin;
+    while (begin < end && *begin >= '0' && *begin <= '9') {
+      if (fraction < scale) {
+        value = value * 10 + (*begin - '0');
+        ++fraction;
+      } else if (fraction == scale) {
+        round_up = *begin >= '5';
+        ++fraction;
+      }
+      ++begin;
+      ++digits;
+    }
+  }
+  if (begin != end || digits == 0) return false;
+  if (fraction < scale) value *= kPowersOfTen[scale - fraction];
+  if (round_up) ++value;
+  *out = negative ? -value : value;
+  return true;
+}
+
+// "YYYY-MM-DD" 解析成 date32（自 1970-01-01 起的天数），只用整数运算。
+// 格式不对或年月日里有非数字字符时返回 false，调用方报 Status::Invalid
+inline bool ParseDate(const char* begin, const char* end, int32_t* out) {
+  while (begin < end && *begin == ' ') ++begin;
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\r')) --end;
+  if (end - begin != 10 || begin[4] != '-' || begin[7] != '-') return false;
+  for (int i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+    if (begin[i] < '0' || begin[i] > '9') return false;
+  }
+  auto digit = [&](int i) { return begin[i] - '0'; };
+  int y = digit(0) * 1000 + digit(1) * 100 + digit(2) * 10 + digit(3);
+  const unsigned m = digit(5) * 10 + digit(6);
+  const unsigned d = digit(8) * 10 + digit(9);
+  if (m < 1 || m > 12 || d < 1 || d > 31) return false;
+  // Howard Hinnant 的 days_from_civil
+  y -= m <= 2;
+  const int era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = static_cast<unsigned>(y - era * 400);
+  const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  *out = era * 146097 + static_cast<int>(doe) - 719468;
+  return true;
+}
+
+// 把字符串列转换成定点整数列（Int32Type 或 Int64Type），无法解析的值变成 null
+template <typename ArrowType>
+arrow::Result<std::shared_ptr<arrow::Array>> ParseColumn(const arrow::StringArray& strings,
+                                                         int scale) {
+  static_assert(std::is_same<ArrowType, arrow::Int32Type>::value ||
+                    std::is_same<ArrowType, arrow::Int64Type>::value,
+                "fixed-point columns are int32 or int64");
+  using CType = typename ArrowType::c_type;
+  if (scale < 0 || scale > kMaxScale) return arrow::Status::Invalid("scale out of range");
+  arrow::NumericBuilder<ArrowType> builder;
+  ARROW_RETURN_NOT_OK(builder.Reserve(strings.length()));
+  for (int64_t i = 0; i < strings.length(); ++i) {
+    int64_t value;
+    if (strings.IsValid(i)) {
+      std::string_view view = strings.GetView(i);
+      if (Parse(view.data(), view.data() + view.size(), scale, &value) &&
+          value >= std::numeric_limits<CType>::min() &&
+          value <= std::numeric_limits<CType>::max()) {
+        builder.UnsafeAppend(static_cast<CType>(value));
+        continue;
+      }
+    }
+    builder.UnsafeAppendNull();
+  }
+  return builder.Finish();
+}
+
+// 定点整数列转换成 decimal128(precision, scale)，整数值就是 decimal 的未缩放值，不需要乘除
+template <typename ArrowType>
+arrow::Result<std::shared_ptr<arrow::Array>> ToDecimal128(const arrow::Array& array,
+                                                          int precision, int scale) {
+  const auto& values = static_cast<const arrow::NumericArray<ArrowType>&>(array);
+  arrow::Decimal128Builder builder(arrow::decimal128(precision, scale));
+  ARROW_RETURN_NOT_OK(builder.Reserve(values.length()));
+  for (int64_t i = 0; i < values.length(); ++i) {
+    if (values.IsNull(i)) {
+      builder.UnsafeAppendNull();
+    } else {
+      builder.UnsafeAppend(arrow::Decimal128(static_cast<int64_t>(values.Value(i))));
+    }
+  }
+  return builder.Finish();
+}
+
+// 定点数转回 double，只在输出时使用
+template <typename CType>
+inline double ToDouble(CType value, int scale) {
+  return static_cast<double>(value) / static_cast<double>(kPowersOfTen[scale]);
+}
+
+// 整数差分 out[i] = nav[i + 1] - nav[i]，结果是精确的
+template <typename CType>
+inline void Diff(const CType* nav, int64_t length, CType* out) {
+  for (int64_t i = 0; i + 1 < length; ++i) out[i] = nav[i + 1] - nav[i];
+}
+
+// 第 i 个收益率用到 nav[i] 和 nav[i + 1]。任何一个是 null（ParseNavCsv 把无法解析的值记为 null），
+// 或者分母 nav[i] 不是正数时收益率没有定义
+template <typename ArrowType>
+inline bool ReturnDefined(const arrow::NumericArray<ArrowType>& nav, int64_t i) {
+  return nav.IsValid(i) && nav.IsValid(i + 1) && nav.Value(i) > 0;
+}
+
+// 日收益率：分子是精确的整数差，只在最后做一次除法。scale 会被约掉，不需要传入。
+// 结果比 nav 少一个元素，没有定义的收益率是 null
+template <typename ArrowType>
+arrow::Result<std::shared_ptr<arrow::DoubleArray>> Returns(
+    const arrow::NumericArray<ArrowType>& nav) {
+  using CType = typename ArrowType::c_type;
+  const int64_t length = std::max<int64_t>(nav.length() - 1, 0);
+  const CType* values = nav.raw_values();
+  ARROW_ASSIGN_OR_RAISE(auto out, arrow::AllocateBuffer(length * sizeof(double)));
+  auto* returns = reinterpret_cast<double*>(out->mutable_data());
+  if constexpr (sizeof(CType) < sizeof(int64_t)) {
+    // int32 转成 double 是精确的，两个 int32 的差也在 double 的 53 位精度之内，
+    // 在 double 上做减法结果和整数差一样，整段可以向量化。
+    // 分母为 0 的位置得到 inf 或 NaN（浮点除法不会中断程序），下面再标成 null
+    for (int64_t i = 0; i < length; ++i) {
+      returns[i] = (static_cast<double>(values[i + 1]) - static_cast<double>(values[i])) /
+                   static_cast<double>(values[i]);
+    }
+  } else {
+    for (int64_t i = 0; i < length; ++i) {
+      int64_t diff = 0;
+      if (ReturnDefined(nav, i) &&
+          arrow::internal::SubtractWithOverflow(values[i + 1], values[i], &diff)) {
+        return arrow::Status::Invalid("nav difference at row ", i, " overflows int64");
+      }
+      returns[i] = static_cast<double>(diff) / static_cast<double>(values[i]);
+    }
+  }
+  int64_t null_count = 0;
+  if (nav.null_count() == 0) {
+    for (int64_t i = 0; i < length; ++i) null_count += values[i] <= 0;
+  } else {
+    for (int64_t i = 0; i < length; ++i) null_count += !ReturnDefined(nav, i);
+  }
+  std::shared_ptr<arrow::Buffer> validity;
+  if (null_count > 0) {
+    ARROW_ASSIGN_OR_RAISE(validity, arrow::AllocateBitmap(length));
+    for (int64_t i = 0; i < length; ++i) {
+      arrow::bit_util::SetBitTo(validity->mutable_data(), i, ReturnDefined(nav, i));
+    }
+  }
+  return std::make_shared<arrow::DoubleArray>(length, std::move(out), std::move(validity),
+                                              null_count);
+}
+
+// 精确的定点收益率：结果乘以 10^return_scale 后四舍五入，全程整数运算。
+// 没有定义的收益率是 null；乘上 10^return_scale 后超出 int64 时返回 Invalid
+template <typename ArrowType>
+arrow::Result<std::shared_ptr<arrow::Int64Array>> ScaledReturns(
+    const arrow::NumericArray<ArrowType>& nav, int return_scale) {
+  if (return_scale < 0 || return_scale > kMaxScale) {
+    return arrow::Status::Invalid("return_scale must be in [0, ", kMaxScale, "], got ",
+                                  return_scale);
+  }
+  const int64_t factor = kPowersOfTen[return_scale];
+  const int64_t length = std::max<int64_t>(nav.length() - 1, 0);
+  const auto* values = nav.raw_values();
+  arrow::Int64Builder builder;
+  ARROW_RETURN_NOT_OK(builder.Reserve(length));
+  for (int64_t i = 0; i < length; ++i) {
+    if (!ReturnDefined(nav, i)) {
+      builder.UnsafeAppendNull();
+      continue;
+    }
+    const int64_t denominator = values[i];
+    const int64_t half = denominator / 2;
+    int64_t numerator;
+    if (arrow::internal::SubtractWithOverflow(static_cast<int64_t>(values[i + 1]), denominator,
+                                              &numerator) ||
+        arrow::internal::MultiplyWithOverflow(numerator, factor, &numerator) ||
+        arrow::internal::AddWithOverflow(numerator, numerator >= 0 ? half : -half,
+                                         &numerator)) {
+      return arrow::Status::Invalid("return at row ", i, " overflows int64 at return_scale ",
+                                    return_scale);
+    }
+    // 分母是正数，除法向零截断，先加减半个分母就是四舍五入
+    builder.UnsafeAppend(numerator / denominator);
+  }
+  std::shared_ptr<arrow::Int64Array> out;
+  ARROW_RETURN_NOT_OK(builder.Finish(&out));
+  return out;
+}
+
+// 解析 0006_cal_sharpe_ratio/fund_nav.csv 这种格式的 CSV：第一列是日期，nav_columns 指定的列
+// （递增，最多 8 列）是净值，其余列忽略。直接在文件内容上扫描，日期写入 date32，
+// 净值按每列自己的 scale 写成定点数，类型是 int32 或 int64。
+// 无法解析或超出类型范围的值是 null
+struct NavCsvOptions {
+  std::vector<int> nav_columns = {1, 2};
+  std::vector<std::string> nav_names = {"nav", "adj_nav"};
+  // 每列的 scale，和 nav_columns 一一对应
+  std::vector<int> nav_scales = {4, 4};
+  // arrow::int32() 或 arrow::int64()。scale 为 4 时 int32 最大约 21 万，
+  // 需要更多小数位或更大的值时用 int64
+  std::shared_ptr<arrow::DataType> value_type = arrow::int32();
+  bool skip_header = true;
+};
+
+inline arrow::Result<std::shared_ptr<arrow::RecordBatch>> ParseNavCsv(
+    const arrow::Buffer& contents, const NavCsvOptions& options) {
+  const char* p = reinterpret_cast<const char*>(contents.data());
+  const char* end = p + contents.size();
+  if (options.skip_header) {
+    while (p < end && *p != '\n') ++p;
+    if (p < end) ++p;
+  }
+  const size_t num_navs = options.nav_columns.size();
+  if (num_navs > 8 || options.nav_names.size() != num_navs ||
+      options.nav_scales.size() != num_navs) {
+    return arrow::Status::Invalid("expected at most 8 nav columns, each with a name and a scale");
+  }
+  for (size_t c = 0; c < num_navs; ++c) {
+    if (options.nav_columns[c] < 1 ||
+        (c > 0 && options.nav_columns[c] <= options.nav_columns[c - 1])) {
+      return arrow::Status::Invalid("nav_columns must be increasing and skip the date column");
+    }
+    if (options.nav_scales[c] < 0 || options.nav_scales[c] > kMaxScale) {
+      return arrow::Status::Invalid("scale of ", options.nav_names[c], " out of range");
+    }
+  }
+  if (options.value_type == nullptr || (options.value_type->id() != arrow::Type::INT32 &&
+                                        options.value_type->id() != arrow::Type::INT64)) {
+    return arrow::Status::Invalid("fixed-point columns are int32 or int64");
+  }
+  const bool wide = options.value_type->id() == arrow::Type::INT64;
+  const int64_t min_value =
+      wide ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int32_t>::min();
+  const int64_t max_value =
+      wide ? std::numeric_limits<int64_t>::max() : std::numeric_limits<int32_t>::max();
+  // 估计行数，先一次性 Reserve
+  int64_t estimated_rows = 0;
+  for (const char* q = p; q < end; ++q) estimated_rows += *q == '\n';
+  ++estimated_rows;
+
+  arrow::TypedBufferBuilder<int32_t> dates;
+  // 只用其中一种，取决于 value_type
+  std::vector<arrow::TypedBufferBuilder<int32_t>> navs32(wide ? 0 : num_navs);
+  std::vector<arrow::TypedBufferBuilder<int64_t>> navs64(wide ? num_navs : 0);
+  std::vector<arrow::TypedBufferBuilder<bool>> valid(num_navs);
+  ARROW_RETURN_NOT_OK(dates.Reserve(estimated_rows));
+  for (size_t c = 0; c < num_navs; ++c) {
+    ARROW_RETURN_NOT_OK(wide ? navs64[c].Reserve(estimated_rows)
+                             : navs32[c].Reserve(estimated_rows));
+    ARROW_RETURN_NOT_OK(valid[c].Reserve(estimated_rows));
+  }
+  std::vector<int64_t> null_counts(num_navs, 0);
+
+  while (p < end) {
+    const char* line_end = p;
+    while (line_end < end && *line_end != '\n') ++line_end;
+    if (line_end == p || (line_end - p == 1 && *p == '\r')) {
+      p = line_end + 1;
+      continue;
+    }
+    int column = 0;
+    size_t next_nav = 0;
+    const char* field = p;
+    bool has_date = false;
+    int32_t date = 0;
+    int64_t values[8];
+    bool ok[8] = {};
+    while (field <= line_end) {
+      const char* field_end = field;
+      while (field_end < line_end && *field_end != ',') ++field_end;
+      if (column == 0) {
+        has_date = ParseDate(field, field_end, &date);
+      } else if (next_nav < num_navs && column == options.nav_columns[next_nav]) {
+        ok[next_nav] =
+            Parse(field, field_end, options.nav_scales[next_nav], &values[next_nav]) &&
+            values[next_nav] >= min_value && values[next_nav] <= max_value;
+        ++next_nav;
+      }
+      ++column;
+      field = field_end + 1;
+    }
+    if (!has_date) {
+      return arrow::Status::Invalid("invalid date in line: ", std::string(p, line_end));
+    }
+    dates.UnsafeAppend(date);
+    for (size_t c = 0; c < num_navs; ++c) {
+      if (wide) {
+        navs64[c].UnsafeAppend(ok[c] ? values[c] : 0);
+      } else {
+        navs32[c].UnsafeAppend(ok[c] ? static_cast<int32_t>(values[c]) : 0);
+      }
+      valid[c].UnsafeAppend(ok[c]);
+      null_counts[c] += !ok[c];
+    }
+    p = line_end + 1;
+  }
+
+  const int64_t num_rows = dates.length();
+  arrow::FieldVector fields = {arrow::field("date", arrow::date32())};
+  arrow::ArrayVector columns;
+  std::shared_ptr<arrow::Buffer> date_values;
+  ARROW_RETURN_NOT_OK(dates.Finish(&date_values));
+  columns.push_back(std::make_shared<arrow::Date32Array>(num_rows, date_values));
+  for (size_t c = 0; c < num_navs; ++c) {
+    std::shared_ptr<arrow::Buffer> nav_values, nav_validity;
+    ARROW_RETURN_NOT_OK(wide ? navs64[c].Finish(&nav_values) : navs32[c].Finish(&nav_values));
+    ARROW_RETURN_NOT_OK(valid[c].Finish(&nav_validity));
+    if (null_counts[c] == 0) nav_validity = nullptr;
+    columns.push_back(arrow::MakeArray(arrow::ArrayData::Make(
+        options.value_type, num_rows, {nav_validity, nav_values}, null_counts[c])));
+    fields.push_back(Field(options.nav_names[c], options.value_type, options.nav_scales[c]));
+  }
+  return arrow::RecordBatch::Make(arrow::schema(fields), num_rows, columns);
+}
+
+}  // namespace fixed_point
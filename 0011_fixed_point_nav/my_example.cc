@@ -0,0 +1,178 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/csv/api.h>
+#include <arrow/io/api.h>
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "../fund_panel/fund_panel.h"
+#include "fixed_point_nav.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+// 按 0006_cal_sharpe_ratio/fund_nav.csv 的格式写出一个大文件：净值日期,单位净值,复权净值,涨跌幅
+arrow::Status GenNavCsv(const std::string& path, int num_funds, int num_days) {
+  FundPanelOptions panel_options;
+  panel_options.num_funds = num_funds;
+  panel_options.num_days = num_days;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  ARROW_ASSIGN_OR_RAISE(auto batch, panel->CombineChunksToBatch());
+  auto dates = std::static_pointer_cast<arrow::Date32Array>(batch->GetColumnByName("date"));
+  auto navs = std::static_pointer_cast<arrow::DoubleArray>(batch->GetColumnByName("nav"));
+  auto adj_navs = std::static_pointer_cast<arrow::DoubleArray>(batch->GetColumnByName("adj_nav"));
+  std::ofstream out(path);
+  out << "净值日期,单位净值,复权净值,涨跌幅\n";
+  char line[128];
+  for (int64_t i = 0; i < batch->num_rows(); ++i) {
+    // date32 转回 YYYY-MM-DD
+    int32_t z = dates->Value(i) + 719468;
+    const int era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const int y = static_cast<int>(yoe) + era * 400 + (m <= 2);
+    const double change =
+        i == 0 ? 0.0 : (adj_navs->Value(i) / adj_navs->Value(i - 1) - 1.0) * 100.0;
+    std::snprintf(line, sizeof(line), "%04d-%02u-%02u,%.4f,%.4f,%.2f%%\n", y, m, d,
+                  navs->Value(i), adj_navs->Value(i), change);
+    out << line;
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status RunMain() {
+  const std::string path = "fund_nav_large.csv";
+  ARROW_RETURN_NOT_OK(GenNavCsv(path, 2000, 1000));
+
+  // (文档部分: std::stod 解析)
+  // 和 cal_sharpe_ratio.cpp 一样逐行用 std::stod 解析
+  auto start_time = std::chrono::high_resolution_clock::now();
+  std::vector<double> stod_navs, stod_adj_navs;
+  {
+    std::ifstream file(path);
+    std::string line;
+    getline(file, line);
+    while (getline(file, line)) {
+      std::istringstream ss(line);
+      std::string date, nav_str, adj_nav_str;
+      getline(ss, date, ',');
+      getline(ss, nav_str, ',');
+      getline(ss, adj_nav_str, ',');
+      stod_navs.push_back(std::stod(nav_str));
+      stod_adj_navs.push_back(std::stod(adj_nav_str));
+    }
+  }
+  const double stod_ms = ElapsedMs(start_time);
+  // (文档部分: std::stod 解析)
+
+  // (文档部分: Arrow CSV 解析)
+  // Arrow 的 CSV 读取器，净值解析成 float64
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  ARROW_ASSIGN_OR_RAISE(
+      auto csv_reader,
+      arrow::csv::TableReader::Make(
+          arrow::io::default_io_context(), infile, arrow::csv::ReadOptions::Defaults(),
+          arrow::csv::ParseOptions::Defaults(), arrow::csv::ConvertOptions::Defaults()));
+  ARROW_ASSIGN_OR_RAISE(auto csv_table, csv_reader->Read());
+  const double arrow_ms = ElapsedMs(start_time);
+  // (文档部分: Arrow CSV 解析)
+
+  // (文档部分: 定点解析)
+  // 定点解析：读入整个文件，只用整数运算解析成 date32 + int32（scale = 4）
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(infile, arrow::io::ReadableFile::Open(path));
+  ARROW_ASSIGN_OR_RAISE(int64_t file_size, infile->GetSize());
+  ARROW_ASSIGN_OR_RAISE(auto contents, infile->Read(file_size));
+  fixed_point::NavCsvOptions csv_options;
+  ARROW_ASSIGN_OR_RAISE(auto fixed_batch, fixed_point::ParseNavCsv(*contents, csv_options));
+  const double fixed_ms = ElapsedMs(start_time);
+
+  std::cout << "parse " << fixed_batch->num_rows() << " rows: std::stod " << stod_ms
+            << " ms, arrow csv " << arrow_ms << " ms, fixed point " << fixed_ms << " ms"
+            << std::endl;
+  std::cout << "nav columns in memory: float64 "
+            << 2 * csv_table->num_rows() * sizeof(double) / (1 << 20) << " MB, int32 "
+            << 2 * fixed_batch->num_rows() * sizeof(int32_t) / (1 << 20) << " MB"
+            << std::endl;
+  std::cout << fixed_batch->schema()->ToString(/*show_metadata=*/true) << std::endl;
+
+  // 每列可以有自己的 scale，小数位多或者数值大时用 int64
+  fixed_point::NavCsvOptions wide_options;
+  wide_options.nav_scales = {4, 6};
+  wide_options.value_type = arrow::int64();
+  ARROW_ASSIGN_OR_RAISE(auto wide_batch, fixed_point::ParseNavCsv(*contents, wide_options));
+  std::cout << wide_batch->schema()->ToString(/*show_metadata=*/true) << std::endl;
+  // (文档部分: 定点解析)
+
+  // (文档部分: 收益率)
+  // 收益率：double 路径和定点路径的结果应该一致（跨基金的相邻行也算在内，只用来比较）
+  ARROW_ASSIGN_OR_RAISE(
+      auto adj_nav_column,
+      arrow::Concatenate(csv_table->GetColumnByName("复权净值")->chunks()));
+  auto adj_nav_double = std::static_pointer_cast<arrow::DoubleArray>(adj_nav_column);
+  auto adj_nav_fixed =
+      std::static_pointer_cast<arrow::Int32Array>(fixed_batch->GetColumnByName("adj_nav"));
+  const int64_t length = adj_nav_fixed->length();
+
+  // 两条路径都在计时内分配结果
+  start_time = std::chrono::high_resolution_clock::now();
+  std::vector<double> returns(length - 1);
+  const double* nav_values = adj_nav_double->raw_values();
+  for (int64_t i = 0; i + 1 < length; ++i) {
+    returns[i] = (nav_values[i + 1] - nav_values[i]) / nav_values[i];
+  }
+  const double double_returns_ms = ElapsedMs(start_time);
+  double double_sum = 0;
+  for (double r : returns) double_sum += r;
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto fixed_returns, fixed_point::Returns(*adj_nav_fixed));
+  const double fixed_returns_ms = ElapsedMs(start_time);
+  // 缺失的净值对应的收益率是 null，不计入合计
+  double fixed_sum = 0;
+  for (int64_t i = 0; i < fixed_returns->length(); ++i) {
+    if (fixed_returns->IsValid(i)) fixed_sum += fixed_returns->Value(i);
+  }
+  std::cout << "returns: float64 " << double_returns_ms << " ms, int32 " << fixed_returns_ms
+            << " ms, mean " << double_sum / (length - 1) << " vs " << fixed_sum / (length - 1)
+            << std::endl;
+  // (文档部分: 收益率)
+
+  // (文档部分: decimal128)
+  // 定点列可以直接变成 decimal128，用 Arrow 的 sum 得到精确的合计值
+  ARROW_ASSIGN_OR_RAISE(auto adj_nav_decimal,
+                        fixed_point::ToDecimal128<arrow::Int32Type>(*adj_nav_fixed, 9, 4));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum decimal_sum, arrow::compute::Sum(adj_nav_decimal));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum float_sum, arrow::compute::Sum(adj_nav_double));
+  std::cout << "sum of adj_nav: decimal128 " << decimal_sum.scalar()->ToString()
+            << ", float64 " << std::setprecision(17)
+            << float_sum.scalar_as<arrow::DoubleScalar>().value << std::endl;
+  // (文档部分: decimal128)
+
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
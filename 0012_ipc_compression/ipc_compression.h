@@ -0,0 +1,86 @@
+// IPC 文件的压缩读写。IPC 格式对每个 buffer 单独压缩（LZ4_FRAME 或 ZSTD），
+// 读取时自动解压，读端不需要知道写入时用了哪种编码。
+// use_threads 打开后，一个 record batch 的多个 buffer 并行压缩 / 解压。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <arrow/util/compression.h>
+
+#include <string>
+
+struct IpcCompressionOptions {
+  // UNCOMPRESSED、LZ4_FRAME 或 ZSTD（IPC 格式只支持这两种压缩）
+  arrow::Compression::type codec = arrow::Compression::UNCOMPRESSED;
+  // 压缩级别，默认值由编码决定（ZSTD 为 1，LZ4_FRAME 不区分级别）
+  int level = arrow::util::kUseDefaultCompressionLevel;
+  bool use_threads = true;
+  // 写入时每个 record batch 的最大行数
+  int64_t max_batch_rows = 64 * 1024;
+};
+
+// 从 "none"、"lz4"、"zstd" 这样的名字得到编码
+inline arrow::Result<arrow::Compression::type> ParseIpcCodec(const std::string& name) {
+  if (name == "none" || name == "uncompressed") return arrow::Compression::UNCOMPRESSED;
+  if (name == "lz4") return arrow::Compression::LZ4_FRAME;
+  return arrow::util::Codec::GetCompressionType(name);
+}
+
+inline std::string IpcCodecName(arrow::Compression::type codec) {
+  return codec == arrow::Compression::UNCOMPRESSED ? "none"
+                                                   : arrow::util::Codec::GetCodecAsString(codec);
+}
+
+inline arrow::Result<arrow::ipc::IpcWriteOptions> MakeIpcWriteOptions(
+    const IpcCompressionOptions& options) {
+  auto write_options = arrow::ipc::IpcWriteOptions::Defaults();
+  write_options.use_threads = options.use_threads;
+  if (options.codec == arrow::Compression::UNCOMPRESSED) return write_options;
+  if (options.codec != arrow::Compression::LZ4_FRAME &&
+      options.codec != arrow::Compression::ZSTD) {
+    return arrow::Status::Invalid("IPC only supports LZ4_FRAME and ZSTD compression, got ",
+                                  IpcCodecName(options.codec));
+  }
+  if (!arrow::util::Codec::IsAvailable(options.codec)) {
+    return arrow::Status::NotImplemented("Arrow was built without ",
+                                         IpcCodecName(options.codec), " support");
+  }
+  ARROW_ASSIGN_OR_RAISE(write_options.codec,
+                        arrow::util::Codec::Create(options.codec, options.level));
+  return write_options;
+}
+
+inline arrow::ipc::IpcReadOptions MakeIpcReadOptions(bool use_threads) {
+  auto read_options = arrow::ipc::IpcReadOptions::Defaults();
+  read_options.use_threads = use_threads;
+  return read_options;
+}
+
+// 把表写成 IPC 文件，返回文件大小
+inline arrow::Result<int64_t> WriteIpcFile(const std::string& path, const arrow::Table& table,
+                                           const IpcCompressionOptions& options) {
+  ARROW_ASSIGN_OR_RAISE(auto write_options, MakeIpcWriteOptions(options));
+  ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::FileOutputStream::Open(path));
+  ARROW_ASSIGN_OR_RAISE(auto writer,
+                        arrow::ipc::MakeFileWriter(outfile, table.schema(), write_options));
+  ARROW_RETURN_NOT_OK(writer->WriteTable(table, options.max_batch_rows));
+  ARROW_RETURN_NOT_OK(writer->Close());
+  ARROW_ASSIGN_OR_RAISE(int64_t size, outfile->Tell());
+  ARROW_RETURN_NOT_OK(outfile->Close());
+  return size;
+}
+
+// 读取整个 IPC 文件，压缩的 buffer 在这里解压
+inline arrow::Result<std::shared_ptr<arrow::Table>> ReadIpcFile(const std::string& path,
+                                                                bool use_threads = true) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(
+                                         infile, MakeIpcReadOptions(use_threads)));
+  arrow::RecordBatchVector batches;
+  for (int i = 0; i < reader->num_record_batches(); ++i) {
+    ARROW_ASSIGN_OR_RAISE(auto batch, reader->ReadRecordBatch(i));
+    batches.push_back(std::move(batch));
+  }
+  return arrow::Table::FromRecordBatches(reader->schema(), batches);
+}
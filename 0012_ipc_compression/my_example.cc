@@ -0,0 +1,110 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/util/byte_size.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "../fund_panel/fund_panel.h"
+#include "ipc_compression.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+struct Case {
+  arrow::Compression::type codec;
+  int level;
+};
+
+// 一个面板按一种编码写入、读回，打印写入吞吐、读取吞吐和文件大小。
+// 吞吐按未压缩的内存大小计算，读取时文件已经在 page cache 里，衡量的是解压的开销。
+arrow::Status RunCase(const std::string& layout, const arrow::Table& panel, const Case& c,
+                      bool use_threads) {
+  const double raw_mb = arrow::util::TotalBufferSize(panel) / double(1 << 20);
+  IpcCompressionOptions options;
+  options.codec = c.codec;
+  options.level = c.level;
+  options.use_threads = use_threads;
+  const std::string path = "panel_" + IpcCodecName(c.codec) + ".arrow";
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(int64_t file_size, WriteIpcFile(path, panel, options));
+  const double write_ms = ElapsedMs(start_time);
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto table, ReadIpcFile(path, use_threads));
+  const double read_ms = ElapsedMs(start_time);
+  if (!table->Equals(panel)) {
+    return arrow::Status::Invalid("round trip mismatch for ", IpcCodecName(c.codec));
+  }
+
+  std::cout << std::left << std::setw(12) << layout << std::setw(12) << IpcCodecName(c.codec)
+            << std::setw(8)
+            << (c.level == arrow::util::kUseDefaultCompressionLevel ? std::string("-")
+                                                                     : std::to_string(c.level))
+            << std::setw(10) << (use_threads ? "yes" : "no") << std::right << std::fixed
+            << std::setprecision(1) << std::setw(10) << file_size / double(1 << 20)
+            << std::setw(8) << std::setprecision(2) << raw_mb * (1 << 20) / file_size
+            << std::setprecision(0) << std::setw(12) << raw_mb / write_ms * 1000
+            << std::setw(12) << raw_mb / read_ms * 1000 << std::defaultfloat << std::endl;
+  return arrow::Status::OK();
+}
+
+arrow::Status RunMain() {
+  // (文档部分: 生成面板)
+  // 2000 只基金 × 1500 个交易日，按基金排序和按日期排序各一份，压缩率会差很多
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 2000;
+  panel_options.num_days = 1500;
+  panel_options.null_probability = 0.01;
+  ARROW_ASSIGN_OR_RAISE(auto fund_major, MakeFundPanel(panel_options));
+  panel_options.date_major = true;
+  ARROW_ASSIGN_OR_RAISE(auto date_major, MakeFundPanel(panel_options));
+  std::cout << "rows: " << fund_major->num_rows() << ", in memory: "
+            << arrow::util::TotalBufferSize(*fund_major) / (1 << 20) << " MB" << std::endl;
+  // (文档部分: 生成面板)
+
+  // (文档部分: 基准矩阵)
+  const int default_level = arrow::util::kUseDefaultCompressionLevel;
+  std::vector<Case> cases = {{arrow::Compression::UNCOMPRESSED, default_level},
+                             {arrow::Compression::LZ4_FRAME, default_level},
+                             {arrow::Compression::ZSTD, 1},
+                             {arrow::Compression::ZSTD, 3},
+                             {arrow::Compression::ZSTD, 9}};
+  std::cout << std::left << std::setw(12) << "layout" << std::setw(12) << "codec"
+            << std::setw(8) << "level" << std::setw(10) << "threads" << std::right
+            << std::setw(10) << "size MB" << std::setw(8) << "ratio" << std::setw(12)
+            << "write MB/s" << std::setw(12) << "read MB/s" << std::endl;
+  for (const auto& [layout, panel] :
+       {std::make_pair("fund major", fund_major), std::make_pair("date major", date_major)}) {
+    for (const Case& c : cases) {
+      if (c.codec != arrow::Compression::UNCOMPRESSED &&
+          !arrow::util::Codec::IsAvailable(c.codec)) {
+        std::cout << IpcCodecName(c.codec) << " is not available in this Arrow build"
+                  << std::endl;
+        continue;
+      }
+      for (bool use_threads : {false, true}) {
+        ARROW_RETURN_NOT_OK(RunCase(layout, *panel, c, use_threads));
+      }
+    }
+  }
+  // (文档部分: 基准矩阵)
+
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
@@ -0,0 +1,121 @@
+// 用内存映射加载 IPC 快照：record batch 的 buffer 直接指向映射区域，不复制到堆上。
+// 打开时可以用 madvise(WILLNEED) 让内核提前把文件读进 page cache，
+// 支持的内核上再用 madvise(HUGEPAGE) 申请透明大页，减少缺页中断和 TLB 开销。
+// 注意：压缩过的 IPC 文件（见 0012_ipc_compression）读取时必须解压，做不到零拷贝。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+struct SnapshotOptions {
+  // 打开时提示内核预读整个文件
+  bool will_need = true;
+  // 尝试使用透明大页（只读文件映射需要内核支持 CONFIG_READ_ONLY_THP_FOR_FS）
+  bool huge_pages = true;
+};
+
+class MmapSnapshot {
+ public:
+  static arrow::Result<std::shared_ptr<MmapSnapshot>> Open(
+      const std::string& path, const SnapshotOptions& options = SnapshotOptions()) {
+    auto snapshot = std::shared_ptr<MmapSnapshot>(new MmapSnapshot());
+    ARROW_ASSIGN_OR_RAISE(snapshot->file_,
+                          arrow::io::MemoryMappedFile::Open(path, arrow::io::FileMode::READ));
+    ARROW_ASSIGN_OR_RAISE(int64_t size, snapshot->file_->GetSize());
+    // ReadAt 返回的是映射区域的切片，由此得到映射的起始地址
+    ARROW_ASSIGN_OR_RAISE(snapshot->mapping_, snapshot->file_->ReadAt(0, size));
+    if (options.huge_pages) {
+      snapshot->huge_pages_ = snapshot->Advise(MADV_HUGEPAGE);
+    }
+    if (options.will_need) {
+      ARROW_RETURN_NOT_OK(snapshot->file_->WillNeed({{0, size}}));
+    }
+    ARROW_ASSIGN_OR_RAISE(snapshot->reader_,
+                          arrow::ipc::RecordBatchFileReader::Open(snapshot->file_));
+    return snapshot;
+  }
+
+  std::shared_ptr<arrow::Schema> schema() const { return reader_->schema(); }
+  int num_record_batches() const { return reader_->num_record_batches(); }
+  int64_t size() const { return mapping_->size(); }
+  // madvise(HUGEPAGE) 是否成功
+  bool huge_pages() const { return huge_pages_; }
+
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> ReadRecordBatch(int i) const {
+    return reader_->ReadRecordBatch(i);
+  }
+
+  arrow::Result<std::shared_ptr<arrow::Table>> ReadTable() const {
+    arrow::RecordBatchVector batches;
+    for (int i = 0; i < num_record_batches(); ++i) {
+      ARROW_ASSIGN_OR_RAISE(auto batch, ReadRecordBatch(i));
+      batches.push_back(std::move(batch));
+    }
+    return arrow::Table::FromRecordBatches(schema(), batches);
+  }
+
+  // 检查 batch 的所有 buffer 是否都在映射区域内（即零拷贝）
+  bool IsZeroCopy(const arrow::RecordBatch& batch) const {
+    for (const auto& column : batch.columns()) {
+      if (!IsZeroCopy(*column->data())) return false;
+    }
+    return true;
+  }
+
+ private:
+  MmapSnapshot() = default;
+
+  bool IsZeroCopy(const arrow::ArrayData& data) const {
+    const uint8_t* begin = mapping_->data();
+    const uint8_t* end = begin + mapping_->size();
+    for (const auto& buffer : data.buffers) {
+      if (buffer == nullptr || buffer->size() == 0) continue;
+      if (buffer->data() < begin || buffer->data() + buffer->size() > end) return false;
+    }
+    for (const auto& child : data.child_data) {
+      if (!IsZeroCopy(*child)) return false;
+    }
+    return data.dictionary == nullptr || IsZeroCopy(*data.dictionary);
+  }
+
+  // madvise 要求起始地址按页对齐，映射本身是页对齐的
+  bool Advise(int advice) const {
+    const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t address = reinterpret_cast<uintptr_t>(mapping_->data());
+    const uintptr_t aligned = address & ~(page_size - 1);
+    return madvise(reinterpret_cast<void*>(aligned), mapping_->size() + (address - aligned),
+                   advice) == 0;
+  }
+
+  std::shared_ptr<arrow::io::MemoryMappedFile> file_;
+  std::shared_ptr<arrow::Buffer> mapping_;
+  std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader_;
+  bool huge_pages_ = false;
+};
+
+// 当前进程的常驻内存，单位 KB。RssAnon 是堆等匿名内存，RssFile 是映射文件占用的 page cache。
+struct ResidentMemory {
+  int64_t rss_kb = 0;
+  int64_t anon_kb = 0;
+  int64_t file_kb = 0;
+};
+
+inline ResidentMemory ReadResidentMemory() {
+  ResidentMemory memory;
+  std::ifstream status("/proc/self/status");
+  std::string key;
+  int64_t value;
+  while (status >> key) {
+    if (key == "VmRSS:" && status >> value) memory.rss_kb = value;
+    if (key == "RssAnon:" && status >> value) memory.anon_kb = value;
+    if (key == "RssFile:" && status >> value) memory.file_kb = value;
+  }
+  return memory;
+}
@@ -0,0 +1,140 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/metadata.h>
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+#include "../fund_panel/fund_panel.h"
+#include "nav_writer_properties.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+arrow::Result<std::shared_ptr<arrow::Table>> ReadParquet(const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  ARROW_ASSIGN_OR_RAISE(auto reader,
+                        parquet::arrow::OpenFile(infile, arrow::default_memory_pool()));
+  reader->set_use_threads(true);
+  return reader->ReadTable();
+}
+
+// 默认的写入配置，只指定 row group 的行数
+arrow::Status WriteDefaultParquet(const arrow::Table& table, const std::string& path,
+                                  int64_t row_group_rows) {
+  ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::FileOutputStream::Open(path));
+  ARROW_RETURN_NOT_OK(parquet::arrow::WriteTable(table, arrow::default_memory_pool(), outfile,
+                                                 row_group_rows));
+  return outfile->Close();
+}
+
+// 写入一个文件并读回，打印文件大小、写入和读取耗时
+arrow::Status RunCase(const std::string& name, const arrow::Table& panel,
+                      const std::string& path,
+                      const std::function<arrow::Status()>& write) {
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_RETURN_NOT_OK(write());
+  const double write_ms = ElapsedMs(start_time);
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto table, ReadParquet(path));
+  const double read_ms = ElapsedMs(start_time);
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  ARROW_ASSIGN_OR_RAISE(int64_t size, infile->GetSize());
+  if (table->num_rows() != panel.num_rows()) {
+    return arrow::Status::Invalid(name, ": read back ", table->num_rows(), " rows");
+  }
+  std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+            << std::setprecision(1) << std::setw(10) << size / double(1 << 20)
+            << std::setprecision(0) << std::setw(12) << write_ms << std::setw(12) << read_ms
+            << std::defaultfloat << std::endl;
+  return arrow::Status::OK();
+}
+
+// 打印第一个 row group 每一列用到的编码，以及是否写了 page index
+arrow::Status PrintLayout(const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  auto metadata = parquet::ReadMetaData(infile);
+  std::cout << path << ": " << metadata->num_row_groups() << " row groups" << std::endl;
+  auto row_group = metadata->RowGroup(0);
+  for (int i = 0; i < row_group->num_columns(); ++i) {
+    auto column = row_group->ColumnChunk(i);
+    std::cout << "  " << std::setw(10) << metadata->schema()->Column(i)->name() << ":";
+    for (auto encoding : column->encodings()) {
+      std::cout << " " << parquet::EncodingToString(encoding);
+    }
+    std::cout << (column->GetColumnIndexLocation().has_value() ? ", page index" : "")
+              << ", " << column->total_compressed_size() / 1024 << " KB" << std::endl;
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status RunMain() {
+  // (文档部分: 生成面板)
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 3000;
+  panel_options.num_days = 1500;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  std::cout << "rows: " << panel->num_rows() << std::endl;
+  // (文档部分: 生成面板)
+
+  // (文档部分: 对比)
+  std::cout << std::left << std::setw(28) << "profile" << std::right << std::setw(10)
+            << "size MB" << std::setw(12) << "write ms" << std::setw(12) << "read ms"
+            << std::endl;
+
+  // 默认配置，和 0004_datasets 一样每 2048 行一个 row group
+  ARROW_RETURN_NOT_OK(RunCase("default, 2048 rows/group", *panel, "default_2048.parquet", [&] {
+    return WriteDefaultParquet(*panel, "default_2048.parquet", 2048);
+  }));
+  // 默认编码，只把 row group 调大
+  ARROW_RETURN_NOT_OK(RunCase("default, 1M rows/group", *panel, "default_1m.parquet", [&] {
+    return WriteDefaultParquet(*panel, "default_1m.parquet", 1 << 20);
+  }));
+
+  // 净值配置，分别用 SNAPPY 和默认的压缩（有 ZSTD 时是 ZSTD，见 DefaultNavCompression）
+  if (arrow::util::Codec::IsAvailable(arrow::Compression::SNAPPY)) {
+    NavParquetOptions snappy;
+    snappy.compression = arrow::Compression::SNAPPY;
+    ARROW_RETURN_NOT_OK(RunCase("nav profile, snappy", *panel, "nav_snappy.parquet", [&] {
+      return WriteNavParquet(*panel, "nav_snappy.parquet", snappy);
+    }));
+  }
+  const std::string codec = arrow::util::Codec::GetCodecAsString(DefaultNavCompression());
+  ARROW_RETURN_NOT_OK(RunCase("nav profile, " + codec, *panel, "nav_profile.parquet", [&] {
+    return WriteNavParquet(*panel, "nav_profile.parquet");
+  }));
+  // 净值列改用 BYTE_STREAM_SPLIT
+  NavParquetOptions byte_stream_split;
+  byte_stream_split.byte_stream_split_doubles = true;
+  ARROW_RETURN_NOT_OK(RunCase("nav profile, " + codec + " + bss", *panel, "nav_bss.parquet", [&] {
+    return WriteNavParquet(*panel, "nav_bss.parquet", byte_stream_split);
+  }));
+  // (文档部分: 对比)
+
+  // (文档部分: 文件布局)
+  ARROW_RETURN_NOT_OK(PrintLayout("default_1m.parquet"));
+  ARROW_RETURN_NOT_OK(PrintLayout("nav_profile.parquet"));
+  ARROW_RETURN_NOT_OK(PrintLayout("nav_bss.parquet"));
+  // (文档部分: 文件布局)
+
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
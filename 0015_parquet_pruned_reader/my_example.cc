@@ -0,0 +1,97 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/reader.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "../0014_parquet_nav_writer/nav_writer_properties.h"
+#include "../fund_panel/fund_panel.h"
+#include "nav_reader.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+// 和 0002_io 一样：打开文件，单线程读入所有列、所有 row group
+arrow::Result<std::shared_ptr<arrow::Table>> ReadEverything(const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  ARROW_ASSIGN_OR_RAISE(auto reader,
+                        parquet::arrow::OpenFile(infile, arrow::default_memory_pool()));
+  return reader->ReadTable();
+}
+
+void PrintStats(const std::string& name, double ms, const NavReadStats& stats) {
+  std::cout << name << ": " << ms << " ms, rows " << stats.rows_returned << " (decoded "
+            << stats.rows_decoded << "), row groups " << stats.row_groups_read << "/"
+            << stats.row_groups << std::endl;
+  std::cout << "  bytes read " << stats.bytes_read / 1024 << " KB, skipped: columns "
+            << stats.bytes_skipped_columns / 1024 << " KB, row groups "
+            << stats.bytes_skipped_row_groups / 1024 << " KB; pages outside range "
+            << stats.bytes_outside_pages / 1024 << " KB" << std::endl;
+}
+
+arrow::Status RunQueries(const std::string& path, int32_t first_day, int32_t last_day) {
+  std::cout << "== " << path << std::endl;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto everything, ReadEverything(path));
+  std::cout << "read everything: " << ElapsedMs(start_time) << " ms, rows "
+            << everything->num_rows() << std::endl;
+
+  // 最近 60 个交易日的复权净值
+  NavReadOptions options;
+  options.columns = {"fund_code", "adj_nav"};
+  options.min_date = first_day;
+  options.max_date = last_day;
+  NavReadStats stats;
+  for (bool pruning : {false, true}) {
+    options.use_statistics = pruning;
+    options.use_page_index = pruning;
+    start_time = std::chrono::high_resolution_clock::now();
+    ARROW_ASSIGN_OR_RAISE(auto table, ReadNavParquet(path, options, &stats));
+    PrintStats(pruning ? "columns + statistics + page index" : "columns only",
+               ElapsedMs(start_time), stats);
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status RunMain() {
+  // (文档部分: 生成文件)
+  // 同一份数据写两份：按日期排序（每天追加的数据就是这样）和按基金排序。
+  // 用 0014 的写入配置，row group 设成 256K 行，page 最多 20000 行
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 3000;
+  panel_options.num_days = 1500;
+  NavParquetOptions write_options;
+  write_options.row_group_rows = 256 * 1024;
+  panel_options.date_major = true;
+  ARROW_ASSIGN_OR_RAISE(auto date_major, MakeFundPanel(panel_options));
+  ARROW_RETURN_NOT_OK(WriteNavParquet(*date_major, "date_major.parquet", write_options));
+  panel_options.date_major = false;
+  ARROW_ASSIGN_OR_RAISE(auto fund_major, MakeFundPanel(panel_options));
+  ARROW_RETURN_NOT_OK(WriteNavParquet(*fund_major, "fund_major.parquet", write_options));
+  // (文档部分: 生成文件)
+
+  // (文档部分: 查询)
+  const int32_t first_day = TradingDay(panel_options.start_date, panel_options.num_days - 60);
+  const int32_t last_day = TradingDay(panel_options.start_date, panel_options.num_days - 1);
+  ARROW_RETURN_NOT_OK(RunQueries("date_major.parquet", first_day, last_day));
+  ARROW_RETURN_NOT_OK(RunQueries("fund_major.parquet", first_day, last_day));
+  // (文档部分: 查询)
+
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
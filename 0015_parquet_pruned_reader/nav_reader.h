@@ -0,0 +1,233 @@
+// 带列裁剪和日期范围过滤的 Parquet 读取：
+//   1. 只读请求的列（以及过滤需要的日期列）；
+//   2. 用 row group 的 min/max 统计信息跳过整个不相交的 row group；
+//   3. 对剩下的 row group，用日期列的 page index（ColumnIndex + OffsetIndex）找出可能命中的行范围，
+//      解码后先按行范围切片，再做精确过滤；
+//   4. ArrowReaderProperties 打开 use_threads（各列并行解码）和 pre_buffer（合并 IO 请求，提前读入）。
+// parquet::arrow::FileReader 只能按 row group 读取，page 级别的信息目前只用来缩小过滤范围，
+// 以及统计“支持按页读取时还能少读多少字节”。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/page_index.h>
+#include <parquet/statistics.h>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct NavReadOptions {
+  // 要读的列，空表示全部
+  std::vector<std::string> columns;
+  // 日期范围 [min_date, max_date]，date32 表示，闭区间
+  int32_t min_date = std::numeric_limits<int32_t>::min();
+  int32_t max_date = std::numeric_limits<int32_t>::max();
+  std::string date_column = "date";
+  bool use_statistics = true;
+  bool use_page_index = true;
+  bool use_threads = true;
+  bool pre_buffer = true;
+};
+
+struct NavReadStats {
+  int row_groups = 0;
+  int row_groups_read = 0;
+  // 按列块的压缩大小统计
+  int64_t bytes_read = 0;
+  int64_t bytes_skipped_columns = 0;
+  int64_t bytes_skipped_row_groups = 0;
+  // 已读的列块中，落在日期范围之外的 page 的大小（按页读取时可以省掉的部分）
+  int64_t bytes_outside_pages = 0;
+  int64_t rows_decoded = 0;
+  int64_t rows_returned = 0;
+};
+
+namespace nav_reader_internal {
+
+// 日期列 [min, max] 与查询范围是否相交；没有统计信息时保守地认为相交
+inline bool MayMatch(const parquet::ColumnChunkMetaData& column,
+                     const NavReadOptions& options) {
+  auto statistics = column.statistics();
+  if (statistics == nullptr || !statistics->HasMinMax()) return true;
+  auto typed = std::static_pointer_cast<parquet::Int32Statistics>(statistics);
+  return typed->max() >= options.min_date && typed->min() <= options.max_date;
+}
+
+// 根据 page index 得到 row group 中可能命中的行范围 [begin, end)，相邻的范围合并
+inline std::vector<std::pair<int64_t, int64_t>> MatchingRows(
+    const parquet::Int32ColumnIndex& column_index, const parquet::OffsetIndex& offset_index,
+    int64_t num_rows, const NavReadOptions& options) {
+  std::vector<std::pair<int64_t, int64_t>> ranges;
+  const auto& pages = offset_index.page_locations();
+  for (size_t p = 0; p < pages.size(); ++p) {
+    if (column_index.null_pages()[p]) continue;
+    if (column_index.max_values()[p] < options.min_date ||
+        column_index.min_values()[p] > options.max_date) {
+      continue;
+    }
+    const int64_t begin = pages[p].first_row_index;
+    const int64_t end = p + 1 < pages.size() ? pages[p + 1].first_row_index : num_rows;
+    if (!ranges.empty() && ranges.back().second == begin) {
+      ranges.back().second = end;
+    } else {
+      ranges.emplace_back(begin, end);
+    }
+  }
+  return ranges;
+}
+
+// 一列中完全落在行范围之外的 page 的字节数
+inline int64_t BytesOutside(const parquet::OffsetIndex& offset_index, int64_t num_rows,
+                            const std::vector<std::pair<int64_t, int64_t>>& ranges) {
+  int64_t bytes = 0;
+  const auto& pages = offset_index.page_locations();
+  for (size_t p = 0; p < pages.size(); ++p) {
+    const int64_t begin = pages[p].first_row_index;
+    const int64_t end = p + 1 < pages.size() ? pages[p + 1].first_row_index : num_rows;
+    bool overlaps = false;
+    for (const auto& range : ranges) {
+      overlaps |= range.first < end && begin < range.second;
+    }
+    if (!overlaps) bytes += pages[p].compressed_page_size;
+  }
+  return bytes;
+}
+
+}  // namespace nav_reader_internal
+
+inline arrow::Result<std::shared_ptr<arrow::Table>> ReadNavParquet(
+    const std::string& path, const NavReadOptions& options, NavReadStats* stats = nullptr) {
+  NavReadStats local_stats;
+  if (stats == nullptr) stats = &local_stats;
+  *stats = NavReadStats();
+
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  parquet::ArrowReaderProperties arrow_properties;
+  arrow_properties.set_use_threads(options.use_threads);
+  arrow_properties.set_pre_buffer(options.pre_buffer);
+  parquet::arrow::FileReaderBuilder builder;
+  ARROW_RETURN_NOT_OK(builder.Open(infile));
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  ARROW_RETURN_NOT_OK(builder.properties(arrow_properties)->Build(&reader));
+
+  auto metadata = reader->parquet_reader()->metadata();
+  const parquet::SchemaDescriptor* schema = metadata->schema();
+  const int date_index = schema->ColumnIndex(options.date_column);
+  if (date_index < 0) {
+    return arrow::Status::KeyError("no date column '", options.date_column, "'");
+  }
+  if (schema->Column(date_index)->physical_type() != parquet::Type::INT32) {
+    return arrow::Status::TypeError("date column must be stored as INT32 (date32)");
+  }
+
+  // 要读的列，日期列不在其中时额外读入，过滤后再去掉
+  std::vector<int> column_indices;
+  if (options.columns.empty()) {
+    for (int i = 0; i < schema->num_columns(); ++i) column_indices.push_back(i);
+  } else {
+    for (const auto& name : options.columns) {
+      const int index = schema->ColumnIndex(name);
+      if (index < 0) return arrow::Status::KeyError("no column '", name, "'");
+      column_indices.push_back(index);
+    }
+  }
+  const bool extra_date = std::find(column_indices.begin(), column_indices.end(),
+                                    date_index) == column_indices.end();
+  if (extra_date) column_indices.push_back(date_index);
+  std::sort(column_indices.begin(), column_indices.end());
+  auto is_selected = [&](int i) {
+    return std::binary_search(column_indices.begin(), column_indices.end(), i);
+  };
+
+  // (1) row group 裁剪
+  std::vector<int> row_groups;
+  stats->row_groups = metadata->num_row_groups();
+  for (int rg = 0; rg < metadata->num_row_groups(); ++rg) {
+    auto row_group = metadata->RowGroup(rg);
+    const bool keep = !options.use_statistics ||
+                      nav_reader_internal::MayMatch(*row_group->ColumnChunk(date_index), options);
+    for (int i = 0; i < row_group->num_columns(); ++i) {
+      const int64_t size = row_group->ColumnChunk(i)->total_compressed_size();
+      if (!keep) {
+        stats->bytes_skipped_row_groups += size;
+      } else if (is_selected(i)) {
+        stats->bytes_read += size;
+      } else {
+        stats->bytes_skipped_columns += size;
+      }
+    }
+    if (keep) row_groups.push_back(rg);
+  }
+  stats->row_groups_read = static_cast<int>(row_groups.size());
+
+  // (2) page index：每个 row group 中可能命中的行范围
+  std::vector<std::vector<std::pair<int64_t, int64_t>>> row_ranges(row_groups.size());
+  auto page_index_reader =
+      options.use_page_index ? reader->parquet_reader()->GetPageIndexReader() : nullptr;
+  for (size_t k = 0; k < row_groups.size(); ++k) {
+    const int64_t num_rows = metadata->RowGroup(row_groups[k])->num_rows();
+    row_ranges[k] = {{0, num_rows}};
+    if (page_index_reader == nullptr) continue;
+    auto row_group_index = page_index_reader->RowGroup(row_groups[k]);
+    if (row_group_index == nullptr) continue;
+    auto column_index = std::dynamic_pointer_cast<parquet::Int32ColumnIndex>(
+        row_group_index->GetColumnIndex(date_index));
+    auto offset_index = row_group_index->GetOffsetIndex(date_index);
+    if (column_index == nullptr || offset_index == nullptr) continue;
+    row_ranges[k] =
+        nav_reader_internal::MatchingRows(*column_index, *offset_index, num_rows, options);
+    for (int i : column_indices) {
+      auto column_offsets = row_group_index->GetOffsetIndex(i);
+      if (column_offsets == nullptr) continue;
+      stats->bytes_outside_pages +=
+          nav_reader_internal::BytesOutside(*column_offsets, num_rows, row_ranges[k]);
+    }
+  }
+
+  // (3) 一次读入剩下的所有 row group，pre_buffer 可以合并相邻列块的 IO，各列并行解码。
+  // 结果按 row group 顺序排列，再按 page index 得到的行范围切片。
+  ARROW_ASSIGN_OR_RAISE(auto table, reader->ReadRowGroups(row_groups, column_indices));
+  stats->rows_decoded = table->num_rows();
+  if (options.use_page_index) {
+    std::vector<std::shared_ptr<arrow::Table>> pieces;
+    int64_t offset = 0;
+    for (size_t k = 0; k < row_groups.size(); ++k) {
+      for (const auto& range : row_ranges[k]) {
+        pieces.push_back(table->Slice(offset + range.first, range.second - range.first));
+      }
+      offset += metadata->RowGroup(row_groups[k])->num_rows();
+    }
+    if (!pieces.empty()) {
+      ARROW_ASSIGN_OR_RAISE(table, arrow::ConcatenateTables(pieces));
+    } else {
+      table = table->Slice(0, 0);
+    }
+  }
+
+  // (4) 精确过滤
+  auto date = table->GetColumnByName(options.date_column);
+  ARROW_ASSIGN_OR_RAISE(
+      arrow::Datum lower,
+      arrow::compute::CallFunction(
+          "greater_equal", {date, std::make_shared<arrow::Date32Scalar>(options.min_date)}));
+  ARROW_ASSIGN_OR_RAISE(
+      arrow::Datum upper,
+      arrow::compute::CallFunction(
+          "less_equal", {date, std::make_shared<arrow::Date32Scalar>(options.max_date)}));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum mask, arrow::compute::And(lower, upper));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum filtered, arrow::compute::Filter(table, mask));
+  table = filtered.table();
+  if (extra_date) {
+    const int field_index = table->schema()->GetFieldIndex(options.date_column);
+    ARROW_ASSIGN_OR_RAISE(table, table->RemoveColumn(field_index));
+  }
+  stats->rows_returned = table->num_rows();
+  return table;
+}
@@ -0,0 +1,156 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <fcntl.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+
+#include "../fund_panel/fund_panel.h"
+#include "prefetch_scanner.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+// 把文件从 page cache 中清掉，模拟冷启动
+void DropPageCache(const std::vector<std::string>& paths) {
+  for (const auto& path : paths) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) continue;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+// 每只基金写一个 Parquet 文件和一个 IPC 文件
+arrow::Status WriteFundFiles(const std::string& dir, std::vector<std::string>* parquet_paths,
+                             std::vector<std::string>* ipc_paths) {
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 2000;
+  panel_options.num_days = 1500;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  std::filesystem::create_directories(dir);
+  for (int fund = 0; fund < panel_options.num_funds; ++fund) {
+    auto table = panel->Slice(static_cast<int64_t>(fund) * panel_options.num_days,
+                              panel_options.num_days);
+    const std::string base = dir + "/" + FundCode(fund);
+    ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::FileOutputStream::Open(base + ".parquet"));
+    ARROW_RETURN_NOT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(),
+                                                   outfile, panel_options.num_days));
+    ARROW_RETURN_NOT_OK(outfile->Close());
+    ARROW_ASSIGN_OR_RAISE(outfile, arrow::io::FileOutputStream::Open(base + ".arrow"));
+    ARROW_ASSIGN_OR_RAISE(auto writer, arrow::ipc::MakeFileWriter(outfile, table->schema()));
+    ARROW_RETURN_NOT_OK(writer->WriteTable(*table));
+    ARROW_RETURN_NOT_OK(writer->Close());
+    parquet_paths->push_back(base + ".parquet");
+    ipc_paths->push_back(base + ".arrow");
+  }
+  return arrow::Status::OK();
+}
+
+// 每个文件上的计算：和 0006_cal_sharpe_ratio 一样用复权净值计算夏普比率
+arrow::Result<double> SharpeRatio(const std::shared_ptr<arrow::Table>& table) {
+  auto adj_nav = table->GetColumnByName("adj_nav");
+  auto now_nav = adj_nav->Slice(1, adj_nav->length() - 1);
+  auto pre_nav = adj_nav->Slice(0, adj_nav->length() - 1);
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum diff,
+                        arrow::compute::CallFunction("subtract", {now_nav, pre_nav}));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum returns,
+                        arrow::compute::CallFunction("divide", {diff, pre_nav}));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum mean, arrow::compute::Mean(returns));
+  arrow::compute::VarianceOptions variance_options;
+  variance_options.ddof = 1;
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum stddev, arrow::compute::Stddev(returns, variance_options));
+  return mean.scalar_as<arrow::DoubleScalar>().value /
+         stddev.scalar_as<arrow::DoubleScalar>().value * std::sqrt(252.0);
+}
+
+// 逐个文件打开、读取、计算，读取时磁盘以外的部分都在等待
+arrow::Result<std::shared_ptr<arrow::Table>> ReadOne(const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  std::shared_ptr<arrow::Table> table;
+  if (prefetch_internal::IsParquet(path)) {
+    ARROW_ASSIGN_OR_RAISE(auto reader,
+                          parquet::arrow::OpenFile(infile, arrow::default_memory_pool()));
+    ARROW_ASSIGN_OR_RAISE(table, reader->ReadTable());
+  } else {
+    ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(infile));
+    arrow::RecordBatchVector batches;
+    for (int i = 0; i < reader->num_record_batches(); ++i) {
+      ARROW_ASSIGN_OR_RAISE(auto batch, reader->ReadRecordBatch(i));
+      batches.push_back(batch);
+    }
+    ARROW_ASSIGN_OR_RAISE(table, arrow::Table::FromRecordBatches(reader->schema(), batches));
+  }
+  return table;
+}
+
+arrow::Status RunFormat(const std::string& format, const std::vector<std::string>& paths) {
+  // (文档部分: 顺序读取)
+  DropPageCache(paths);
+  auto start_time = std::chrono::high_resolution_clock::now();
+  double total = 0;
+  for (const auto& path : paths) {
+    ARROW_ASSIGN_OR_RAISE(auto table, ReadOne(path));
+    ARROW_ASSIGN_OR_RAISE(double sharpe, SharpeRatio(table));
+    total += sharpe;
+  }
+  const double sequential_ms = ElapsedMs(start_time);
+  std::cout << format << " sequential: " << sequential_ms << " ms, mean sharpe "
+            << total / paths.size() << std::endl;
+  // (文档部分: 顺序读取)
+
+  // (文档部分: 预读)
+  for (int readahead : {1, 4, 16, 64}) {
+    DropPageCache(paths);
+    PrefetchOptions options;
+    options.readahead = readahead;
+    start_time = std::chrono::high_resolution_clock::now();
+    total = 0;
+    ARROW_RETURN_NOT_OK(ScanFiles(
+        paths, options,
+        [&](const std::string&, const std::shared_ptr<arrow::Table>& table) -> arrow::Status {
+          ARROW_ASSIGN_OR_RAISE(double sharpe, SharpeRatio(table));
+          total += sharpe;
+          return arrow::Status::OK();
+        }));
+    const double ms = ElapsedMs(start_time);
+    std::cout << format << " readahead " << readahead << ": " << ms << " ms (x"
+              << sequential_ms / ms << "), mean sharpe " << total / paths.size() << std::endl;
+  }
+  // (文档部分: 预读)
+  return arrow::Status::OK();
+}
+
+arrow::Status RunMain() {
+  std::vector<std::string> parquet_paths, ipc_paths;
+  ARROW_RETURN_NOT_OK(WriteFundFiles("funds", &parquet_paths, &ipc_paths));
+  std::cout << "files per format: " << parquet_paths.size() << ", io threads: "
+            << arrow::io::GetIOThreadPoolCapacity()
+            << ", cpu threads: " << arrow::GetCpuThreadPoolCapacity() << std::endl;
+  ARROW_RETURN_NOT_OK(RunFormat("parquet", parquet_paths));
+  ARROW_RETURN_NOT_OK(RunFormat("ipc", ipc_paths));
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
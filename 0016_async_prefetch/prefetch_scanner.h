@@ -0,0 +1,144 @@
+// 扫描大量小文件（例如每只基金一个 Parquet / IPC 文件）时，边计算边预读后面的文件。
+// 每个文件分两个阶段：
+//   IO 阶段（IO 线程池）：打开文件、读 footer，然后把需要的字节范围一次性读进内存。
+//     Parquet 用 ParquetFileReader::PreBuffer，内部的 ReadRangeCache 会把相邻的列块合并成少量大的读取；
+//     IPC 文件直接整个读入（对小文件来说就是一次读取）。
+//   解码阶段（CPU 线程池）：从内存中的数据解码出 Table。
+// 最多有 readahead 个文件同时在途，结果按文件顺序交给 visitor，visitor 在调用线程上执行计算。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/io/caching.h>
+#include <arrow/ipc/api.h>
+#include <arrow/util/future.h>
+#include <arrow/util/thread_pool.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/file_reader.h>
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct PrefetchOptions {
+  // 同时在途（正在读取或已读完等待计算）的文件数，1 表示只重叠一个文件
+  int readahead = 8;
+  // Parquet 要读的列，空表示全部
+  std::vector<std::string> columns;
+  // 合并相邻读取范围的参数：间隔小于 hole_size_limit 的范围会合并成一次读取
+  arrow::io::CacheOptions cache_options = arrow::io::CacheOptions::Defaults();
+};
+
+namespace prefetch_internal {
+
+inline bool IsParquet(const std::string& path) {
+  return path.size() >= 8 && path.compare(path.size() - 8, 8, ".parquet") == 0;
+}
+
+// IO 阶段的结果：Parquet 是已经预读好列块的 ParquetFileReader，IPC 是整个文件的内容
+struct Prefetched {
+  std::string path;
+  std::unique_ptr<parquet::ParquetFileReader> parquet;
+  std::vector<int> row_groups;
+  std::vector<int> column_indices;
+  std::shared_ptr<arrow::Buffer> contents;
+};
+
+// 在 IO 线程上执行：打开文件、读 footer，并发出预读请求（不等待数据到达）
+inline arrow::Result<std::shared_ptr<Prefetched>> StartRead(const std::string& path,
+                                                            const PrefetchOptions& options) {
+  auto prefetched = std::make_shared<Prefetched>();
+  prefetched->path = path;
+  ARROW_ASSIGN_OR_RAISE(auto file, arrow::io::ReadableFile::Open(path));
+  if (!IsParquet(path)) {
+    ARROW_ASSIGN_OR_RAISE(int64_t size, file->GetSize());
+    ARROW_ASSIGN_OR_RAISE(prefetched->contents, file->ReadAt(0, size));
+    return prefetched;
+  }
+  PARQUET_CATCH_NOT_OK(prefetched->parquet = parquet::ParquetFileReader::Open(file));
+  auto metadata = prefetched->parquet->metadata();
+  for (int i = 0; i < metadata->num_row_groups(); ++i) prefetched->row_groups.push_back(i);
+  if (options.columns.empty()) {
+    for (int i = 0; i < metadata->num_columns(); ++i) prefetched->column_indices.push_back(i);
+  } else {
+    for (const auto& name : options.columns) {
+      const int index = metadata->schema()->ColumnIndex(name);
+      if (index < 0) return arrow::Status::KeyError(path, " has no column '", name, "'");
+      prefetched->column_indices.push_back(index);
+    }
+  }
+  PARQUET_CATCH_NOT_OK(prefetched->parquet->PreBuffer(
+      prefetched->row_groups, prefetched->column_indices, arrow::io::default_io_context(),
+      options.cache_options));
+  return prefetched;
+}
+
+// 在 CPU 线程上执行：数据已经在内存里，解码不会再阻塞在 IO 上
+inline arrow::Result<std::shared_ptr<arrow::Table>> Decode(
+    const std::shared_ptr<Prefetched>& prefetched) {
+  if (prefetched->parquet == nullptr) {
+    arrow::io::BufferReader input(prefetched->contents);
+    ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(&input));
+    arrow::RecordBatchVector batches;
+    for (int i = 0; i < reader->num_record_batches(); ++i) {
+      ARROW_ASSIGN_OR_RAISE(auto batch, reader->ReadRecordBatch(i));
+      batches.push_back(std::move(batch));
+    }
+    return arrow::Table::FromRecordBatches(reader->schema(), batches);
+  }
+  // 并行度来自同时解码多个文件，单个文件内不再开线程。
+  // 需要的列块已经由 StartRead 里的 PreBuffer 读进内存，关掉 FileReader 自己的预读，
+  // 否则 ReadRowGroups 会再发一轮 IO，解码又要等 IO
+  parquet::ArrowReaderProperties properties;
+  properties.set_use_threads(false);
+  properties.set_pre_buffer(false);
+  ARROW_ASSIGN_OR_RAISE(auto reader,
+                        parquet::arrow::FileReader::Make(arrow::default_memory_pool(),
+                                                         std::move(prefetched->parquet),
+                                                         properties));
+  return reader->ReadRowGroups(prefetched->row_groups, prefetched->column_indices);
+}
+
+// 一个文件的完整流水线：IO 线程打开并预读 -> 等数据到达 -> CPU 线程解码
+inline arrow::Future<std::shared_ptr<arrow::Table>> ReadAsync(const std::string& path,
+                                                              const PrefetchOptions& options) {
+  using PrefetchedFuture = arrow::Future<std::shared_ptr<Prefetched>>;
+  auto* io_executor = arrow::io::default_io_context().executor();
+  auto* cpu_executor = arrow::internal::GetCpuThreadPool();
+  PrefetchedFuture opened =
+      arrow::DeferNotOk(io_executor->Submit([path, options] { return StartRead(path, options); }));
+  PrefetchedFuture buffered =
+      opened.Then([](const std::shared_ptr<Prefetched>& prefetched) -> PrefetchedFuture {
+        if (prefetched->parquet == nullptr) return PrefetchedFuture::MakeFinished(prefetched);
+        return prefetched->parquet
+            ->WhenBuffered(prefetched->row_groups, prefetched->column_indices)
+            .Then([prefetched] { return prefetched; });
+      });
+  return buffered.Then([cpu_executor](const std::shared_ptr<Prefetched>& prefetched)
+                           -> arrow::Future<std::shared_ptr<arrow::Table>> {
+    return arrow::DeferNotOk(cpu_executor->Submit([prefetched] { return Decode(prefetched); }));
+  });
+}
+
+}  // namespace prefetch_internal
+
+// 按顺序扫描 paths，对每个文件调用 visitor(path, table)。
+// 任何一个文件出错时停止，已经发出的读取会在后台完成后被丢弃。
+inline arrow::Status ScanFiles(
+    const std::vector<std::string>& paths, const PrefetchOptions& options,
+    const std::function<arrow::Status(const std::string&, const std::shared_ptr<arrow::Table>&)>&
+        visitor) {
+  const size_t readahead = static_cast<size_t>(std::max(options.readahead, 1));
+  std::deque<arrow::Future<std::shared_ptr<arrow::Table>>> in_flight;
+  size_t next = 0;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    while (next < paths.size() && in_flight.size() < readahead) {
+      in_flight.push_back(prefetch_internal::ReadAsync(paths[next++], options));
+    }
+    ARROW_ASSIGN_OR_RAISE(auto table, in_flight.front().result());
+    in_flight.pop_front();
+    ARROW_RETURN_NOT_OK(visitor(paths[i], table));
+  }
+  return arrow::Status::OK();
+}
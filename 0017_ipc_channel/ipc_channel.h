@@ -0,0 +1,482 @@
+// 进程间传递净值更新的两种方式，都沿用 0002_io 里的 IPC 格式：
+//   1. Unix domain socket：RecordBatchStreamWriter / RecordBatchStreamReader 直接读写 socket，
+//      和写 IPC stream 文件完全一样，另一端可以是任何能读 Arrow stream 的程序。
+//   2. 共享内存环形缓冲区：生产者把 IPC 消息直接序列化到共享内存里，
+//      消费者可以让读出的 record batch 的 buffer 直接指向共享内存，不再复制。
+// 两种方式都只支持一个生产者和一个消费者。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <arrow/util/bit_util.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 直接在文件描述符上读写的流，socket、管道都可以用
+class FdOutputStream : public arrow::io::OutputStream {
+ public:
+  explicit FdOutputStream(int fd) : fd_(fd) {}
+  ~FdOutputStream() override { ARROW_UNUSED(Close()); }
+
+  arrow::Status Close() override {
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+    return arrow::Status::OK();
+  }
+  bool closed() const override { return fd_ < 0; }
+  arrow::Result<int64_t> Tell() const override { return position_; }
+
+  arrow::Status Write(const void* data, int64_t nbytes) override {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (nbytes > 0) {
+      const ssize_t written = ::write(fd_, p, static_cast<size_t>(nbytes));
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        return arrow::Status::IOError("write failed: ", std::strerror(errno));
+      }
+      p += written;
+      nbytes -= written;
+      position_ += written;
+    }
+    return arrow::Status::OK();
+  }
+  using arrow::io::OutputStream::Write;
+
+ private:
+  int fd_;
+  int64_t position_ = 0;
+};
+
+class FdInputStream : public arrow::io::InputStream {
+ public:
+  explicit FdInputStream(int fd) : fd_(fd) {}
+  ~FdInputStream() override { ARROW_UNUSED(Close()); }
+
+  arrow::Status Close() override {
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+    return arrow::Status::OK();
+  }
+  bool closed() const override { return fd_ < 0; }
+  arrow::Result<int64_t> Tell() const override { return position_; }
+
+  // 一直读到 nbytes 字节或者对端关闭
+  arrow::Result<int64_t> Read(int64_t nbytes, void* out) override {
+    uint8_t* p = static_cast<uint8_t*>(out);
+    int64_t total = 0;
+    while (total < nbytes) {
+      const ssize_t n = ::read(fd_, p + total, static_cast<size_t>(nbytes - total));
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        return arrow::Status::IOError("read failed: ", std::strerror(errno));
+      }
+      if (n == 0) break;
+      total += n;
+    }
+    position_ += total;
+    return total;
+  }
+
+  arrow::Result<std::shared_ptr<arrow::Buffer>> Read(int64_t nbytes) override {
+    ARROW_ASSIGN_OR_RAISE(auto buffer, arrow::AllocateResizableBuffer(nbytes));
+    ARROW_ASSIGN_OR_RAISE(int64_t n, Read(nbytes, buffer->mutable_data()));
+    ARROW_RETURN_NOT_OK(buffer->Resize(n, /*shrink_to_fit=*/false));
+    return std::shared_ptr<arrow::Buffer>(std::move(buffer));
+  }
+
+ private:
+  int fd_;
+  int64_t position_ = 0;
+};
+
+inline arrow::Result<sockaddr_un> UnixSocketAddress(const std::string& path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    return arrow::Status::Invalid("unix socket path too long: ", path);
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return address;
+}
+
+// 在 path 上监听，返回监听的描述符
+inline arrow::Result<int> ListenUnixSocket(const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto address, UnixSocketAddress(path));
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return arrow::Status::IOError("socket failed: ", std::strerror(errno));
+  ::unlink(path.c_str());
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      ::listen(fd, 1) != 0) {
+    const int error = errno;
+    ::close(fd);
+    return arrow::Status::IOError("cannot listen on ", path, ": ", std::strerror(error));
+  }
+  return fd;
+}
+
+inline arrow::Result<int> AcceptUnixSocket(int listen_fd) {
+  const int fd = ::accept(listen_fd, nullptr, nullptr);
+  if (fd < 0) return arrow::Status::IOError("accept failed: ", std::strerror(errno));
+  return fd;
+}
+
+inline arrow::Result<int> ConnectUnixSocket(const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto address, UnixSocketAddress(path));
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return arrow::Status::IOError("socket failed: ", std::strerror(errno));
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    const int error = errno;
+    ::close(fd);
+    return arrow::Status::IOError("cannot connect to ", path, ": ", std::strerror(error));
+  }
+  return fd;
+}
+
+// 在 socket 上打开 IPC stream 的写入端 / 读取端，接管 fd
+inline arrow::Result<std::shared_ptr<arrow::ipc::RecordBatchWriter>> MakeSocketWriter(
+    int fd, const std::shared_ptr<arrow::Schema>& schema,
+    const arrow::ipc::IpcWriteOptions& options = arrow::ipc::IpcWriteOptions::Defaults()) {
+  return arrow::ipc::MakeStreamWriter(std::make_shared<FdOutputStream>(fd), schema, options);
+}
+
+inline arrow::Result<std::shared_ptr<arrow::RecordBatchReader>> MakeSocketReader(int fd) {
+  return arrow::ipc::RecordBatchStreamReader::Open(std::make_shared<FdInputStream>(fd));
+}
+
+// 共享内存的布局：头部（读写位置）之后是 capacity 字节的数据区。
+// 读写位置单调递增，对 capacity 取模得到偏移。每条消息以 64 字节的记录头开始（只用前 8 字节存长度），
+// 消息体按 64 字节对齐，保证读出来的 Arrow buffer 满足对齐要求。
+struct ShmRingHeader {
+  // 生产者已经发布的位置
+  alignas(64) std::atomic<uint64_t> head;
+  // 消费者已经释放的位置
+  alignas(64) std::atomic<uint64_t> tail;
+  alignas(64) std::atomic<uint32_t> closed;
+  uint64_t capacity;
+};
+
+class ShmRing {
+ public:
+  static constexpr int64_t kRecordHeader = 64;
+  // 记录头里的特殊长度：数据区末尾剩余的空间不够放下消息，跳到开头
+  static constexpr uint64_t kWrapMarker = ~uint64_t(0);
+
+  // 创建一块新的共享内存，capacity 会向上取整到 64 的倍数
+  static arrow::Result<std::shared_ptr<ShmRing>> Create(const std::string& name,
+                                                        int64_t capacity) {
+    capacity = arrow::bit_util::RoundUpToMultipleOf64(capacity);
+    const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      return arrow::Status::IOError("shm_open ", name, " failed: ", std::strerror(errno));
+    }
+    const int64_t size = static_cast<int64_t>(sizeof(ShmRingHeader)) + capacity;
+    if (::ftruncate(fd, size) != 0) {
+      const int error = errno;
+      ::close(fd);
+      ::shm_unlink(name.c_str());
+      return arrow::Status::IOError("ftruncate failed: ", std::strerror(error));
+    }
+    ARROW_ASSIGN_OR_RAISE(auto ring, Map(fd, size, name, /*owner=*/true));
+    auto* header = ring->header();
+    header->head.store(0);
+    header->tail.store(0);
+    header->closed.store(0);
+    header->capacity = static_cast<uint64_t>(capacity);
+    return ring;
+  }
+
+  // 打开另一个进程创建的共享内存
+  static arrow::Result<std::shared_ptr<ShmRing>> Open(const std::string& name) {
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+      return arrow::Status::IOError("shm_open ", name, " failed: ", std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      const int error = errno;
+      ::close(fd);
+      return arrow::Status::IOError("fstat failed: ", std::strerror(error));
+    }
+    return Map(fd, st.st_size, name, /*owner=*/false);
+  }
+
+  ~ShmRing() {
+    ::munmap(base_, static_cast<size_t>(size_));
+    if (owner_ && getpid() == owner_pid_) ::shm_unlink(name_.c_str());
+  }
+
+  ShmRingHeader* header() const { return reinterpret_cast<ShmRingHeader*>(base_); }
+  uint8_t* data() const { return static_cast<uint8_t*>(base_) + sizeof(ShmRingHeader); }
+  uint64_t capacity() const { return header()->capacity; }
+
+ private:
+  ShmRing(void* base, int64_t size, std::string name, bool owner)
+      : base_(base), size_(size), name_(std::move(name)), owner_(owner), owner_pid_(getpid()) {}
+
+  static arrow::Result<std::shared_ptr<ShmRing>> Map(int fd, int64_t size,
+                                                     const std::string& name, bool owner) {
+    void* base =
+        ::mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int error = errno;
+    ::close(fd);
+    if (base == MAP_FAILED) {
+      if (owner) ::shm_unlink(name.c_str());
+      return arrow::Status::IOError("mmap failed: ", std::strerror(error));
+    }
+    return std::shared_ptr<ShmRing>(new ShmRing(base, size, name, owner));
+  }
+
+  void* base_;
+  int64_t size_;
+  std::string name_;
+  bool owner_;
+  pid_t owner_pid_;
+};
+
+namespace shm_internal {
+
+// 等待条件成立。单核机器上一直自旋会占住对方需要的 CPU，所以每次检查失败都让出 CPU
+template <typename Predicate>
+inline void SpinUntil(Predicate&& predicate) {
+  while (!predicate()) std::this_thread::yield();
+}
+
+inline uint64_t RecordSize(int64_t payload) {
+  return static_cast<uint64_t>(ShmRing::kRecordHeader +
+                               arrow::bit_util::RoundUpToMultipleOf64(payload));
+}
+
+// 把消费者用完的空间还给生产者。消息可能按任意顺序释放（batch 的各列被不同的地方持有），
+// tail 只推进到从头开始连续释放的位置
+class ShmReleaser {
+ public:
+  explicit ShmReleaser(std::shared_ptr<ShmRing> ring) : ring_(std::move(ring)) {}
+
+  void Release(uint64_t begin, uint64_t end) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    released_[begin] = end;
+    auto it = released_.begin();
+    while (it != released_.end() && it->first == tail_) {
+      tail_ = it->second;
+      it = released_.erase(it);
+    }
+    ring_->header()->tail.store(tail_, std::memory_order_release);
+  }
+
+ private:
+  // 持有 ring，消息没有全部释放之前共享内存不会被 unmap
+  std::shared_ptr<ShmRing> ring_;
+  std::mutex mutex_;
+  // 已释放但前面还有消息没释放的区间 [begin, end)
+  std::map<uint64_t, uint64_t> released_;
+  uint64_t tail_ = 0;
+};
+
+// 直接指向共享内存里一条消息的 Buffer，最后一个引用释放时才把这段空间还给生产者
+class ShmMessageBuffer : public arrow::Buffer {
+ public:
+  ShmMessageBuffer(const uint8_t* data, int64_t size, std::shared_ptr<ShmReleaser> releaser,
+                   uint64_t begin, uint64_t end)
+      : arrow::Buffer(data, size), releaser_(std::move(releaser)), begin_(begin), end_(end) {}
+
+  ~ShmMessageBuffer() override { releaser_->Release(begin_, end_); }
+
+ private:
+  std::shared_ptr<ShmReleaser> releaser_;
+  uint64_t begin_;
+  uint64_t end_;
+};
+
+}  // namespace shm_internal
+
+// 生产者：先写 schema 消息，之后每个 record batch 一条消息
+class ShmBatchWriter {
+ public:
+  static arrow::Result<std::unique_ptr<ShmBatchWriter>> Make(
+      std::shared_ptr<ShmRing> ring, const std::shared_ptr<arrow::Schema>& schema,
+      const arrow::ipc::IpcWriteOptions& options = arrow::ipc::IpcWriteOptions::Defaults()) {
+    for (const auto& field : schema->fields()) {
+      if (field->type()->id() == arrow::Type::DICTIONARY) {
+        return arrow::Status::NotImplemented("dictionary fields are not supported: ",
+                                             field->name());
+      }
+    }
+    std::unique_ptr<ShmBatchWriter> writer(new ShmBatchWriter(std::move(ring), options));
+    ARROW_ASSIGN_OR_RAISE(auto schema_message, arrow::ipc::SerializeSchema(*schema));
+    ARROW_RETURN_NOT_OK(writer->Publish(schema_message->size(), [&](uint8_t* out) {
+      std::memcpy(out, schema_message->data(), static_cast<size_t>(schema_message->size()));
+      return arrow::Status::OK();
+    }));
+    return writer;
+  }
+
+  ~ShmBatchWriter() { ARROW_UNUSED(Close()); }
+
+  // 直接序列化到共享内存，是整个传输过程中唯一的一次复制
+  arrow::Status WriteRecordBatch(const arrow::RecordBatch& batch) {
+    int64_t size = 0;
+    ARROW_RETURN_NOT_OK(arrow::ipc::GetRecordBatchSize(batch, options_, &size));
+    return Publish(size, [&](uint8_t* out) {
+      auto target = std::make_shared<arrow::MutableBuffer>(out, size);
+      arrow::io::FixedSizeBufferWriter stream(target);
+      return arrow::ipc::SerializeRecordBatch(batch, options_, &stream);
+    });
+  }
+
+  // 通知消费者不会再有新的消息
+  arrow::Status Close() {
+    if (ring_ != nullptr) {
+      ring_->header()->closed.store(1, std::memory_order_release);
+      ring_.reset();
+    }
+    return arrow::Status::OK();
+  }
+
+ private:
+  ShmBatchWriter(std::shared_ptr<ShmRing> ring, arrow::ipc::IpcWriteOptions options)
+      : ring_(std::move(ring)), options_(std::move(options)) {}
+
+  // 等到有足够的空间，把消息写进去，再更新 head 让消费者看到
+  template <typename Fill>
+  arrow::Status Publish(int64_t payload, Fill&& fill) {
+    if (ring_ == nullptr) return arrow::Status::Invalid("writer is closed");
+    auto* header = ring_->header();
+    const uint64_t capacity = ring_->capacity();
+    const uint64_t record = shm_internal::RecordSize(payload);
+    if (record > capacity / 2) {
+      return arrow::Status::CapacityError("message of ", payload,
+                                          " bytes does not fit the ring buffer");
+    }
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t offset = head % capacity;
+    if (offset + record > capacity) {
+      // 末尾放不下，写一个跳转标记，从数据区开头继续
+      const uint64_t skip = capacity - offset;
+      shm_internal::SpinUntil([&] {
+        return head + skip - header->tail.load(std::memory_order_acquire) <= capacity;
+      });
+      std::memcpy(ring_->data() + offset, &ShmRing::kWrapMarker, sizeof(uint64_t));
+      head += skip;
+      header->head.store(head, std::memory_order_release);
+      offset = 0;
+    }
+    shm_internal::SpinUntil([&] {
+      return head + record - header->tail.load(std::memory_order_acquire) <= capacity;
+    });
+    uint8_t* slot = ring_->data() + offset;
+    const uint64_t length = static_cast<uint64_t>(payload);
+    std::memcpy(slot, &length, sizeof(length));
+    ARROW_RETURN_NOT_OK(fill(slot + ShmRing::kRecordHeader));
+    header->head.store(head + record, std::memory_order_release);
+    return arrow::Status::OK();
+  }
+
+  std::shared_ptr<ShmRing> ring_;
+  arrow::ipc::IpcWriteOptions options_;
+};
+
+// 消费者。zero_copy 为 false 时每条消息复制到内存池后立即释放共享内存里的空间，
+// 返回的 batch 和普通的 RecordBatchReader 一样可以任意保留（ToTable 等）。
+// zero_copy 为 true 时 batch 的 buffer 直接引用共享内存，batch（包括它的切片和列）
+// 全部释放后这段空间才还给生产者：逐个处理、处理完就丢掉的消费者没有复制，
+// 但同时保留的 batch 超过环形缓冲区的容量时生产者会一直等待，不能用 ToTable 读完整个流。
+class ShmBatchReader : public arrow::RecordBatchReader {
+ public:
+  static arrow::Result<std::shared_ptr<ShmBatchReader>> Open(std::shared_ptr<ShmRing> ring,
+                                                             bool zero_copy = false) {
+    auto reader =
+        std::shared_ptr<ShmBatchReader>(new ShmBatchReader(std::move(ring), zero_copy));
+    ARROW_ASSIGN_OR_RAISE(auto message, reader->NextMessage());
+    if (message == nullptr) return arrow::Status::Invalid("ring closed before the schema");
+    arrow::io::BufferReader input(message);
+    ARROW_ASSIGN_OR_RAISE(reader->schema_,
+                          arrow::ipc::ReadSchema(&input, &reader->dictionary_memo_));
+    return reader;
+  }
+
+  std::shared_ptr<arrow::Schema> schema() const override { return schema_; }
+
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* batch) override {
+    ARROW_ASSIGN_OR_RAISE(auto message, NextMessage());
+    if (message == nullptr) {
+      *batch = nullptr;
+      return arrow::Status::OK();
+    }
+    // BufferReader 支持零拷贝，读出的 buffer 都是 message 的切片，会一直持有 message
+    arrow::io::BufferReader input(message);
+    return arrow::ipc::ReadRecordBatch(schema_, &dictionary_memo_,
+                                       arrow::ipc::IpcReadOptions::Defaults(), &input)
+        .Value(batch);
+  }
+
+ private:
+  ShmBatchReader(std::shared_ptr<ShmRing> ring, bool zero_copy)
+      : ring_(ring),
+        releaser_(std::make_shared<shm_internal::ShmReleaser>(std::move(ring))),
+        zero_copy_(zero_copy) {}
+
+  // 等待下一条消息；生产者关闭且没有新消息时返回 nullptr
+  arrow::Result<std::shared_ptr<arrow::Buffer>> NextMessage() {
+    auto* header = ring_->header();
+    const uint64_t capacity = ring_->capacity();
+    while (true) {
+      uint64_t head = 0;
+      shm_internal::SpinUntil([&] {
+        head = header->head.load(std::memory_order_acquire);
+        return head > position_ || header->closed.load(std::memory_order_acquire) != 0;
+      });
+      if (head == position_) {
+        // closed 之前发布的消息一定已经可见，再确认一次 head
+        head = header->head.load(std::memory_order_acquire);
+        if (head == position_) return nullptr;
+      }
+      const uint64_t offset = position_ % capacity;
+      uint64_t length;
+      std::memcpy(&length, ring_->data() + offset, sizeof(length));
+      const uint64_t begin = position_;
+      if (length == ShmRing::kWrapMarker) {
+        position_ += capacity - offset;
+        releaser_->Release(begin, position_);
+        continue;
+      }
+      position_ += shm_internal::RecordSize(static_cast<int64_t>(length));
+      const uint8_t* payload = ring_->data() + offset + ShmRing::kRecordHeader;
+      if (zero_copy_) {
+        return std::make_shared<shm_internal::ShmMessageBuffer>(
+            payload, static_cast<int64_t>(length), releaser_, begin, position_);
+      }
+      // 内存池分配的内存按 64 字节对齐，复制之后马上释放共享内存里的空间
+      auto copied = arrow::AllocateBuffer(static_cast<int64_t>(length));
+      if (copied.ok()) std::memcpy((*copied)->mutable_data(), payload, length);
+      releaser_->Release(begin, position_);
+      ARROW_ASSIGN_OR_RAISE(auto buffer, std::move(copied));
+      return std::shared_ptr<arrow::Buffer>(std::move(buffer));
+    }
+  }
+
+  std::shared_ptr<ShmRing> ring_;
+  std::shared_ptr<shm_internal::ShmReleaser> releaser_;
+  const bool zero_copy_;
+  std::shared_ptr<arrow::Schema> schema_;
+  arrow::ipc::DictionaryMemo dictionary_memo_;
+  // 下一条消息的位置
+  uint64_t position_ = 0;
+};
+
@@ -0,0 +1,200 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/util/byte_size.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "../fund_panel/fund_panel.h"
+#include "ipc_channel.h"
+// (文档部分: 包含)
+
+constexpr int kLatencyBatches = 2000;
+constexpr int64_t kLatencyRows = 64;
+constexpr int64_t kThroughputRows = 64 * 1024;
+constexpr int kThroughputPasses = 5;
+
+// 两个进程共享的统计数据（fork 之前用匿名共享内存分配）
+struct SharedStats {
+  std::atomic<int64_t> received;
+  int64_t send_ns[kLatencyBatches];
+  int64_t receive_ns[kLatencyBatches];
+  int64_t start_ns;
+  int64_t end_ns;
+  int64_t bytes;
+  int64_t rows;
+};
+
+// CLOCK_MONOTONIC 在同一台机器的不同进程之间可以直接比较
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+double SumNav(const arrow::RecordBatch& batch) {
+  auto nav = std::static_pointer_cast<arrow::DoubleArray>(batch.GetColumnByName("nav"));
+  double sum = 0;
+  for (int64_t i = 0; i < nav->length(); ++i) sum += nav->Value(i);
+  return sum;
+}
+
+// (文档部分: 生产者)
+// 先逐个发送小 batch 测延迟（等消费者收到后再发下一个），再连续发送大 batch 测吞吐
+template <typename Write>
+arrow::Status Produce(const arrow::Table& panel, SharedStats* stats, Write&& write) {
+  arrow::TableBatchReader small(panel);
+  small.set_chunksize(kLatencyRows);
+  for (int i = 0; i < kLatencyBatches; ++i) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    ARROW_RETURN_NOT_OK(small.ReadNext(&batch));
+    stats->send_ns[i] = NowNs();
+    ARROW_RETURN_NOT_OK(write(*batch));
+    while (stats->received.load(std::memory_order_acquire) <= i) std::this_thread::yield();
+  }
+  stats->start_ns = NowNs();
+  for (int pass = 0; pass < kThroughputPasses; ++pass) {
+    arrow::TableBatchReader large(panel);
+    large.set_chunksize(kThroughputRows);
+    std::shared_ptr<arrow::RecordBatch> batch;
+    while (true) {
+      ARROW_RETURN_NOT_OK(large.ReadNext(&batch));
+      if (batch == nullptr) break;
+      ARROW_RETURN_NOT_OK(write(*batch));
+    }
+  }
+  return arrow::Status::OK();
+}
+// (文档部分: 生产者)
+
+// (文档部分: 消费者)
+arrow::Status Consume(arrow::RecordBatchReader* reader, SharedStats* stats, double* checksum) {
+  int64_t count = 0;
+  while (true) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    ARROW_RETURN_NOT_OK(reader->ReadNext(&batch));
+    if (batch == nullptr) break;
+    if (count < kLatencyBatches) {
+      stats->receive_ns[count] = NowNs();
+      *checksum += SumNav(*batch);
+      stats->received.store(count + 1, std::memory_order_release);
+    } else {
+      *checksum += SumNav(*batch);
+      stats->rows += batch->num_rows();
+      stats->bytes += arrow::util::TotalBufferSize(*batch);
+    }
+    ++count;
+  }
+  stats->end_ns = NowNs();
+  return arrow::Status::OK();
+}
+// (文档部分: 消费者)
+
+void PrintStats(const std::string& name, const SharedStats& stats, double checksum) {
+  std::vector<double> latencies;
+  for (int i = 0; i < kLatencyBatches; ++i) {
+    latencies.push_back((stats.receive_ns[i] - stats.send_ns[i]) / 1000.0);
+  }
+  std::sort(latencies.begin(), latencies.end());
+  const double seconds = (stats.end_ns - stats.start_ns) / 1e9;
+  std::cout << name << ": latency per " << kLatencyRows << "-row batch p50 "
+            << latencies[latencies.size() / 2] << " us, p99 "
+            << latencies[latencies.size() * 99 / 100] << " us; throughput "
+            << stats.bytes / seconds / (1 << 20) << " MB/s, " << stats.rows / seconds / 1e6
+            << " M rows/s (checksum " << checksum << ")" << std::endl;
+}
+
+// fork 出生产者进程，当前进程作为消费者
+template <typename Producer, typename Consumer>
+arrow::Status RunTransport(const std::string& name, Producer&& producer, Consumer&& consumer) {
+  void* memory = mmap(nullptr, sizeof(SharedStats), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) return arrow::Status::IOError("mmap failed");
+  auto* stats = new (memory) SharedStats();
+  const pid_t pid = fork();
+  if (pid == 0) {
+    arrow::Status st = producer(stats);
+    if (!st.ok()) std::cerr << "producer: " << st << std::endl;
+    _exit(st.ok() ? 0 : 1);
+  }
+  double checksum = 0;
+  arrow::Status st = consumer(stats, &checksum);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (st.ok() && (!WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+    st = arrow::Status::IOError(name, ": producer failed");
+  }
+  if (st.ok()) PrintStats(name, *stats, checksum);
+  munmap(memory, sizeof(SharedStats));
+  return st;
+}
+
+arrow::Status RunMain() {
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 2000;
+  panel_options.num_days = 1500;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  ARROW_ASSIGN_OR_RAISE(panel, panel->CombineChunks());
+
+  // (文档部分: Unix socket)
+  const std::string socket_path = "/tmp/nav_channel_" + std::to_string(getpid()) + ".sock";
+  ARROW_ASSIGN_OR_RAISE(int listen_fd, ListenUnixSocket(socket_path));
+  ARROW_RETURN_NOT_OK(RunTransport(
+      "unix socket",
+      [&](SharedStats* stats) -> arrow::Status {
+        ::close(listen_fd);
+        ARROW_ASSIGN_OR_RAISE(int fd, ConnectUnixSocket(socket_path));
+        ARROW_ASSIGN_OR_RAISE(auto writer, MakeSocketWriter(fd, panel->schema()));
+        ARROW_RETURN_NOT_OK(Produce(*panel, stats, [&](const arrow::RecordBatch& batch) {
+          return writer->WriteRecordBatch(batch);
+        }));
+        return writer->Close();
+      },
+      [&](SharedStats* stats, double* checksum) -> arrow::Status {
+        ARROW_ASSIGN_OR_RAISE(int fd, AcceptUnixSocket(listen_fd));
+        ARROW_ASSIGN_OR_RAISE(auto reader, MakeSocketReader(fd));
+        return Consume(reader.get(), stats, checksum);
+      }));
+  ::close(listen_fd);
+  ::unlink(socket_path.c_str());
+  // (文档部分: Unix socket)
+
+  // (文档部分: 共享内存)
+  const std::string ring_name = "/nav_channel_" + std::to_string(getpid());
+  ARROW_ASSIGN_OR_RAISE(auto ring, ShmRing::Create(ring_name, 64 << 20));
+  ARROW_RETURN_NOT_OK(RunTransport(
+      "shared memory",
+      [&](SharedStats* stats) -> arrow::Status {
+        // 和独立的进程一样按名字重新打开
+        ARROW_ASSIGN_OR_RAISE(auto producer_ring, ShmRing::Open(ring_name));
+        ARROW_ASSIGN_OR_RAISE(auto writer, ShmBatchWriter::Make(producer_ring, panel->schema()));
+        ARROW_RETURN_NOT_OK(Produce(*panel, stats, [&](const arrow::RecordBatch& batch) {
+          return writer->WriteRecordBatch(batch);
+        }));
+        return writer->Close();
+      },
+      [&](SharedStats* stats, double* checksum) -> arrow::Status {
+        // Consume 处理完一个 batch 就丢掉，可以直接引用共享内存
+        ARROW_ASSIGN_OR_RAISE(auto reader, ShmBatchReader::Open(ring, /*zero_copy=*/true));
+        return Consume(reader.get(), stats, checksum);
+      }));
+  // (文档部分: 共享内存)
+
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
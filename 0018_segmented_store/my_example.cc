@@ -0,0 +1,170 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "../0014_parquet_nav_writer/nav_writer_properties.h"
+#include "../fund_panel/fund_panel.h"
+#include "segmented_store.h"
+// (文档部分: 包含)
+
+constexpr int kFunds = 2000;
+constexpr int kDays = 1000;
+// 前 700 天作为历史数据一次性写入，之后每天追加一批
+constexpr int kHistoryDays = 700;
+constexpr int kPhaseOneEnd = 850;
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+// 面板按 (date, fund_code) 排序，第 day 天的数据是连续的 kFunds 行
+std::shared_ptr<arrow::Table> Days(const std::shared_ptr<arrow::Table>& panel, int first,
+                                   int last) {
+  return panel->Slice(static_cast<int64_t>(first) * kFunds,
+                      static_cast<int64_t>(last - first) * kFunds);
+}
+
+arrow::Result<double> SumNav(const std::shared_ptr<arrow::Table>& table) {
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum sum, arrow::compute::Sum(table->GetColumnByName("nav")));
+  return sum.scalar_as<arrow::DoubleScalar>().value;
+}
+
+// 逐天追加，返回每次追加的耗时
+arrow::Result<std::vector<double>> AppendDays(SegmentedStore* store,
+                                              const std::shared_ptr<arrow::Table>& panel,
+                                              int first, int last) {
+  std::vector<double> latencies;
+  for (int day = first; day < last; ++day) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ARROW_RETURN_NOT_OK(store->Append(Days(panel, day, day + 1)));
+    latencies.push_back(ElapsedMs(start_time));
+  }
+  return latencies;
+}
+
+void PrintLatencies(const std::string& name, std::vector<double> latencies) {
+  std::sort(latencies.begin(), latencies.end());
+  double total = 0;
+  for (double ms : latencies) total += ms;
+  std::cout << name << ": " << latencies.size() << " appends of " << kFunds
+            << " rows, mean " << total / latencies.size() << " ms, p50 "
+            << latencies[latencies.size() / 2] << " ms, p99 "
+            << latencies[latencies.size() * 99 / 100] << " ms" << std::endl;
+}
+
+void PrintStats(const std::string& name, const SegmentedStoreStats& stats) {
+  std::cout << name << ": " << stats.partitions << " partitions, " << stats.segments
+            << " segments, " << stats.parquet_files << " parquet files, "
+            << stats.bytes / (1 << 20) << " MB on disk, " << stats.compactions << " compactions"
+            << std::endl;
+}
+
+// 读取整个存储和最近 20 个交易日，打印耗时
+arrow::Status TimeReads(const std::string& name, SegmentedStore* store, int32_t recent_date) {
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto all, store->Read());
+  const double all_ms = ElapsedMs(start_time);
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto recent, store->Read(recent_date));
+  const double recent_ms = ElapsedMs(start_time);
+  ARROW_ASSIGN_OR_RAISE(double checksum, SumNav(all));
+  std::cout << name << ": full read " << all->num_rows() << " rows in " << all_ms
+            << " ms, last 20 days " << recent->num_rows() << " rows in " << recent_ms
+            << " ms (checksum " << checksum << ")" << std::endl;
+  return arrow::Status::OK();
+}
+
+arrow::Status RunMain() {
+  FundPanelOptions panel_options;
+  panel_options.num_funds = kFunds;
+  panel_options.num_days = kDays;
+  panel_options.date_major = true;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  ARROW_ASSIGN_OR_RAISE(panel, panel->CombineChunks());
+  ARROW_ASSIGN_OR_RAISE(double expected, SumNav(panel));
+  std::cout << "panel: " << panel->num_rows() << " rows, expected checksum " << expected
+            << std::endl;
+
+  const std::string root = "nav_store";
+  std::filesystem::remove_all(root);
+
+  // (文档部分: 整体重写)
+  // 0002_io 的做法：每天把全部历史和新的一天重新写成一个 Parquet 文件
+  std::vector<double> rewrites;
+  for (int day = kHistoryDays; day < kPhaseOneEnd; day += 30) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ARROW_RETURN_NOT_OK(WriteNavParquet(*Days(panel, 0, day + 1), "rewrite.parquet"));
+    rewrites.push_back(ElapsedMs(start_time));
+  }
+  PrintLatencies("full parquet rewrite (sampled)", rewrites);
+  std::filesystem::remove("rewrite.parquet");
+  // (文档部分: 整体重写)
+
+  // (文档部分: 追加)
+  {
+    SegmentedStoreOptions options;
+    options.background_compaction = false;
+    ARROW_ASSIGN_OR_RAISE(auto store, SegmentedStore::Open(root, panel->schema(), options));
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ARROW_RETURN_NOT_OK(store->Append(Days(panel, 0, kHistoryDays)));
+    ARROW_RETURN_NOT_OK(store->CompactAll());
+    std::cout << "history load (" << kHistoryDays << " days): " << ElapsedMs(start_time)
+              << " ms" << std::endl;
+
+    ARROW_ASSIGN_OR_RAISE(auto latencies,
+                          AppendDays(store.get(), panel, kHistoryDays, kPhaseOneEnd));
+    PrintLatencies("segment append", latencies);
+    PrintStats("before compaction", store->stats());
+
+    const int32_t recent_date = TradingDay(panel_options.start_date, kPhaseOneEnd - 20);
+    ARROW_RETURN_NOT_OK(TimeReads("segments", store.get(), recent_date));
+
+    start_time = std::chrono::high_resolution_clock::now();
+    ARROW_RETURN_NOT_OK(store->CompactAll());
+    std::cout << "compaction: " << ElapsedMs(start_time) << " ms" << std::endl;
+    PrintStats("after compaction", store->stats());
+    ARROW_RETURN_NOT_OK(TimeReads("compacted", store.get(), recent_date));
+  }
+  // (文档部分: 追加)
+
+  // (文档部分: 后台压缩)
+  // 重新打开同一个目录（从 MANIFEST 恢复），打开后台压缩，边追加边读取
+  {
+    SegmentedStoreOptions options;
+    options.compact_min_segments = 32;
+    ARROW_ASSIGN_OR_RAISE(auto store, SegmentedStore::Open(root, panel->schema(), options));
+    std::vector<double> latencies;
+    for (int day = kPhaseOneEnd; day < kDays; day += 25) {
+      ARROW_ASSIGN_OR_RAISE(auto chunk,
+                            AppendDays(store.get(), panel, day, std::min(day + 25, kDays)));
+      latencies.insert(latencies.end(), chunk.begin(), chunk.end());
+      ARROW_ASSIGN_OR_RAISE(auto all, store->Read());
+      if (all->num_rows() != static_cast<int64_t>(std::min(day + 25, kDays)) * kFunds) {
+        return arrow::Status::Invalid("merged view lost rows: ", all->num_rows());
+      }
+    }
+    PrintLatencies("append with background compaction", latencies);
+    PrintStats("background", store->stats());
+    const int32_t recent_date = TradingDay(panel_options.start_date, kDays - 20);
+    ARROW_RETURN_NOT_OK(TimeReads("background", store.get(), recent_date));
+  }
+  // (文档部分: 后台压缩)
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
@@ -0,0 +1,444 @@
+// 只追加的分段净值存储。目录结构：
+//   root/MANIFEST                    当前有效的文件列表，每行 "<类型> <相对路径>"
+//   root/year=2017/seg-000123.arrow  每次追加写一个小的 IPC 段（按年份分区）
+//   root/year=2017/part-000130.parquet  压缩后排序好的大 Parquet 文件（默认按 (fund_code, date)）
+// 追加只写新行所在分区的一个段文件，然后原子地替换 MANIFEST（先写临时文件再 rename），
+// 所以追加的代价只和新行数有关。读取时合并一个分区里的 Parquet 文件和所有段。
+// 后台压缩线程把段数较多的分区合并成一个排序后的 Parquet 文件，之后再删除旧文件；
+// 正在读取旧文件列表的读者结束之前，旧文件不会被删除。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../0014_parquet_nav_writer/nav_writer_properties.h"
+#include "../0015_parquet_pruned_reader/nav_reader.h"
+
+struct SegmentedStoreOptions {
+  // 一个分区的段数达到这个值时，后台线程会压缩它
+  int compact_min_segments = 32;
+  // 后台线程检查的间隔
+  std::chrono::milliseconds compact_interval{200};
+  // 是否启动后台压缩线程，关闭时可以手动调用 Compact
+  bool background_compaction = true;
+  // 压缩后 Parquet 文件的排序键。按基金排序时单只基金的数据是连续的；
+  // 主要按日期范围查询时可以改成 {"date", "fund_code"}，让 row group 统计信息更有效
+  std::vector<std::string> sort_keys = {"fund_code", "date"};
+  NavParquetOptions parquet_options;
+};
+
+struct SegmentedStoreStats {
+  int partitions = 0;
+  int segments = 0;
+  int parquet_files = 0;
+  int compactions = 0;
+  // 当前有效文件的总大小
+  int64_t bytes = 0;
+};
+
+class SegmentedStore {
+ public:
+  enum class FileKind { kSegment, kParquet };
+
+  struct DataFile {
+    FileKind kind;
+    // 相对于 root 的路径，例如 year=2017/seg-000123.arrow
+    std::string path;
+    int32_t year;
+  };
+
+  static arrow::Result<std::unique_ptr<SegmentedStore>> Open(
+      const std::string& root, std::shared_ptr<arrow::Schema> schema,
+      const SegmentedStoreOptions& options = SegmentedStoreOptions()) {
+    std::unique_ptr<SegmentedStore> store(new SegmentedStore(root, std::move(schema), options));
+    std::filesystem::create_directories(root);
+    ARROW_RETURN_NOT_OK(store->LoadManifest());
+    ARROW_RETURN_NOT_OK(store->RemoveUnreferencedFiles());
+    if (options.background_compaction) {
+      store->compactor_ = std::thread([s = store.get()] { s->CompactorLoop(); });
+    }
+    return store;
+  }
+
+  ~SegmentedStore() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_compactor_.notify_all();
+    if (compactor_.joinable()) compactor_.join();
+  }
+
+  // 追加若干行。按年份拆开，每个年份写一个段，然后一次性更新 MANIFEST
+  arrow::Status Append(const std::shared_ptr<arrow::Table>& rows) {
+    if (!rows->schema()->Equals(*schema_, /*check_metadata=*/false)) {
+      return arrow::Status::TypeError("appended rows do not match the store schema");
+    }
+    if (rows->num_rows() == 0) return arrow::Status::OK();
+    ARROW_ASSIGN_OR_RAISE(auto by_year, SplitByYear(rows));
+    std::vector<DataFile> written;
+    for (const auto& [year, table] : by_year) {
+      DataFile file{FileKind::kSegment, "", year};
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        file.path = PartitionDir(year) + "/seg-" + SequenceString(next_sequence_++) + ".arrow";
+      }
+      std::filesystem::create_directories(root_ + "/" + PartitionDir(year));
+      ARROW_RETURN_NOT_OK(WriteSegment(*table, root_ + "/" + file.path));
+      written.push_back(file);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      files_.insert(files_.end(), written.begin(), written.end());
+      ARROW_RETURN_NOT_OK(SaveManifest());
+    }
+    wake_compactor_.notify_all();
+    return arrow::Status::OK();
+  }
+
+  // 合并视图：读取 [min_date, max_date] 内的所有行。
+  // 每个分区先是压缩过的 Parquet 文件（已排序），然后是按追加顺序排列的段
+  arrow::Result<std::shared_ptr<arrow::Table>> Read(
+      int32_t min_date = std::numeric_limits<int32_t>::min(),
+      int32_t max_date = std::numeric_limits<int32_t>::max()) {
+    Snapshot snapshot(this);
+    const int32_t min_year = min_date == std::numeric_limits<int32_t>::min()
+                                 ? std::numeric_limits<int32_t>::min()
+                                 : YearOf(min_date);
+    const int32_t max_year = max_date == std::numeric_limits<int32_t>::max()
+                                 ? std::numeric_limits<int32_t>::max()
+                                 : YearOf(max_date);
+    std::vector<std::shared_ptr<arrow::Table>> pieces;
+    for (FileKind kind : {FileKind::kParquet, FileKind::kSegment}) {
+      for (const auto& file : snapshot.files()) {
+        if (file.kind != kind || file.year < min_year || file.year > max_year) continue;
+        ARROW_ASSIGN_OR_RAISE(auto table, ReadFile(file, min_date, max_date));
+        pieces.push_back(std::move(table));
+      }
+    }
+    if (pieces.empty()) return arrow::Table::MakeEmpty(schema_);
+    return arrow::ConcatenateTables(pieces);
+  }
+
+  // 把一个分区的所有文件合并成一个按 sort_keys 排序的 Parquet 文件。
+  // 读取和写入都不持有锁，压缩期间可以继续追加，新追加的段不受影响。
+  arrow::Status Compact(int32_t year) {
+    // 手动压缩和后台压缩不能同时处理同一批文件
+    std::lock_guard<std::mutex> compaction_lock(compaction_mutex_);
+    std::vector<DataFile> inputs;
+    std::string output_path;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      bool has_segments = false;
+      for (const auto& file : files_) {
+        if (file.year != year) continue;
+        inputs.push_back(file);
+        has_segments |= file.kind == FileKind::kSegment;
+      }
+      // 只剩一个 Parquet 文件的分区不需要压缩
+      if (!has_segments) return arrow::Status::OK();
+      output_path =
+          PartitionDir(year) + "/part-" + SequenceString(next_sequence_++) + ".parquet";
+    }
+    std::vector<std::shared_ptr<arrow::Table>> pieces;
+    for (const auto& file : inputs) {
+      ARROW_ASSIGN_OR_RAISE(auto table, ReadFile(file, std::numeric_limits<int32_t>::min(),
+                                                 std::numeric_limits<int32_t>::max()));
+      pieces.push_back(std::move(table));
+    }
+    ARROW_ASSIGN_OR_RAISE(auto merged, arrow::ConcatenateTables(pieces));
+    arrow::compute::SortOptions sort_options;
+    for (const auto& key : options_.sort_keys) {
+      sort_options.sort_keys.emplace_back(key);
+    }
+    ARROW_ASSIGN_OR_RAISE(auto indices, arrow::compute::SortIndices(merged, sort_options));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum sorted, arrow::compute::Take(merged, indices));
+    ARROW_RETURN_NOT_OK(
+        WriteNavParquet(*sorted.table(), root_ + "/" + output_path, options_.parquet_options));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::set<std::string> replaced;
+    for (const auto& file : inputs) replaced.insert(file.path);
+    std::vector<DataFile> files = {DataFile{FileKind::kParquet, output_path, year}};
+    for (const auto& file : files_) {
+      if (replaced.count(file.path) == 0) files.push_back(file);
+    }
+    files_ = std::move(files);
+    ARROW_RETURN_NOT_OK(SaveManifest());
+    ++compactions_;
+    // 旧文件在当前代数之前的读者都结束后才删除
+    ++generation_;
+    for (const auto& path : replaced) obsolete_.emplace_back(generation_, path);
+    RemoveObsoleteFiles();
+    return arrow::Status::OK();
+  }
+
+  // 压缩所有还有段的分区
+  arrow::Status CompactAll() {
+    for (int32_t year : Years()) ARROW_RETURN_NOT_OK(Compact(year));
+    return arrow::Status::OK();
+  }
+
+  SegmentedStoreStats stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SegmentedStoreStats stats;
+    std::set<int32_t> years;
+    for (const auto& file : files_) {
+      years.insert(file.year);
+      (file.kind == FileKind::kSegment ? stats.segments : stats.parquet_files)++;
+      stats.bytes += static_cast<int64_t>(std::filesystem::file_size(root_ + "/" + file.path));
+    }
+    stats.partitions = static_cast<int>(years.size());
+    stats.compactions = compactions_;
+    return stats;
+  }
+
+  // date32 对应的公历年份
+  static int32_t YearOf(int32_t days) {
+    const int32_t z = days + 719468;
+    const int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const uint32_t doe = static_cast<uint32_t>(z - era * 146097);
+    const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const uint32_t mp = (5 * doy + 2) / 153;
+    const uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    return static_cast<int32_t>(yoe) + era * 400 + (month <= 2);
+  }
+
+ private:
+  // 读者持有的文件列表快照，析构时允许删除它之后被替换掉的文件
+  class Snapshot {
+   public:
+    explicit Snapshot(SegmentedStore* store) : store_(store) {
+      std::lock_guard<std::mutex> lock(store_->mutex_);
+      files_ = store_->files_;
+      generation_ = store_->generation_;
+      ++store_->readers_[generation_];
+    }
+    ~Snapshot() {
+      std::lock_guard<std::mutex> lock(store_->mutex_);
+      if (--store_->readers_[generation_] == 0) store_->readers_.erase(generation_);
+      store_->RemoveObsoleteFiles();
+    }
+    const std::vector<DataFile>& files() const { return files_; }
+
+   private:
+    SegmentedStore* store_;
+    std::vector<DataFile> files_;
+    uint64_t generation_;
+  };
+
+  SegmentedStore(std::string root, std::shared_ptr<arrow::Schema> schema,
+                 const SegmentedStoreOptions& options)
+      : root_(std::move(root)), schema_(std::move(schema)), options_(options) {}
+
+  static std::string PartitionDir(int32_t year) { return "year=" + std::to_string(year); }
+
+  static std::string SequenceString(uint64_t sequence) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%06llu", static_cast<unsigned long long>(sequence));
+    return buf;
+  }
+
+  std::vector<int32_t> Years() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::set<int32_t> years;
+    for (const auto& file : files_) years.insert(file.year);
+    return std::vector<int32_t>(years.begin(), years.end());
+  }
+
+  arrow::Result<std::map<int32_t, std::shared_ptr<arrow::Table>>> SplitByYear(
+      const std::shared_ptr<arrow::Table>& rows) const {
+    ARROW_ASSIGN_OR_RAISE(auto dates, arrow::Concatenate(rows->GetColumnByName("date")->chunks()));
+    const auto& date_values = static_cast<const arrow::Date32Array&>(*dates);
+    std::map<int32_t, std::vector<int64_t>> row_indices;
+    int32_t last_year = 0;
+    int32_t last_days = std::numeric_limits<int32_t>::min();
+    for (int64_t i = 0; i < date_values.length(); ++i) {
+      // 一次追加的行通常都是同一天，缓存上一次的结果
+      if (date_values.Value(i) != last_days) {
+        last_days = date_values.Value(i);
+        last_year = YearOf(last_days);
+      }
+      row_indices[last_year].push_back(i);
+    }
+    std::map<int32_t, std::shared_ptr<arrow::Table>> by_year;
+    if (row_indices.size() == 1) {
+      by_year[row_indices.begin()->first] = rows;
+      return by_year;
+    }
+    for (const auto& [year, indices] : row_indices) {
+      arrow::Int64Builder builder;
+      ARROW_RETURN_NOT_OK(builder.AppendValues(indices));
+      ARROW_ASSIGN_OR_RAISE(auto take_indices, builder.Finish());
+      ARROW_ASSIGN_OR_RAISE(arrow::Datum taken,
+                            arrow::compute::Take(rows, take_indices));
+      by_year[year] = taken.table();
+    }
+    return by_year;
+  }
+
+  static arrow::Status WriteSegment(const arrow::Table& table, const std::string& path) {
+    ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::FileOutputStream::Open(path));
+    ARROW_ASSIGN_OR_RAISE(auto writer, arrow::ipc::MakeFileWriter(outfile, table.schema()));
+    ARROW_RETURN_NOT_OK(writer->WriteTable(table));
+    ARROW_RETURN_NOT_OK(writer->Close());
+    return outfile->Close();
+  }
+
+  arrow::Result<std::shared_ptr<arrow::Table>> ReadFile(const DataFile& file, int32_t min_date,
+                                                        int32_t max_date) const {
+    const std::string path = root_ + "/" + file.path;
+    if (file.kind == FileKind::kParquet) {
+      // Parquet 文件用 0015 的读取器，可以按统计信息跳过 row group
+      NavReadOptions read_options;
+      read_options.min_date = min_date;
+      read_options.max_date = max_date;
+      return ReadNavParquet(path, read_options);
+    }
+    ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+    ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(infile));
+    arrow::RecordBatchVector batches;
+    for (int i = 0; i < reader->num_record_batches(); ++i) {
+      ARROW_ASSIGN_OR_RAISE(auto batch, reader->ReadRecordBatch(i));
+      batches.push_back(std::move(batch));
+    }
+    ARROW_ASSIGN_OR_RAISE(auto table, arrow::Table::FromRecordBatches(schema_, batches));
+    if (min_date == std::numeric_limits<int32_t>::min() &&
+        max_date == std::numeric_limits<int32_t>::max()) {
+      return table;
+    }
+    auto date = table->GetColumnByName("date");
+    ARROW_ASSIGN_OR_RAISE(
+        arrow::Datum lower,
+        arrow::compute::CallFunction("greater_equal",
+                                     {date, std::make_shared<arrow::Date32Scalar>(min_date)}));
+    ARROW_ASSIGN_OR_RAISE(
+        arrow::Datum upper,
+        arrow::compute::CallFunction("less_equal",
+                                     {date, std::make_shared<arrow::Date32Scalar>(max_date)}));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum mask, arrow::compute::And(lower, upper));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum filtered, arrow::compute::Filter(table, mask));
+    return filtered.table();
+  }
+
+  // 调用者持有 mutex_
+  arrow::Status SaveManifest() {
+    const std::string path = root_ + "/MANIFEST";
+    const std::string temp = path + ".tmp";
+    {
+      std::ofstream out(temp, std::ios::trunc);
+      out << "next_sequence " << next_sequence_ << "\n";
+      for (const auto& file : files_) {
+        out << (file.kind == FileKind::kSegment ? "segment " : "parquet ") << file.year << " "
+            << file.path << "\n";
+      }
+      if (!out.good()) return arrow::Status::IOError("cannot write ", temp);
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+      return arrow::Status::IOError("cannot rename ", temp, " to ", path);
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status LoadManifest() {
+    std::ifstream in(root_ + "/MANIFEST");
+    if (!in) return arrow::Status::OK();
+    std::string kind;
+    while (in >> kind) {
+      if (kind == "next_sequence") {
+        in >> next_sequence_;
+        continue;
+      }
+      DataFile file;
+      file.kind = kind == "segment" ? FileKind::kSegment : FileKind::kParquet;
+      if (!(in >> file.year >> file.path)) {
+        return arrow::Status::IOError("corrupt manifest in ", root_);
+      }
+      files_.push_back(file);
+    }
+    return arrow::Status::OK();
+  }
+
+  // 删除崩溃时留下的、不在 MANIFEST 中的文件
+  arrow::Status RemoveUnreferencedFiles() {
+    std::set<std::string> live;
+    for (const auto& file : files_) live.insert(file.path);
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(root_)) {
+      if (!entry.is_regular_file()) continue;
+      const std::string relative = std::filesystem::relative(entry.path(), root_).string();
+      if (relative == "MANIFEST" || live.count(relative) > 0) continue;
+      std::filesystem::remove(entry.path());
+    }
+    return arrow::Status::OK();
+  }
+
+  // 调用者持有 mutex_。obsolete_ 中的文件在代数 g 时被替换，
+  // 只有代数小于 g 的读者还可能用到它
+  void RemoveObsoleteFiles() {
+    const uint64_t oldest_reader =
+        readers_.empty() ? std::numeric_limits<uint64_t>::max() : readers_.begin()->first;
+    std::vector<std::pair<uint64_t, std::string>> remaining;
+    for (const auto& [generation, path] : obsolete_) {
+      if (oldest_reader >= generation) {
+        std::filesystem::remove(root_ + "/" + path);
+      } else {
+        remaining.emplace_back(generation, path);
+      }
+    }
+    obsolete_ = std::move(remaining);
+  }
+
+  void CompactorLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+      wake_compactor_.wait_for(lock, options_.compact_interval);
+      if (stopping_) break;
+      std::map<int32_t, int> segments;
+      for (const auto& file : files_) {
+        if (file.kind == FileKind::kSegment) ++segments[file.year];
+      }
+      for (const auto& [year, count] : segments) {
+        if (count < options_.compact_min_segments || stopping_) continue;
+        lock.unlock();
+        arrow::Status st = Compact(year);
+        if (!st.ok()) std::cerr << "compaction of " << year << " failed: " << st << std::endl;
+        lock.lock();
+      }
+    }
+  }
+
+  const std::string root_;
+  const std::shared_ptr<arrow::Schema> schema_;
+  const SegmentedStoreOptions options_;
+
+  std::mutex compaction_mutex_;
+  std::mutex mutex_;
+  std::vector<DataFile> files_;
+  uint64_t next_sequence_ = 0;
+  // 每次压缩加一；readers_ 记录每个代数上还在读的读者数
+  uint64_t generation_ = 0;
+  std::map<uint64_t, int> readers_;
+  std::vector<std::pair<uint64_t, std::string>> obsolete_;
+  int compactions_ = 0;
+
+  bool stopping_ = false;
+  std::condition_variable wake_compactor_;
+  std::thread compactor_;
+};
@@ -0,0 +1,169 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/csv/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/writer.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "../fund_panel/fund_panel.h"
+#include "stream_convert.h"
+// (文档部分: 包含)
+
+// 用法：
+//   my_example <input> <output> [--batch-size N] [--csv-block-size BYTES]
+//              [--row-group-rows N] [--ipc-codec none|lz4|zstd] [--no-threads]
+// 格式由扩展名决定（.csv、.arrow / .ipc / .feather、.parquet）。
+// 不带参数时生成一个 CSV 文件，演示各种格式之间的转换。
+
+// 先把内存池缓存的空闲内存还给系统，再清零进程的峰值 RSS（VmHWM），
+// 之后读到的是从这里开始的峰值
+void ResetPeakRss() {
+  arrow::default_memory_pool()->ReleaseUnused();
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+}
+
+double PeakRssMb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) return std::stol(line.substr(6)) / 1024.0;
+  }
+  return 0;
+}
+
+void PrintStats(const std::string& name, const ConvertStats& stats, double peak_rss_mb) {
+  std::cout << name << ": " << stats.rows << " rows in " << stats.batches << " batches, "
+            << stats.input_bytes / (1 << 20) << " MB -> " << stats.output_bytes / (1 << 20)
+            << " MB, " << stats.seconds << " s, " << stats.input_bytes / stats.seconds / (1 << 20)
+            << " MB/s in, " << stats.rows / stats.seconds / 1e6 << " M rows/s, peak RSS "
+            << peak_rss_mb << " MB" << std::endl;
+}
+
+arrow::Status Convert(const std::string& input, const std::string& output,
+                      const ConvertOptions& options) {
+  ResetPeakRss();
+  ConvertStats stats;
+  ARROW_RETURN_NOT_OK(ConvertFile(input, output, options, &stats));
+  PrintStats(input + " -> " + output, stats, PeakRssMb());
+  return arrow::Status::OK();
+}
+
+// 分块生成 CSV，每块用不同的随机数种子，内存中最多只有一块
+arrow::Status WriteCsv(const std::string& path, int chunks) {
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+  for (int chunk = 0; chunk < chunks; ++chunk) {
+    FundPanelOptions panel_options;
+    panel_options.num_funds = 1000;
+    panel_options.num_days = 1000;
+    panel_options.seed = 42 + chunk;
+    ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+    if (writer == nullptr) {
+      ARROW_ASSIGN_OR_RAISE(writer, OpenBatchWriter(path, panel->schema()));
+    }
+    ARROW_RETURN_NOT_OK(writer->WriteTable(*panel));
+  }
+  return writer->Close();
+}
+
+// (文档部分: 整表转换)
+// 0002_io 的做法：整个 CSV 读成一张表再写 Parquet，内存随文件大小增长
+arrow::Status ConvertWholeTable(const std::string& input, const std::string& output) {
+  ResetPeakRss();
+  auto start_time = std::chrono::steady_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(input));
+  auto convert_options = arrow::csv::ConvertOptions::Defaults();
+  auto schema = FundPanelSchema();
+  for (const auto& field : schema->fields()) {
+    convert_options.column_types[field->name()] = field->type();
+  }
+  ARROW_ASSIGN_OR_RAISE(auto csv_reader,
+                        arrow::csv::TableReader::Make(
+                            arrow::io::default_io_context(), infile,
+                            arrow::csv::ReadOptions::Defaults(),
+                            arrow::csv::ParseOptions::Defaults(), convert_options));
+  ARROW_ASSIGN_OR_RAISE(auto table, csv_reader->Read());
+  ARROW_RETURN_NOT_OK(WriteNavParquet(*table, output));
+  ConvertStats stats;
+  stats.rows = table->num_rows();
+  stats.batches = 1;
+  stats.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  ARROW_ASSIGN_OR_RAISE(stats.input_bytes, infile->GetSize());
+  ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::ReadableFile::Open(output));
+  ARROW_ASSIGN_OR_RAISE(stats.output_bytes, outfile->GetSize());
+  PrintStats("whole table " + input + " -> " + output, stats, PeakRssMb());
+  return arrow::Status::OK();
+}
+// (文档部分: 整表转换)
+
+arrow::Status RunDemo() {
+  ARROW_RETURN_NOT_OK(WriteCsv("panel.csv", 10));
+  ConvertOptions options;
+  options.csv_schema = FundPanelSchema();
+
+  // (文档部分: 流式转换)
+  ARROW_RETURN_NOT_OK(Convert("panel.csv", "panel.parquet", options));
+  ARROW_RETURN_NOT_OK(Convert("panel.parquet", "panel.arrow", options));
+  ARROW_RETURN_NOT_OK(Convert("panel.arrow", "panel_copy.csv", options));
+  ARROW_RETURN_NOT_OK(Convert("panel.csv", "panel_copy.arrow", options));
+  ARROW_RETURN_NOT_OK(Convert("panel.arrow", "panel_copy.parquet", options));
+  ARROW_RETURN_NOT_OK(Convert("panel.parquet", "panel_copy2.csv", options));
+  // (文档部分: 流式转换)
+
+  // (文档部分: 参数)
+  // row group 大小决定写 Parquet 时缓存的行数，也影响压缩率
+  for (int64_t row_group_rows : {64 * 1024, 256 * 1024}) {
+    ConvertOptions small = options;
+    small.parquet_options.row_group_rows = row_group_rows;
+    std::cout << "row_group_rows " << row_group_rows << ", ";
+    ARROW_RETURN_NOT_OK(Convert("panel.csv", "panel.parquet", small));
+  }
+  ConvertOptions single = options;
+  single.use_threads = false;
+  std::cout << "single thread, ";
+  ARROW_RETURN_NOT_OK(Convert("panel.csv", "panel.parquet", single));
+  // (文档部分: 参数)
+
+  return ConvertWholeTable("panel.csv", "panel_whole.parquet");
+}
+
+arrow::Status RunMain(int argc, char** argv) {
+  if (argc < 3) return RunDemo();
+  ConvertOptions options;
+  for (int i = 3; i < argc; ++i) {
+    const std::string flag = argv[i];
+    if (flag == "--no-threads") {
+      options.use_threads = false;
+      continue;
+    }
+    if (i + 1 >= argc) return arrow::Status::Invalid("missing value for ", flag);
+    const std::string value = argv[++i];
+    if (flag == "--batch-size") {
+      options.batch_size = std::stoll(value);
+    } else if (flag == "--csv-block-size") {
+      options.csv_block_size = std::stoi(value);
+    } else if (flag == "--row-group-rows") {
+      options.parquet_options.row_group_rows = std::stoll(value);
+    } else if (flag == "--ipc-codec") {
+      ARROW_ASSIGN_OR_RAISE(options.ipc_options.codec, ParseIpcCodec(value));
+    } else {
+      return arrow::Status::Invalid("unknown flag ", flag);
+    }
+  }
+  return Convert(argv[1], argv[2], options);
+}
+
+// (文档部分: 主函数)
+int main(int argc, char** argv) {
+  arrow::Status st = RunMain(argc, argv);
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
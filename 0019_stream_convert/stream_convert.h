@@ -0,0 +1,270 @@
+// CSV、IPC 文件、Parquet 三种格式之间的流式转换。
+// 读端统一成 arrow::RecordBatchReader，写端统一成 arrow::ipc::RecordBatchWriter，
+// 一次只在内存里保留少量 batch，所以内存占用和输入文件大小无关：
+//   CSV     读：csv::StreamingReader，按 block_size 字节切块，多线程解析；
+//           写：csv::MakeCSVWriter。
+//   IPC     读：RecordBatchFileReader 逐个读 batch；写：ipc::MakeFileWriter，可压缩（见 0012）。
+//   Parquet 读：FileReader::GetRecordBatchReader，每次最多解码一个 row group；
+//           写：parquet::arrow::FileWriter::WriteRecordBatch，最多缓存一个 row group 的行，
+//           用 0014 的写入配置，多列并行编码。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/csv/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
+
+#include <chrono>
+#include <string>
+
+#include "../0012_ipc_compression/ipc_compression.h"
+#include "../0014_parquet_nav_writer/nav_writer_properties.h"
+
+enum class FileFormat { kCsv, kIpc, kParquet };
+
+struct ConvertOptions {
+  // 输出 batch 的最大行数，也是 Parquet 读取时每个 batch 的行数
+  int64_t batch_size = 64 * 1024;
+  // CSV 每次读取的字节数，决定 CSV 读出来的 batch 大小。
+  // StreamingReader 会预读多个 block，block 越大峰值内存越高
+  int32_t csv_block_size = 1 << 20;
+  // CSV 的列类型。不指定时由第一个 block 推断，后面的 block 类型不一致时会报错
+  std::shared_ptr<arrow::Schema> csv_schema;
+  // 多线程解析 CSV、解码 Parquet、编码 Parquet 列和压缩 IPC buffer
+  bool use_threads = true;
+  // Parquet 输出的 row group 大小和压缩，row_group_rows 决定写 Parquet 时缓存的行数
+  NavParquetOptions parquet_options;
+  IpcCompressionOptions ipc_options;
+};
+
+struct ConvertStats {
+  int64_t batches = 0;
+  int64_t rows = 0;
+  int64_t input_bytes = 0;
+  int64_t output_bytes = 0;
+  double seconds = 0;
+};
+
+// 根据扩展名判断格式：.csv、.parquet、.arrow / .ipc / .feather
+inline arrow::Result<FileFormat> FormatFromPath(const std::string& path) {
+  auto ends_with = [&](const std::string& suffix) {
+    return path.size() >= suffix.size() &&
+           path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+  };
+  if (ends_with(".csv")) return FileFormat::kCsv;
+  if (ends_with(".parquet")) return FileFormat::kParquet;
+  if (ends_with(".arrow") || ends_with(".ipc") || ends_with(".feather")) return FileFormat::kIpc;
+  return arrow::Status::Invalid("unknown file format: ", path);
+}
+
+namespace stream_convert_internal {
+
+// 把 IPC 文件的随机访问读取器包装成顺序的 RecordBatchReader
+class IpcFileBatchReader : public arrow::RecordBatchReader {
+ public:
+  explicit IpcFileBatchReader(std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader)
+      : reader_(std::move(reader)) {}
+
+  std::shared_ptr<arrow::Schema> schema() const override { return reader_->schema(); }
+
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* batch) override {
+    if (next_ >= reader_->num_record_batches()) {
+      batch->reset();
+      return arrow::Status::OK();
+    }
+    return reader_->ReadRecordBatch(next_++).Value(batch);
+  }
+
+ private:
+  std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader_;
+  int next_ = 0;
+};
+
+// GetRecordBatchReader 返回的读取器引用 FileReader，两者要一起保存
+class ParquetBatchReader : public arrow::RecordBatchReader {
+ public:
+  ParquetBatchReader(std::unique_ptr<parquet::arrow::FileReader> file_reader,
+                     std::unique_ptr<arrow::RecordBatchReader> reader)
+      : file_reader_(std::move(file_reader)), reader_(std::move(reader)) {}
+
+  std::shared_ptr<arrow::Schema> schema() const override { return reader_->schema(); }
+
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* batch) override {
+    return reader_->ReadNext(batch);
+  }
+
+ private:
+  std::unique_ptr<parquet::arrow::FileReader> file_reader_;
+  std::unique_ptr<arrow::RecordBatchReader> reader_;
+};
+
+// 让 Parquet FileWriter 和 IPC、CSV 的写入器有相同的接口
+class ParquetBatchWriter : public arrow::ipc::RecordBatchWriter {
+ public:
+  ParquetBatchWriter(std::unique_ptr<parquet::arrow::FileWriter> writer,
+                     std::shared_ptr<arrow::io::OutputStream> sink)
+      : writer_(std::move(writer)), sink_(std::move(sink)) {}
+
+  arrow::Status WriteRecordBatch(const arrow::RecordBatch& batch) override {
+    ++stats_.num_record_batches;
+    // 行先进入缓存的 row group，达到 max_row_group_length 时才编码并写出
+    return writer_->WriteRecordBatch(batch);
+  }
+
+  arrow::Status Close() override {
+    ARROW_RETURN_NOT_OK(writer_->Close());
+    return sink_->Close();
+  }
+
+  arrow::ipc::WriteStats stats() const override { return stats_; }
+
+ private:
+  std::unique_ptr<parquet::arrow::FileWriter> writer_;
+  std::shared_ptr<arrow::io::OutputStream> sink_;
+  arrow::ipc::WriteStats stats_;
+};
+
+// IPC 和 CSV 写入器 Close 时不会关闭输出文件，这里一起关闭
+class ClosingBatchWriter : public arrow::ipc::RecordBatchWriter {
+ public:
+  ClosingBatchWriter(std::shared_ptr<arrow::ipc::RecordBatchWriter> writer,
+                     std::shared_ptr<arrow::io::OutputStream> sink)
+      : writer_(std::move(writer)), sink_(std::move(sink)) {}
+
+  arrow::Status WriteRecordBatch(const arrow::RecordBatch& batch) override {
+    return writer_->WriteRecordBatch(batch);
+  }
+
+  arrow::Status Close() override {
+    ARROW_RETURN_NOT_OK(writer_->Close());
+    return sink_->Close();
+  }
+
+  arrow::ipc::WriteStats stats() const override { return writer_->stats(); }
+
+ private:
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer_;
+  std::shared_ptr<arrow::io::OutputStream> sink_;
+};
+
+}  // namespace stream_convert_internal
+
+// 按扩展名打开输入文件，返回逐个 batch 读取的读取器
+inline arrow::Result<std::shared_ptr<arrow::RecordBatchReader>> OpenBatchReader(
+    const std::string& path, const ConvertOptions& options = ConvertOptions()) {
+  ARROW_ASSIGN_OR_RAISE(FileFormat format, FormatFromPath(path));
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  switch (format) {
+    case FileFormat::kCsv: {
+      auto read_options = arrow::csv::ReadOptions::Defaults();
+      read_options.use_threads = options.use_threads;
+      read_options.block_size = options.csv_block_size;
+      auto convert_options = arrow::csv::ConvertOptions::Defaults();
+      if (options.csv_schema != nullptr) {
+        for (const auto& field : options.csv_schema->fields()) {
+          convert_options.column_types[field->name()] = field->type();
+        }
+      }
+      ARROW_ASSIGN_OR_RAISE(
+          auto reader,
+          arrow::csv::StreamingReader::Make(arrow::io::default_io_context(), infile, read_options,
+                                            arrow::csv::ParseOptions::Defaults(),
+                                            convert_options));
+      return reader;
+    }
+    case FileFormat::kIpc: {
+      ARROW_ASSIGN_OR_RAISE(
+          auto reader, arrow::ipc::RecordBatchFileReader::Open(
+                           infile, MakeIpcReadOptions(options.use_threads)));
+      return std::make_shared<stream_convert_internal::IpcFileBatchReader>(std::move(reader));
+    }
+    case FileFormat::kParquet: {
+      parquet::ArrowReaderProperties properties;
+      properties.set_batch_size(options.batch_size);
+      properties.set_use_threads(options.use_threads);
+      properties.set_pre_buffer(true);
+      parquet::arrow::FileReaderBuilder builder;
+      ARROW_RETURN_NOT_OK(builder.Open(infile));
+      std::unique_ptr<parquet::arrow::FileReader> file_reader;
+      ARROW_RETURN_NOT_OK(builder.properties(properties)->Build(&file_reader));
+      ARROW_ASSIGN_OR_RAISE(auto reader, file_reader->GetRecordBatchReader());
+      return std::make_shared<stream_convert_internal::ParquetBatchReader>(
+          std::move(file_reader), std::move(reader));
+    }
+  }
+  return arrow::Status::Invalid("unknown file format: ", path);
+}
+
+// 按扩展名创建输出文件，返回逐个 batch 写入的写入器，Close 时同时关闭文件
+inline arrow::Result<std::shared_ptr<arrow::ipc::RecordBatchWriter>> OpenBatchWriter(
+    const std::string& path, const std::shared_ptr<arrow::Schema>& schema,
+    const ConvertOptions& options = ConvertOptions()) {
+  ARROW_ASSIGN_OR_RAISE(FileFormat format, FormatFromPath(path));
+  ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::FileOutputStream::Open(path));
+  switch (format) {
+    case FileFormat::kCsv: {
+      ARROW_ASSIGN_OR_RAISE(auto writer, arrow::csv::MakeCSVWriter(outfile, schema));
+      return std::make_shared<stream_convert_internal::ClosingBatchWriter>(std::move(writer),
+                                                                           outfile);
+    }
+    case FileFormat::kIpc: {
+      IpcCompressionOptions ipc_options = options.ipc_options;
+      ipc_options.use_threads = options.use_threads;
+      ARROW_ASSIGN_OR_RAISE(auto write_options, MakeIpcWriteOptions(ipc_options));
+      ARROW_ASSIGN_OR_RAISE(auto writer,
+                            arrow::ipc::MakeFileWriter(outfile, schema, write_options));
+      return std::make_shared<stream_convert_internal::ClosingBatchWriter>(std::move(writer),
+                                                                           outfile);
+    }
+    case FileFormat::kParquet: {
+      auto arrow_properties = parquet::ArrowWriterProperties::Builder()
+                                  .store_schema()
+                                  ->set_use_threads(options.use_threads)
+                                  ->build();
+      ARROW_ASSIGN_OR_RAISE(
+          auto writer,
+          parquet::arrow::FileWriter::Open(*schema, arrow::default_memory_pool(), outfile,
+                                           NavWriterProperties(*schema, options.parquet_options),
+                                           arrow_properties));
+      return std::make_shared<stream_convert_internal::ParquetBatchWriter>(std::move(writer),
+                                                                           outfile);
+    }
+  }
+  return arrow::Status::Invalid("unknown file format: ", path);
+}
+
+// 把 input 转换成 output，格式由扩展名决定。超过 batch_size 行的 batch 会被切开再写出
+inline arrow::Status ConvertFile(const std::string& input, const std::string& output,
+                                 const ConvertOptions& options = ConvertOptions(),
+                                 ConvertStats* stats = nullptr) {
+  if (options.batch_size <= 0) {
+    return arrow::Status::Invalid("batch_size must be positive, got ", options.batch_size);
+  }
+  auto start_time = std::chrono::steady_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto reader, OpenBatchReader(input, options));
+  ARROW_ASSIGN_OR_RAISE(auto writer, OpenBatchWriter(output, reader->schema(), options));
+  ConvertStats local;
+  while (true) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    ARROW_RETURN_NOT_OK(reader->ReadNext(&batch));
+    if (batch == nullptr) break;
+    for (int64_t offset = 0; offset < batch->num_rows(); offset += options.batch_size) {
+      ARROW_RETURN_NOT_OK(writer->WriteRecordBatch(*batch->Slice(offset, options.batch_size)));
+      ++local.batches;
+    }
+    local.rows += batch->num_rows();
+  }
+  ARROW_RETURN_NOT_OK(writer->Close());
+  local.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  if (stats != nullptr) {
+    ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(input));
+    ARROW_ASSIGN_OR_RAISE(local.input_bytes, infile->GetSize());
+    ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::ReadableFile::Open(output));
+    ARROW_ASSIGN_OR_RAISE(local.output_bytes, outfile->GetSize());
+    *stats = local;
+  }
+  return arrow::Status::OK();
+}
@@ -0,0 +1,158 @@
+// 把很多小 batch 攒成大 batch 再交给下游写入器（IPC 文件、Parquet 等，见 0019 的 OpenBatchWriter）。
+// 每个 IPC message 和每个 Parquet row group 都有固定的元数据和编码开销，
+// 一行一个 batch 时文件会变大，读取时大部分时间花在处理元数据上。
+// 缓存的行数或字节数达到目标、最早一个 batch 等待超过 max_delay、或者 Close 时写出：
+//   - 缓存中只有一个 batch 时直接交给下游，不复制；
+//   - 本身已经够大的 batch 在写出缓存后直接交给下游；
+//   - 其他情况每列调用一次 arrow::Concatenate，每个值只复制一次。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/ipc/api.h>
+#include <arrow/util/byte_size.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+struct CoalescingOptions {
+  // 缓存的行数达到这个值时写出
+  int64_t target_rows = 64 * 1024;
+  // 缓存引用的数据量（字节）达到这个值时写出
+  int64_t target_bytes = 8 << 20;
+  // 最早缓存的 batch 等待超过这个时间时写出，避免数据来得慢时长期停留在内存里。
+  // 只在 WriteRecordBatch 和 FlushIfExpired 中检查
+  std::chrono::milliseconds max_delay{1000};
+};
+
+struct CoalescingStats {
+  int64_t batches_in = 0;
+  int64_t batches_out = 0;
+  // 直接交给下游、没有复制的 batch 数
+  int64_t passed_through = 0;
+  // 各种原因触发的写出次数
+  int64_t flushes_by_rows = 0;
+  int64_t flushes_by_bytes = 0;
+  int64_t flushes_by_time = 0;
+  int64_t flushes_by_close = 0;
+};
+
+// 估计一个 batch 引用的数据量。arrow::util::ReferencedBufferSize 对一行的小 batch 太慢，
+// 这里只处理定长类型和字符串，其他类型再交给它
+inline arrow::Result<int64_t> EstimateBatchBytes(const arrow::RecordBatch& batch) {
+  int64_t bytes = 0;
+  for (const auto& column : batch.columns()) {
+    const auto& type = *column->type();
+    const int64_t length = column->length();
+    if (column->null_count() != 0) bytes += (length + 7) / 8;
+    if (arrow::is_fixed_width(type.id())) {
+      bytes += length * static_cast<const arrow::FixedWidthType&>(type).bit_width() / 8;
+    } else if (type.id() == arrow::Type::STRING || type.id() == arrow::Type::BINARY) {
+      const auto& strings = static_cast<const arrow::BinaryArray&>(*column);
+      bytes += (length + 1) * sizeof(int32_t) + strings.value_offset(length) -
+               strings.value_offset(0);
+    } else {
+      ARROW_ASSIGN_OR_RAISE(int64_t referenced, arrow::util::ReferencedBufferSize(*column));
+      bytes += referenced;
+    }
+  }
+  return bytes;
+}
+
+class CoalescingBatchWriter : public arrow::ipc::RecordBatchWriter {
+ public:
+  CoalescingBatchWriter(std::shared_ptr<arrow::ipc::RecordBatchWriter> sink,
+                        std::shared_ptr<arrow::Schema> schema,
+                        const CoalescingOptions& options = CoalescingOptions())
+      : sink_(std::move(sink)), schema_(std::move(schema)), options_(options) {}
+
+  arrow::Status WriteRecordBatch(const arrow::RecordBatch& batch) override {
+    if (!batch.schema()->Equals(*schema_, /*check_metadata=*/false)) {
+      return arrow::Status::Invalid("batch schema does not match the writer schema");
+    }
+    ++stats_.batches_in;
+    if (batch.num_rows() == 0) return arrow::Status::OK();
+    // 已经够大的 batch 不进缓存，保持先后顺序
+    if (batch.num_rows() >= options_.target_rows) {
+      ARROW_RETURN_NOT_OK(Flush());
+      ++stats_.passed_through;
+      return WriteOut(batch);
+    }
+    if (pending_.empty()) oldest_ = std::chrono::steady_clock::now();
+    ARROW_ASSIGN_OR_RAISE(int64_t bytes, EstimateBatchBytes(batch));
+    // 这里拿不到 batch 的 shared_ptr，只复制列的引用，不复制数据
+    pending_.push_back(arrow::RecordBatch::Make(schema_, batch.num_rows(), batch.columns()));
+    pending_rows_ += batch.num_rows();
+    pending_bytes_ += bytes;
+    if (pending_rows_ >= options_.target_rows) {
+      ++stats_.flushes_by_rows;
+      return Flush();
+    }
+    if (pending_bytes_ >= options_.target_bytes) {
+      ++stats_.flushes_by_bytes;
+      return Flush();
+    }
+    return FlushIfExpired();
+  }
+
+  // 数据来得慢时由调用者定期调用，把等待超过 max_delay 的缓存写出
+  arrow::Status FlushIfExpired() {
+    if (pending_.empty() ||
+        std::chrono::steady_clock::now() - oldest_ < options_.max_delay) {
+      return arrow::Status::OK();
+    }
+    ++stats_.flushes_by_time;
+    return Flush();
+  }
+
+  // 把缓存合并成一个 batch 写给下游
+  arrow::Status Flush() {
+    if (pending_.empty()) return arrow::Status::OK();
+    std::shared_ptr<arrow::RecordBatch> merged;
+    if (pending_.size() == 1) {
+      merged = pending_.front();
+      ++stats_.passed_through;
+    } else {
+      std::vector<std::shared_ptr<arrow::Array>> columns;
+      for (int i = 0; i < schema_->num_fields(); ++i) {
+        arrow::ArrayVector chunks;
+        chunks.reserve(pending_.size());
+        for (const auto& batch : pending_) chunks.push_back(batch->column(i));
+        ARROW_ASSIGN_OR_RAISE(auto column, arrow::Concatenate(chunks));
+        columns.push_back(std::move(column));
+      }
+      merged = arrow::RecordBatch::Make(schema_, pending_rows_, std::move(columns));
+    }
+    pending_.clear();
+    pending_rows_ = 0;
+    pending_bytes_ = 0;
+    return WriteOut(*merged);
+  }
+
+  arrow::Status Close() override {
+    if (!pending_.empty()) ++stats_.flushes_by_close;
+    ARROW_RETURN_NOT_OK(Flush());
+    return sink_->Close();
+  }
+
+  // 下游写入器的统计（写出的 message 数等）
+  arrow::ipc::WriteStats stats() const override { return sink_->stats(); }
+
+  const CoalescingStats& coalescing_stats() const { return stats_; }
+
+ private:
+  arrow::Status WriteOut(const arrow::RecordBatch& batch) {
+    ++stats_.batches_out;
+    return sink_->WriteRecordBatch(batch);
+  }
+
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> sink_;
+  std::shared_ptr<arrow::Schema> schema_;
+  const CoalescingOptions options_;
+
+  std::vector<std::shared_ptr<arrow::RecordBatch>> pending_;
+  int64_t pending_rows_ = 0;
+  int64_t pending_bytes_ = 0;
+  std::chrono::steady_clock::time_point oldest_;
+  CoalescingStats stats_;
+};
@@ -0,0 +1,169 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "../0019_stream_convert/stream_convert.h"
+#include "../fund_panel/fund_panel.h"
+#include "coalescing_writer.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+arrow::Result<int64_t> FileSize(const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  return infile->GetSize();
+}
+
+// 模拟行情推送：每个 batch 只有一只基金一天的一行
+std::vector<std::shared_ptr<arrow::RecordBatch>> TinyBatches(
+    const std::shared_ptr<arrow::RecordBatch>& panel) {
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  for (int64_t i = 0; i < panel->num_rows(); ++i) batches.push_back(panel->Slice(i, 1));
+  return batches;
+}
+
+// (文档部分: 不合并)
+// 每个小 batch 直接写成一个 IPC message
+arrow::Status WriteIpcUncoalesced(const std::string& path,
+                                  const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches) {
+  ARROW_ASSIGN_OR_RAISE(auto writer, OpenBatchWriter(path, batches.front()->schema()));
+  for (const auto& batch : batches) ARROW_RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+  return writer->Close();
+}
+
+// 每个小 batch 写成一个 Parquet row group（每来一批就 WriteTable 一次）
+arrow::Status WriteParquetUncoalesced(
+    const std::string& path, const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches) {
+  auto schema = batches.front()->schema();
+  ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::FileOutputStream::Open(path));
+  ARROW_ASSIGN_OR_RAISE(
+      auto writer, parquet::arrow::FileWriter::Open(*schema, arrow::default_memory_pool(),
+                                                    outfile, NavWriterProperties(*schema),
+                                                    NavArrowWriterProperties()));
+  for (const auto& batch : batches) {
+    ARROW_ASSIGN_OR_RAISE(auto table, arrow::Table::FromRecordBatches({batch}));
+    ARROW_RETURN_NOT_OK(writer->WriteTable(*table, batch->num_rows()));
+  }
+  ARROW_RETURN_NOT_OK(writer->Close());
+  return outfile->Close();
+}
+// (文档部分: 不合并)
+
+// (文档部分: 合并)
+arrow::Result<CoalescingStats> WriteCoalesced(
+    const std::string& path, const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches,
+    const CoalescingOptions& coalescing_options) {
+  auto schema = batches.front()->schema();
+  ConvertOptions convert_options;
+  convert_options.parquet_options.row_group_rows = coalescing_options.target_rows;
+  ARROW_ASSIGN_OR_RAISE(auto sink, OpenBatchWriter(path, schema, convert_options));
+  CoalescingBatchWriter writer(sink, schema, coalescing_options);
+  for (const auto& batch : batches) ARROW_RETURN_NOT_OK(writer.WriteRecordBatch(*batch));
+  ARROW_RETURN_NOT_OK(writer.Close());
+  return writer.coalescing_stats();
+}
+// (文档部分: 合并)
+
+// (文档部分: 读取)
+// 读出整个文件并对 nav 求和，返回 batch 数（IPC message 或 Parquet row group）
+arrow::Result<int> ReadAndSum(const std::string& path, double* sum) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path));
+  std::shared_ptr<arrow::Table> table;
+  int pieces = 0;
+  ARROW_ASSIGN_OR_RAISE(FileFormat format, FormatFromPath(path));
+  if (format == FileFormat::kParquet) {
+    ARROW_ASSIGN_OR_RAISE(auto reader,
+                          parquet::arrow::OpenFile(infile, arrow::default_memory_pool()));
+    pieces = reader->num_row_groups();
+    ARROW_ASSIGN_OR_RAISE(table, reader->ReadTable());
+  } else {
+    ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(infile));
+    pieces = reader->num_record_batches();
+    ARROW_ASSIGN_OR_RAISE(table, reader->ToTable());
+  }
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum total, arrow::compute::Sum(table->GetColumnByName("nav")));
+  *sum = total.scalar_as<arrow::DoubleScalar>().value;
+  return pieces;
+}
+// (文档部分: 读取)
+
+arrow::Status Report(const std::string& name, const std::string& path, double write_ms) {
+  ARROW_ASSIGN_OR_RAISE(int64_t size, FileSize(path));
+  double sum = 0;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(int pieces, ReadAndSum(path, &sum));
+  const double read_ms = ElapsedMs(start_time);
+  std::cout << name << ": write " << write_ms << " ms, " << size / 1024 << " KB, " << pieces
+            << (name.compare(0, 7, "parquet") == 0 ? " row groups" : " messages") << ", read "
+            << read_ms << " ms (sum " << sum << ")" << std::endl;
+  return arrow::Status::OK();
+}
+
+arrow::Status RunMain() {
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 100;
+  panel_options.num_days = 500;
+  panel_options.date_major = true;
+  ARROW_ASSIGN_OR_RAISE(auto table, MakeFundPanel(panel_options));
+  ARROW_ASSIGN_OR_RAISE(auto panel, table->CombineChunksToBatch());
+  auto batches = TinyBatches(panel);
+  std::cout << batches.size() << " one-row batches" << std::endl;
+
+  CoalescingOptions coalescing_options;
+  coalescing_options.target_rows = 16 * 1024;
+  for (const std::string format : {"arrow", "parquet"}) {
+    const std::string tiny = "tiny." + format;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ARROW_RETURN_NOT_OK(format == "arrow" ? WriteIpcUncoalesced(tiny, batches)
+                                          : WriteParquetUncoalesced(tiny, batches));
+    ARROW_RETURN_NOT_OK(Report(format + " uncoalesced", tiny, ElapsedMs(start_time)));
+
+    const std::string coalesced = "coalesced." + format;
+    start_time = std::chrono::high_resolution_clock::now();
+    ARROW_ASSIGN_OR_RAISE(auto stats, WriteCoalesced(coalesced, batches, coalescing_options));
+    ARROW_RETURN_NOT_OK(Report(format + " coalesced", coalesced, ElapsedMs(start_time)));
+    std::cout << "  " << stats.batches_in << " batches in, " << stats.batches_out
+              << " out, flushes by rows " << stats.flushes_by_rows << ", by bytes "
+              << stats.flushes_by_bytes << ", by time " << stats.flushes_by_time << ", by close "
+              << stats.flushes_by_close << std::endl;
+  }
+
+  // (文档部分: 按时间写出)
+  // 数据来得慢时，等待超过 max_delay 的缓存会被写出
+  coalescing_options.max_delay = std::chrono::milliseconds(20);
+  ARROW_ASSIGN_OR_RAISE(auto sink, OpenBatchWriter("slow.arrow", panel->schema()));
+  CoalescingBatchWriter writer(sink, panel->schema(), coalescing_options);
+  for (int i = 0; i < 50; ++i) {
+    ARROW_RETURN_NOT_OK(writer.WriteRecordBatch(*batches[i]));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ARROW_RETURN_NOT_OK(writer.FlushIfExpired());
+  }
+  ARROW_RETURN_NOT_OK(writer.Close());
+  std::cout << "slow feed: 50 batches in, " << writer.coalescing_stats().batches_out
+            << " out, flushes by time " << writer.coalescing_stats().flushes_by_time
+            << std::endl;
+  // (文档部分: 按时间写出)
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
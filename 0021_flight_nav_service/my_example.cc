@@ -0,0 +1,180 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/csv/api.h>
+#include <arrow/flight/api.h>
+#include <arrow/io/api.h>
+#include <arrow/util/byte_size.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+#include "../fund_panel/fund_panel.h"
+#include "nav_flight_service.h"
+// (文档部分: 包含)
+
+// 用法：
+//   my_example                 生成 nav.csv，启动 Flight 服务并测试
+//   my_example --batch <fund>  批处理方式：读 nav.csv，计算一只基金的夏普比率后退出，
+//                              相当于看板每次重新运行 0006 的程序
+
+constexpr int kRequests = 1000;
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+void PrintLatencies(const std::string& name, std::vector<double> latencies) {
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << name << ": p50 " << latencies[latencies.size() / 2] << " ms, p99 "
+            << latencies[latencies.size() * 99 / 100] << " ms over " << latencies.size()
+            << " requests" << std::endl;
+}
+
+// (文档部分: 批处理)
+arrow::Status RunBatch(const std::string& fund) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open("nav.csv"));
+  auto convert_options = arrow::csv::ConvertOptions::Defaults();
+  auto schema = FundPanelSchema();
+  for (const auto& field : schema->fields()) {
+    convert_options.column_types[field->name()] = field->type();
+  }
+  ARROW_ASSIGN_OR_RAISE(auto csv_reader,
+                        arrow::csv::TableReader::Make(
+                            arrow::io::default_io_context(), infile,
+                            arrow::csv::ReadOptions::Defaults(),
+                            arrow::csv::ParseOptions::Defaults(), convert_options));
+  ARROW_ASSIGN_OR_RAISE(auto table, csv_reader->Read());
+  ARROW_ASSIGN_OR_RAISE(
+      arrow::Datum mask,
+      arrow::compute::CallFunction("equal", {table->GetColumnByName("fund_code"),
+                                             std::make_shared<arrow::StringScalar>(fund)}));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum filtered, arrow::compute::Filter(table, mask));
+  ARROW_ASSIGN_OR_RAISE(auto metrics, ComputeFundMetrics(filtered.table()));
+  std::cout << metrics->GetColumnByName("sharpe_ratio")->GetScalar(0).ValueOrDie()->ToString()
+            << std::endl;
+  return arrow::Status::OK();
+}
+// (文档部分: 批处理)
+
+// 重新运行自己的批处理模式，返回打印出的夏普比率
+arrow::Result<std::string> RunBatchProcess(const std::string& fund) {
+  // popen 经过 shell，要先取到当前程序的实际路径
+  const std::string command =
+      std::filesystem::read_symlink("/proc/self/exe").string() + " --batch " + fund;
+  FILE* pipe = popen(command.c_str(), "r");
+  if (pipe == nullptr) return arrow::Status::IOError("cannot run ", command);
+  char line[128] = {0};
+  const bool ok = fgets(line, sizeof(line), pipe) != nullptr;
+  if (pclose(pipe) != 0 || !ok) return arrow::Status::IOError(command, " failed");
+  std::string output(line);
+  while (!output.empty() && output.back() == '\n') output.pop_back();
+  return output;
+}
+
+arrow::Result<std::shared_ptr<arrow::Table>> Fetch(arrow::flight::FlightClient* client,
+                                                   const NavQuery& query) {
+  ARROW_ASSIGN_OR_RAISE(auto reader, client->DoGet(query.ToTicket()));
+  return reader->ToTable();
+}
+
+arrow::Status RunMain() {
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 2000;
+  panel_options.num_days = 1500;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  ARROW_ASSIGN_OR_RAISE(auto outfile, arrow::io::FileOutputStream::Open("nav.csv"));
+  ARROW_RETURN_NOT_OK(
+      arrow::csv::WriteCSV(*panel, arrow::csv::WriteOptions::Defaults(), outfile.get()));
+  ARROW_RETURN_NOT_OK(outfile->Close());
+
+  // (文档部分: 启动服务)
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto server, NavFlightServer::Make(panel));
+  ARROW_ASSIGN_OR_RAISE(auto location, arrow::flight::Location::ForGrpcTcp("127.0.0.1", 0));
+  arrow::flight::FlightServerOptions server_options(location);
+  ARROW_RETURN_NOT_OK(server->Init(server_options));
+  std::cout << "server on port " << server->port() << " ready in " << ElapsedMs(start_time)
+            << " ms (" << panel->num_rows() << " rows, " << server->metrics()->num_rows()
+            << " funds)" << std::endl;
+  // (文档部分: 启动服务)
+
+  ARROW_ASSIGN_OR_RAISE(auto client_location,
+                        arrow::flight::Location::ForGrpcTcp("127.0.0.1", server->port()));
+  ARROW_ASSIGN_OR_RAISE(auto client, arrow::flight::FlightClient::Connect(client_location));
+
+  // (文档部分: 延迟)
+  NavQuery metrics_query;
+  metrics_query.dataset = "metrics";
+  NavQuery nav_query;
+  nav_query.min_date = TradingDay(panel_options.start_date, 250);
+  nav_query.max_date = TradingDay(panel_options.start_date, 499);
+  std::vector<double> metrics_latencies, nav_latencies;
+  for (int i = 0; i < kRequests; ++i) {
+    metrics_query.funds = {FundCode(i % panel_options.num_funds + 1)};
+    nav_query.funds = metrics_query.funds;
+    start_time = std::chrono::high_resolution_clock::now();
+    ARROW_ASSIGN_OR_RAISE(auto metrics, Fetch(client.get(), metrics_query));
+    metrics_latencies.push_back(ElapsedMs(start_time));
+    start_time = std::chrono::high_resolution_clock::now();
+    ARROW_ASSIGN_OR_RAISE(auto nav, Fetch(client.get(), nav_query));
+    nav_latencies.push_back(ElapsedMs(start_time));
+    if (metrics->num_rows() != 1 || nav->num_rows() != 250) {
+      return arrow::Status::Invalid("unexpected result size for ", nav_query.ToString());
+    }
+  }
+  PrintLatencies("metrics for one fund", metrics_latencies);
+  PrintLatencies("one fund, one year of nav", nav_latencies);
+  // (文档部分: 延迟)
+
+  // (文档部分: 吞吐)
+  // 全部净值、全部基金一年的净值（每只基金一个区间，服务端合并成一个 batch）、全部指标
+  NavQuery all_funds_one_year = nav_query;
+  all_funds_one_year.funds.clear();
+  metrics_query.funds.clear();
+  for (const NavQuery& query : {NavQuery(), all_funds_one_year, metrics_query}) {
+    start_time = std::chrono::high_resolution_clock::now();
+    ARROW_ASSIGN_OR_RAISE(auto table, Fetch(client.get(), query));
+    const double ms = ElapsedMs(start_time);
+    const int64_t bytes = arrow::util::TotalBufferSize(*table);
+    std::cout << "'" << query.ToString() << "': " << table->num_rows() << " rows, "
+              << bytes / (1 << 20) << " MB in " << ms << " ms, " << bytes / ms / 1e6
+              << " GB/s" << std::endl;
+  }
+  // (文档部分: 吞吐)
+
+  // (文档部分: 对比批处理)
+  const std::string fund = FundCode(123);
+  metrics_query.funds = {fund};
+  ARROW_ASSIGN_OR_RAISE(auto metrics, Fetch(client.get(), metrics_query));
+  std::vector<double> batch_latencies;
+  std::string batch_sharpe;
+  for (int i = 0; i < 5; ++i) {
+    start_time = std::chrono::high_resolution_clock::now();
+    ARROW_ASSIGN_OR_RAISE(batch_sharpe, RunBatchProcess(fund));
+    batch_latencies.push_back(ElapsedMs(start_time));
+  }
+  PrintLatencies("re-running the batch binary", batch_latencies);
+  std::cout << fund << " sharpe: service "
+            << metrics->GetColumnByName("sharpe_ratio")->GetScalar(0).ValueOrDie()->ToString()
+            << ", batch " << batch_sharpe << std::endl;
+  // (文档部分: 对比批处理)
+
+  return server->Shutdown();
+}
+
+// (文档部分: 主函数)
+int main(int argc, char** argv) {
+  arrow::Status st =
+      argc == 3 && std::string(argv[1]) == "--batch" ? RunBatch(argv[2]) : RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
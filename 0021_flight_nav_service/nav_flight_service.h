@@ -0,0 +1,272 @@
+// 常驻内存的净值 / 指标服务（Arrow Flight）。
+// 启动时把净值表按 (fund_code, date) 排好序，建立 基金代码 -> 行区间 的索引，
+// 并像 0006_cal_sharpe_ratio 那样对每只基金预先算好夏普比率等指标。
+// 客户端用 ticket 描述查询，DoGet 返回 Arrow IPC 流，不需要再解析 CSV：
+//   nav?fund=F000001,F000002&from=2016-01-04&to=2016-12-30   某些基金某段时间的净值
+//   metrics?fund=F000001                                     预先算好的指标
+// 不写 fund 表示全部基金，不写 from / to 表示不限日期。指标是全部历史上的，忽略日期范围。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/flight/api.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../0011_fixed_point_nav/fixed_point_nav.h"
+
+struct NavQuery {
+  // "nav" 或 "metrics"
+  std::string dataset = "nav";
+  std::vector<std::string> funds;
+  int32_t min_date = std::numeric_limits<int32_t>::min();
+  int32_t max_date = std::numeric_limits<int32_t>::max();
+
+  static arrow::Result<NavQuery> Parse(const std::string& text) {
+    NavQuery query;
+    const size_t question = text.find('?');
+    query.dataset = text.substr(0, question);
+    if (query.dataset != "nav" && query.dataset != "metrics") {
+      return arrow::Status::KeyError("unknown dataset '", query.dataset, "'");
+    }
+    if (question == std::string::npos) return query;
+    std::stringstream params(text.substr(question + 1));
+    std::string param;
+    while (std::getline(params, param, '&')) {
+      const size_t equal = param.find('=');
+      const std::string key = param.substr(0, equal);
+      const std::string value = equal == std::string::npos ? "" : param.substr(equal + 1);
+      if (key == "fund") {
+        std::stringstream codes(value);
+        std::string code;
+        while (std::getline(codes, code, ',')) query.funds.push_back(code);
+      } else if (key == "from" || key == "to") {
+        int32_t date = 0;
+        if (!fixed_point::ParseDate(value.data(), value.data() + value.size(), &date)) {
+          return arrow::Status::Invalid("invalid date '", value, "'");
+        }
+        (key == "from" ? query.min_date : query.max_date) = date;
+      } else {
+        return arrow::Status::Invalid("unknown query parameter '", key, "'");
+      }
+    }
+    return query;
+  }
+
+  std::string ToString() const {
+    std::string text = dataset;
+    std::string separator = "?";
+    if (!funds.empty()) {
+      text += separator + "fund=";
+      for (size_t i = 0; i < funds.size(); ++i) text += (i > 0 ? "," : "") + funds[i];
+      separator = "&";
+    }
+    if (min_date != std::numeric_limits<int32_t>::min()) {
+      text += separator + "from=" + DateString(min_date);
+      separator = "&";
+    }
+    if (max_date != std::numeric_limits<int32_t>::max()) {
+      text += separator + "to=" + DateString(max_date);
+    }
+    return text;
+  }
+
+  arrow::flight::Ticket ToTicket() const { return arrow::flight::Ticket{ToString()}; }
+
+ private:
+  static std::string DateString(int32_t days) {
+    return arrow::Date32Scalar(days).ToString();
+  }
+};
+
+// 每只基金一行：观测数、年化收益、年化波动率和夏普比率（和 0006 一样按 252 个交易日年化）。
+// panel 需要按 (fund_code, date) 排序
+inline arrow::Result<std::shared_ptr<arrow::Table>> ComputeFundMetrics(
+    const std::shared_ptr<arrow::Table>& panel) {
+  ARROW_ASSIGN_OR_RAISE(auto codes_array,
+                        arrow::Concatenate(panel->GetColumnByName("fund_code")->chunks()));
+  const auto& codes = static_cast<const arrow::StringArray&>(*codes_array);
+  auto adj_nav = panel->GetColumnByName("adj_nav");
+  arrow::StringBuilder fund_builder;
+  arrow::Int64Builder count_builder;
+  arrow::DoubleBuilder return_builder, volatility_builder, sharpe_builder;
+  arrow::compute::VarianceOptions variance_options;
+  variance_options.ddof = 1;
+  int64_t begin = 0;
+  while (begin < codes.length()) {
+    int64_t end = begin + 1;
+    while (end < codes.length() && codes.GetView(end) == codes.GetView(begin)) ++end;
+    auto now_nav = adj_nav->Slice(begin + 1, end - begin - 1);
+    auto pre_nav = adj_nav->Slice(begin, end - begin - 1);
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum diff,
+                          arrow::compute::CallFunction("subtract", {now_nav, pre_nav}));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum returns,
+                          arrow::compute::CallFunction("divide", {diff, pre_nav}));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum mean, arrow::compute::Mean(returns));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum stddev,
+                          arrow::compute::Stddev(returns, variance_options));
+    const auto& mean_scalar = mean.scalar_as<arrow::DoubleScalar>();
+    const auto& stddev_scalar = stddev.scalar_as<arrow::DoubleScalar>();
+    ARROW_RETURN_NOT_OK(fund_builder.Append(codes.GetView(begin)));
+    ARROW_RETURN_NOT_OK(count_builder.Append(end - begin));
+    if (mean_scalar.is_valid && stddev_scalar.is_valid && stddev_scalar.value > 0) {
+      ARROW_RETURN_NOT_OK(return_builder.Append(mean_scalar.value * 252));
+      ARROW_RETURN_NOT_OK(volatility_builder.Append(stddev_scalar.value * std::sqrt(252.0)));
+      ARROW_RETURN_NOT_OK(
+          sharpe_builder.Append(mean_scalar.value / stddev_scalar.value * std::sqrt(252.0)));
+    } else {
+      ARROW_RETURN_NOT_OK(return_builder.AppendNull());
+      ARROW_RETURN_NOT_OK(volatility_builder.AppendNull());
+      ARROW_RETURN_NOT_OK(sharpe_builder.AppendNull());
+    }
+    begin = end;
+  }
+  auto schema = arrow::schema({arrow::field("fund_code", arrow::utf8()),
+                               arrow::field("observations", arrow::int64()),
+                               arrow::field("annual_return", arrow::float64()),
+                               arrow::field("annual_volatility", arrow::float64()),
+                               arrow::field("sharpe_ratio", arrow::float64())});
+  std::vector<std::shared_ptr<arrow::Array>> columns(5);
+  ARROW_RETURN_NOT_OK(fund_builder.Finish(&columns[0]));
+  ARROW_RETURN_NOT_OK(count_builder.Finish(&columns[1]));
+  ARROW_RETURN_NOT_OK(return_builder.Finish(&columns[2]));
+  ARROW_RETURN_NOT_OK(volatility_builder.Finish(&columns[3]));
+  ARROW_RETURN_NOT_OK(sharpe_builder.Finish(&columns[4]));
+  return arrow::Table::Make(schema, columns);
+}
+
+class NavFlightServer : public arrow::flight::FlightServerBase {
+ public:
+  // 排序、建索引并计算指标，之后所有请求都只读这些数据，不需要加锁
+  static arrow::Result<std::unique_ptr<NavFlightServer>> Make(
+      const std::shared_ptr<arrow::Table>& panel) {
+    std::unique_ptr<NavFlightServer> server(new NavFlightServer());
+    arrow::compute::SortOptions sort_options(
+        {arrow::compute::SortKey("fund_code"), arrow::compute::SortKey("date")});
+    ARROW_ASSIGN_OR_RAISE(auto indices, arrow::compute::SortIndices(panel, sort_options));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum sorted, arrow::compute::Take(panel, indices));
+    ARROW_ASSIGN_OR_RAISE(server->nav_, sorted.table()->CombineChunksToBatch());
+    ARROW_ASSIGN_OR_RAISE(auto metrics, ComputeFundMetrics(sorted.table()));
+    ARROW_ASSIGN_OR_RAISE(server->metrics_, metrics->CombineChunksToBatch());
+
+    const auto& codes =
+        static_cast<const arrow::StringArray&>(*server->nav_->GetColumnByName("fund_code"));
+    for (int64_t i = 0; i < codes.length(); ++i) {
+      auto& rows = server->nav_rows_[std::string(codes.GetView(i))];
+      if (rows.second == 0) {
+        rows.first = i;
+        server->fund_codes_.emplace_back(codes.GetView(i));
+      }
+      ++rows.second;
+    }
+    const auto& metric_codes =
+        static_cast<const arrow::StringArray&>(*server->metrics_->GetColumnByName("fund_code"));
+    for (int64_t i = 0; i < metric_codes.length(); ++i) {
+      server->metric_rows_[std::string(metric_codes.GetView(i))] = i;
+    }
+    server->dates_ = std::static_pointer_cast<arrow::Date32Array>(
+                         server->nav_->GetColumnByName("date"))
+                         ->raw_values();
+    return server;
+  }
+
+  // 按查询选出的行。只有一个连续区间时是零拷贝的切片，否则用 Take 合并成一个 batch，
+  // 避免每只基金一个很小的 IPC message
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> Select(const NavQuery& query) const {
+    std::vector<std::pair<int64_t, int64_t>> ranges;
+    auto add = [&](int64_t begin, int64_t end) {
+      if (begin >= end) return;
+      if (!ranges.empty() && ranges.back().second == begin) {
+        ranges.back().second = end;
+      } else {
+        ranges.emplace_back(begin, end);
+      }
+    };
+    const auto& table = query.dataset == "nav" ? nav_ : metrics_;
+    if (query.dataset == "metrics") {
+      if (query.funds.empty()) return metrics_;
+      for (const auto& code : query.funds) {
+        auto it = metric_rows_.find(code);
+        if (it == metric_rows_.end()) return arrow::Status::KeyError("unknown fund ", code);
+        add(it->second, it->second + 1);
+      }
+    } else {
+      auto add_fund = [&](std::pair<int64_t, int64_t> rows) {
+        // 同一只基金的日期是递增的，二分查找日期范围
+        const int32_t* first = dates_ + rows.first;
+        const int32_t* last = first + rows.second;
+        add(std::lower_bound(first, last, query.min_date) - dates_,
+            std::upper_bound(first, last, query.max_date) - dates_);
+      };
+      if (query.funds.empty()) {
+        for (const auto& code : fund_codes_) add_fund(nav_rows_.at(code));
+      } else {
+        for (const auto& code : query.funds) {
+          auto it = nav_rows_.find(code);
+          if (it == nav_rows_.end()) return arrow::Status::KeyError("unknown fund ", code);
+          add_fund(it->second);
+        }
+      }
+    }
+    if (ranges.empty()) return table->Slice(0, 0);
+    if (ranges.size() == 1) {
+      return table->Slice(ranges[0].first, ranges[0].second - ranges[0].first);
+    }
+    arrow::Int64Builder builder;
+    for (const auto& [begin, end] : ranges) {
+      for (int64_t i = begin; i < end; ++i) ARROW_RETURN_NOT_OK(builder.Append(i));
+    }
+    ARROW_ASSIGN_OR_RAISE(auto indices, builder.Finish());
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum taken, arrow::compute::Take(table, indices));
+    return taken.record_batch();
+  }
+
+  arrow::Status GetFlightInfo(const arrow::flight::ServerCallContext&,
+                              const arrow::flight::FlightDescriptor& request,
+                              std::unique_ptr<arrow::flight::FlightInfo>* info) override {
+    ARROW_ASSIGN_OR_RAISE(auto query, NavQuery::Parse(request.cmd));
+    ARROW_ASSIGN_OR_RAISE(auto batch, Select(query));
+    arrow::flight::FlightEndpoint endpoint;
+    endpoint.ticket = query.ToTicket();
+    ARROW_ASSIGN_OR_RAISE(auto flight_info,
+                          arrow::flight::FlightInfo::Make(*batch->schema(), request, {endpoint},
+                                                          batch->num_rows(), -1));
+    *info = std::make_unique<arrow::flight::FlightInfo>(std::move(flight_info));
+    return arrow::Status::OK();
+  }
+
+  arrow::Status DoGet(const arrow::flight::ServerCallContext&,
+                      const arrow::flight::Ticket& request,
+                      std::unique_ptr<arrow::flight::FlightDataStream>* stream) override {
+    ARROW_ASSIGN_OR_RAISE(auto query, NavQuery::Parse(request.ticket));
+    ARROW_ASSIGN_OR_RAISE(auto batch, Select(query));
+    // 大结果切成多个 message 发送，客户端可以边收边处理
+    auto table = arrow::Table::Make(batch->schema(), batch->columns(), batch->num_rows());
+    auto reader = std::make_shared<arrow::TableBatchReader>(table);
+    reader->set_chunksize(kMaxRowsPerMessage);
+    *stream = std::make_unique<arrow::flight::RecordBatchStream>(reader);
+    return arrow::Status::OK();
+  }
+
+  const std::shared_ptr<arrow::RecordBatch>& metrics() const { return metrics_; }
+
+ private:
+  static constexpr int64_t kMaxRowsPerMessage = 64 * 1024;
+
+  NavFlightServer() = default;
+
+  std::shared_ptr<arrow::RecordBatch> nav_;
+  std::shared_ptr<arrow::RecordBatch> metrics_;
+  const int32_t* dates_ = nullptr;
+  // nav_ 中基金出现的顺序
+  std::vector<std::string> fund_codes_;
+  // 基金代码 -> (第一行, 行数)
+  std::unordered_map<std::string, std::pair<int64_t, int64_t>> nav_rows_;
+  std::unordered_map<std::string, int64_t> metric_rows_;
+};
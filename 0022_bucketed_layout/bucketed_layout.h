@@ -0,0 +1,123 @@
+// 基金历史数据的分区布局：按 基金代码的哈希桶 + 年份 做 Hive 分区，
+//   root/bucket=17/year=2016/part-0.parquet
+// 0004_datasets 按某一列的每个取值分区，换成基金代码时每只基金一个目录、一个很小的文件，
+// 2 万只基金就是 2 万个目录。按哈希桶分区后目录数固定为 num_buckets × 年数，
+// 每个文件里有很多基金，按 (fund_code, date) 排序，Parquet 的 row group 统计信息可以跳过其他基金。
+// 查询一只基金时先用 FundBucketFilter 按桶裁剪目录，再用统计信息跳过 row group。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <string>
+#include <string_view>
+
+#include "../0014_parquet_nav_writer/nav_writer_properties.h"
+
+struct BucketedLayoutOptions {
+  int num_buckets = 32;
+  // 一个文件最多的行数，超过后在同一个目录下开新文件
+  uint64_t max_rows_per_file = 4 << 20;
+  // 攒够这么多行才写一个 row group，避免很小的 row group
+  uint64_t min_rows_per_group = 64 * 1024;
+  uint64_t max_rows_per_group = 256 * 1024;
+  NavParquetOptions parquet_options;
+};
+
+// 基金代码的桶号：32 位 FNV-1a 哈希对桶数取模，和平台、标准库实现无关，写入和查询结果一致
+inline int32_t FundBucket(std::string_view code, int num_buckets) {
+  uint32_t hash = 2166136261u;
+  for (unsigned char c : code) {
+    hash ^= c;
+    hash *= 16777619u;
+  }
+  return static_cast<int32_t>(hash % static_cast<uint32_t>(num_buckets));
+}
+
+inline std::shared_ptr<arrow::Schema> BucketedPartitionSchema() {
+  return arrow::schema({arrow::field("bucket", arrow::int32()),
+                        arrow::field("year", arrow::int64())});
+}
+
+inline std::shared_ptr<arrow::dataset::Partitioning> BucketedPartitioning() {
+  return std::make_shared<arrow::dataset::HivePartitioning>(BucketedPartitionSchema());
+}
+
+// 查询一只基金：桶号用于裁剪目录，fund_code 用于跳过 row group 和精确过滤
+inline arrow::compute::Expression FundBucketFilter(const std::string& code, int num_buckets) {
+  namespace cp = arrow::compute;
+  return cp::and_(cp::equal(cp::field_ref("bucket"), cp::literal(FundBucket(code, num_buckets))),
+                  cp::equal(cp::field_ref("fund_code"), cp::literal(code)));
+}
+
+// 加上 bucket、year 两列，并按 (bucket, year, fund_code, date) 排序。
+// 数据集写入器按顺序把每个分区的行写进文件，所以每个文件内部按 (fund_code, date) 有序
+inline arrow::Result<std::shared_ptr<arrow::Table>> AddBucketAndYear(
+    const std::shared_ptr<arrow::Table>& table, int num_buckets) {
+  arrow::Int32Builder bucket_builder;
+  ARROW_RETURN_NOT_OK(bucket_builder.Reserve(table->num_rows()));
+  for (const auto& chunk : table->GetColumnByName("fund_code")->chunks()) {
+    const auto& codes = static_cast<const arrow::StringArray&>(*chunk);
+    for (int64_t i = 0; i < codes.length(); ++i) {
+      bucket_builder.UnsafeAppend(FundBucket(codes.GetView(i), num_buckets));
+    }
+  }
+  ARROW_ASSIGN_OR_RAISE(auto buckets, bucket_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum years,
+                        arrow::compute::Year(table->GetColumnByName("date")));
+  ARROW_ASSIGN_OR_RAISE(auto with_bucket,
+                        table->AddColumn(table->num_columns(),
+                                         arrow::field("bucket", arrow::int32()),
+                                         std::make_shared<arrow::ChunkedArray>(buckets)));
+  ARROW_ASSIGN_OR_RAISE(auto with_year,
+                        with_bucket->AddColumn(with_bucket->num_columns(),
+                                               arrow::field("year", arrow::int64()),
+                                               years.chunked_array()));
+  arrow::compute::SortOptions sort_options(
+      {arrow::compute::SortKey("bucket"), arrow::compute::SortKey("year"),
+       arrow::compute::SortKey("fund_code"), arrow::compute::SortKey("date")});
+  ARROW_ASSIGN_OR_RAISE(auto indices, arrow::compute::SortIndices(with_year, sort_options));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum sorted, arrow::compute::Take(with_year, indices));
+  return sorted.table();
+}
+
+// 用 0014 的写入配置写 Parquet，并设置文件和 row group 的行数限制
+inline arrow::dataset::FileSystemDatasetWriteOptions BucketedWriteOptions(
+    const std::shared_ptr<arrow::fs::FileSystem>& filesystem, const std::string& base_dir,
+    const arrow::Schema& schema, const BucketedLayoutOptions& options) {
+  auto format = std::make_shared<arrow::dataset::ParquetFileFormat>();
+  auto parquet_options = std::static_pointer_cast<arrow::dataset::ParquetFileWriteOptions>(
+      format->DefaultWriteOptions());
+  parquet_options->writer_properties = NavWriterProperties(schema, options.parquet_options);
+  parquet_options->arrow_writer_properties = NavArrowWriterProperties();
+
+  arrow::dataset::FileSystemDatasetWriteOptions write_options;
+  write_options.file_write_options = parquet_options;
+  write_options.filesystem = filesystem;
+  write_options.base_dir = base_dir;
+  write_options.partitioning = BucketedPartitioning();
+  write_options.basename_template = "part-{i}.parquet";
+  write_options.existing_data_behavior =
+      arrow::dataset::ExistingDataBehavior::kDeleteMatchingPartitions;
+  write_options.max_partitions = options.num_buckets * 100;
+  write_options.max_rows_per_file = options.max_rows_per_file;
+  write_options.min_rows_per_group = options.min_rows_per_group;
+  write_options.max_rows_per_group = options.max_rows_per_group;
+  // 保持输入顺序，文件内才是排好序的
+  write_options.preserve_order = true;
+  return write_options;
+}
+
+inline arrow::Status WriteBucketedDataset(
+    const std::shared_ptr<arrow::Table>& table,
+    const std::shared_ptr<arrow::fs::FileSystem>& filesystem, const std::string& base_dir,
+    const BucketedLayoutOptions& options = BucketedLayoutOptions()) {
+  ARROW_ASSIGN_OR_RAISE(auto prepared, AddBucketAndYear(table, options.num_buckets));
+  auto reader = std::make_shared<arrow::TableBatchReader>(prepared);
+  auto scanner_builder = arrow::dataset::ScannerBuilder::FromRecordBatchReader(reader);
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scanner_builder->Finish());
+  return arrow::dataset::FileSystemDataset::Write(
+      BucketedWriteOptions(filesystem, base_dir, *table->schema(), options), scanner);
+}
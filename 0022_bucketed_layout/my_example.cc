@@ -0,0 +1,154 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "../fund_panel/fund_panel.h"
+#include "bucketed_layout.h"
+// (文档部分: 包含)
+
+constexpr int kLookups = 100;
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+// (文档部分: 按基金分区)
+// 0004_datasets 的做法换成基金代码：每只基金一个 Hive 分区目录
+arrow::Status WritePerFundDataset(const std::shared_ptr<arrow::Table>& table,
+                                  const std::shared_ptr<arrow::fs::FileSystem>& fs,
+                                  const std::string& base_dir) {
+  auto reader = std::make_shared<arrow::TableBatchReader>(table);
+  auto scanner_builder = arrow::dataset::ScannerBuilder::FromRecordBatchReader(reader);
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scanner_builder->Finish());
+  auto format = std::make_shared<arrow::dataset::ParquetFileFormat>();
+  arrow::dataset::FileSystemDatasetWriteOptions write_options;
+  write_options.file_write_options = format->DefaultWriteOptions();
+  write_options.filesystem = fs;
+  write_options.base_dir = base_dir;
+  write_options.partitioning = std::make_shared<arrow::dataset::HivePartitioning>(
+      arrow::schema({arrow::field("fund_code", arrow::utf8())}));
+  write_options.basename_template = "part{i}.parquet";
+  write_options.existing_data_behavior =
+      arrow::dataset::ExistingDataBehavior::kDeleteMatchingPartitions;
+  write_options.max_partitions = 1 << 20;
+  return arrow::dataset::FileSystemDataset::Write(write_options, scanner);
+}
+// (文档部分: 按基金分区)
+
+void PrintLayout(const std::string& name, const std::string& base_dir, double write_ms) {
+  int64_t files = 0, directories = 0, bytes = 0;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(base_dir)) {
+    if (entry.is_directory()) {
+      ++directories;
+    } else {
+      ++files;
+      bytes += static_cast<int64_t>(entry.file_size());
+    }
+  }
+  std::cout << name << ": write " << write_ms << " ms, " << directories << " directories, "
+            << files << " files, " << bytes / (1 << 20) << " MB, " << bytes / files / 1024
+            << " KB per file" << std::endl;
+}
+
+// (文档部分: 扫描)
+// 发现文件、全表扫描、逐只基金查询的耗时
+arrow::Status BenchmarkScan(const std::string& name,
+                            const std::shared_ptr<arrow::fs::FileSystem>& fs,
+                            const std::string& base_dir,
+                            const std::function<arrow::compute::Expression(int)>& fund_filter) {
+  auto start_time = std::chrono::high_resolution_clock::now();
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  arrow::dataset::FileSystemFactoryOptions factory_options;
+  factory_options.partitioning = arrow::dataset::HivePartitioning::MakeFactory();
+  ARROW_ASSIGN_OR_RAISE(auto factory, arrow::dataset::FileSystemDatasetFactory::Make(
+                                          fs, selector,
+                                          std::make_shared<arrow::dataset::ParquetFileFormat>(),
+                                          factory_options));
+  ARROW_ASSIGN_OR_RAISE(auto dataset, factory->Finish());
+  const double discover_ms = ElapsedMs(start_time);
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto scan_builder, dataset->NewScan());
+  ARROW_RETURN_NOT_OK(scan_builder->Project({"fund_code", "date", "nav", "adj_nav"}));
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scan_builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(auto table, scanner->ToTable());
+  const double scan_ms = ElapsedMs(start_time);
+
+  start_time = std::chrono::high_resolution_clock::now();
+  int64_t lookup_rows = 0;
+  for (int i = 0; i < kLookups; ++i) {
+    ARROW_ASSIGN_OR_RAISE(auto lookup_builder, dataset->NewScan());
+    ARROW_RETURN_NOT_OK(lookup_builder->Filter(fund_filter(i)));
+    ARROW_ASSIGN_OR_RAISE(auto lookup_scanner, lookup_builder->Finish());
+    ARROW_ASSIGN_OR_RAISE(auto fund, lookup_scanner->ToTable());
+    lookup_rows += fund->num_rows();
+  }
+  const double lookup_ms = ElapsedMs(start_time) / kLookups;
+
+  std::cout << name << ": discover " << discover_ms << " ms, full scan " << table->num_rows()
+            << " rows in " << scan_ms << " ms (" << table->num_rows() / scan_ms / 1000
+            << " M rows/s), one fund " << lookup_ms << " ms (" << lookup_rows / kLookups
+            << " rows)" << std::endl;
+  return arrow::Status::OK();
+}
+// (文档部分: 扫描)
+
+arrow::Status RunMain() {
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 10000;
+  panel_options.num_days = 750;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  std::cout << "panel: " << panel->num_rows() << " rows, " << panel_options.num_funds
+            << " funds" << std::endl;
+
+  const std::string root = std::filesystem::current_path().string();
+  ARROW_ASSIGN_OR_RAISE(auto fs, arrow::fs::FileSystemFromUriOrPath(root));
+  const std::string per_fund_dir = root + "/per_fund_dataset";
+  const std::string bucketed_dir = root + "/bucketed_dataset";
+  std::filesystem::remove_all(per_fund_dir);
+  std::filesystem::remove_all(bucketed_dir);
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_RETURN_NOT_OK(WritePerFundDataset(panel, fs, per_fund_dir));
+  PrintLayout("per fund", per_fund_dir, ElapsedMs(start_time));
+
+  // (文档部分: 分桶布局)
+  BucketedLayoutOptions options;
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_RETURN_NOT_OK(WriteBucketedDataset(panel, fs, bucketed_dir, options));
+  PrintLayout("bucket + year", bucketed_dir, ElapsedMs(start_time));
+  // (文档部分: 分桶布局)
+
+  // 查询的基金分散在整个代码范围里
+  auto fund_code = [&](int i) {
+    return FundCode(i * (panel_options.num_funds / kLookups) + 1);
+  };
+  ARROW_RETURN_NOT_OK(BenchmarkScan("per fund", fs, per_fund_dir, [&](int i) {
+    return arrow::compute::equal(arrow::compute::field_ref("fund_code"),
+                                 arrow::compute::literal(fund_code(i)));
+  }));
+  ARROW_RETURN_NOT_OK(BenchmarkScan("bucket + year", fs, bucketed_dir, [&](int i) {
+    return FundBucketFilter(fund_code(i), options.num_buckets);
+  }));
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
@@ -0,0 +1,400 @@
+// 按 基金代码 + 日期范围 + 列 查询数据集，把条件尽量往下推：
+//   1. FundQuery::ToExpression 生成 compute::Expression。数据集按 0022 的 bucket + year 分区时，
+//      额外加上桶号和年份的条件，Dataset::GetFragments 用分区表达式跳过整个文件；
+//   2. ParquetFileFragment::Subset 用 row group 的 min/max 统计信息跳过 row group；
+//   3. 剩下的 row group 用 fund_code 和 date 列的 page index 找出可能命中的行范围（取交集），
+//      解码后先切片再精确过滤，和 0015 一样，落在范围之外的 page 只统计字节数；
+//   4. 只读请求的列，过滤需要的列读完后去掉。
+// 1、2 两步 ScannerBuilder::Filter 也会做；ReadFundQuery 还用了 page index，并统计每一步跳过的量。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/page_index.h>
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../0015_parquet_pruned_reader/nav_reader.h"
+#include "../0022_bucketed_layout/bucketed_layout.h"
+
+// 数据集的分区方式，决定查询条件里能不能带上桶号和年份
+struct FundQueryLayout {
+  // 0022 的桶数，0 表示没有 bucket 分区
+  int num_buckets = 0;
+  // 是否有 year 分区
+  bool year_partitioned = false;
+};
+
+inline FundQueryLayout BucketedQueryLayout(const BucketedLayoutOptions& options) {
+  return FundQueryLayout{options.num_buckets, true};
+}
+
+struct FundQuery {
+  // 要查的基金，空表示全部
+  std::vector<std::string> funds;
+  // 日期范围 [min_date, max_date]，date32 表示，闭区间
+  int32_t min_date = std::numeric_limits<int32_t>::min();
+  int32_t max_date = std::numeric_limits<int32_t>::max();
+  // 要返回的列，空表示文件中的全部列
+  std::vector<std::string> columns;
+
+  bool has_date_range() const {
+    return min_date != std::numeric_limits<int32_t>::min() ||
+           max_date != std::numeric_limits<int32_t>::max();
+  }
+
+  arrow::compute::Expression ToExpression(const FundQueryLayout& layout = FundQueryLayout()) const;
+};
+
+struct FundQueryStats {
+  int fragments = 0;
+  int fragments_read = 0;
+  // 只统计分区裁剪后剩下的文件，被跳过的文件不读 footer
+  int row_groups = 0;
+  int row_groups_read = 0;
+  // 被跳过的文件按文件大小统计，其他按列块的压缩大小统计
+  int64_t bytes_read = 0;
+  int64_t bytes_skipped_fragments = 0;
+  int64_t bytes_skipped_row_groups = 0;
+  int64_t bytes_skipped_columns = 0;
+  // 已读的列块中，落在命中行范围之外的 page 的大小（按页读取时可以省掉的部分）
+  int64_t bytes_outside_pages = 0;
+  int64_t rows_decoded = 0;
+  int64_t rows_returned = 0;
+};
+
+namespace fund_query_internal {
+
+// 和 0018 的 SegmentedStore::YearOf 相同：date32（1970-01-01 起的天数）所在的公历年份
+inline int64_t YearOf(int32_t days) {
+  const int64_t z = static_cast<int64_t>(days) + 719468;
+  const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const int64_t doe = z - era * 146097;
+  const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const int64_t mp = (5 * doy + 2) / 153;
+  return yoe + era * 400 + (mp < 10 ? 0 : 1);
+}
+
+inline arrow::compute::Expression InList(const std::string& column, arrow::Datum values) {
+  return arrow::compute::call("is_in", {arrow::compute::field_ref(column)},
+                              arrow::compute::SetLookupOptions(std::move(values)));
+}
+
+// 两组有序、互不重叠的行范围的交集
+inline std::vector<std::pair<int64_t, int64_t>> Intersect(
+    const std::vector<std::pair<int64_t, int64_t>>& a,
+    const std::vector<std::pair<int64_t, int64_t>>& b) {
+  std::vector<std::pair<int64_t, int64_t>> result;
+  size_t i = 0, j = 0;
+  while (i < a.size() && j < b.size()) {
+    const int64_t begin = std::max(a[i].first, b[j].first);
+    const int64_t end = std::min(a[i].second, b[j].second);
+    if (begin < end) result.emplace_back(begin, end);
+    if (a[i].second < b[j].second) {
+      ++i;
+    } else {
+      ++j;
+    }
+  }
+  return result;
+}
+
+// 根据 fund_code 列的 page index 得到可能含有 funds（已排序）中某只基金的行范围
+inline std::vector<std::pair<int64_t, int64_t>> FundRows(
+    const parquet::ByteArrayColumnIndex& column_index, const parquet::OffsetIndex& offset_index,
+    int64_t num_rows, const std::vector<std::string>& funds) {
+  auto view = [](const parquet::ByteArray& value) {
+    return std::string_view(reinterpret_cast<const char*>(value.ptr), value.len);
+  };
+  std::vector<std::pair<int64_t, int64_t>> ranges;
+  const auto& pages = offset_index.page_locations();
+  for (size_t p = 0; p < pages.size(); ++p) {
+    if (column_index.null_pages()[p]) continue;
+    auto it = std::lower_bound(funds.begin(), funds.end(), view(column_index.min_values()[p]));
+    if (it == funds.end() || *it > view(column_index.max_values()[p])) continue;
+    const int64_t begin = pages[p].first_row_index;
+    const int64_t end = p + 1 < pages.size() ? pages[p + 1].first_row_index : num_rows;
+    if (!ranges.empty() && ranges.back().second == begin) {
+      ranges.back().second = end;
+    } else {
+      ranges.emplace_back(begin, end);
+    }
+  }
+  return ranges;
+}
+
+}  // namespace fund_query_internal
+
+// 每只基金一个条件，用 or 连起来：统计信息按 [min, max] 化简时 is_in 不会被化简掉。
+// 有 bucket 分区时每个条件是 0022 的 FundBucketFilter，代入文件的分区表达式 bucket == k 后，
+// 其他桶的基金直接化简为 false，不会因为代码落在 row group 的 [min, max] 里而读入整个 row group
+inline arrow::compute::Expression FundQuery::ToExpression(const FundQueryLayout& layout) const {
+  namespace cp = arrow::compute;
+  std::vector<cp::Expression> conditions;
+  if (!funds.empty()) {
+    std::vector<cp::Expression> codes;
+    for (const auto& code : funds) {
+      codes.push_back(layout.num_buckets > 0
+                          ? FundBucketFilter(code, layout.num_buckets)
+                          : cp::equal(cp::field_ref("fund_code"), cp::literal(code)));
+    }
+    conditions.push_back(cp::or_(codes));
+  }
+  if (min_date != std::numeric_limits<int32_t>::min()) {
+    conditions.push_back(cp::greater_equal(cp::field_ref("date"),
+                                           cp::literal(arrow::Date32Scalar(min_date))));
+    if (layout.year_partitioned) {
+      conditions.push_back(cp::greater_equal(cp::field_ref("year"),
+                                             cp::literal(fund_query_internal::YearOf(min_date))));
+    }
+  }
+  if (max_date != std::numeric_limits<int32_t>::max()) {
+    conditions.push_back(
+        cp::less_equal(cp::field_ref("date"), cp::literal(arrow::Date32Scalar(max_date))));
+    if (layout.year_partitioned) {
+      conditions.push_back(cp::less_equal(cp::field_ref("year"),
+                                          cp::literal(fund_query_internal::YearOf(max_date))));
+    }
+  }
+  return cp::and_(conditions);
+}
+
+// 查询一个 Parquet 数据集（FileSystemDataset + ParquetFileFormat）。
+// 文件按顺序逐个读，每个文件内部各列并行解码
+inline arrow::Result<std::shared_ptr<arrow::Table>> ReadFundQuery(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset, const FundQuery& query,
+    const FundQueryLayout& layout, FundQueryStats* stats = nullptr) {
+  FundQueryStats local_stats;
+  if (stats == nullptr) stats = &local_stats;
+  *stats = FundQueryStats();
+
+  ARROW_ASSIGN_OR_RAISE(auto filter, query.ToExpression(layout).Bind(*dataset->schema()));
+  std::vector<std::string> funds = query.funds;
+  std::sort(funds.begin(), funds.end());
+
+  // (1) 分区裁剪
+  ARROW_ASSIGN_OR_RAISE(auto all_fragments, dataset->GetFragments());
+  ARROW_ASSIGN_OR_RAISE(auto matching, dataset->GetFragments(filter));
+  std::vector<std::shared_ptr<arrow::dataset::ParquetFileFragment>> fragments;
+  std::set<std::string> kept_paths;
+  for (auto maybe_fragment : matching) {
+    ARROW_ASSIGN_OR_RAISE(auto fragment, std::move(maybe_fragment));
+    auto parquet_fragment =
+        std::dynamic_pointer_cast<arrow::dataset::ParquetFileFragment>(fragment);
+    if (parquet_fragment == nullptr) {
+      return arrow::Status::NotImplemented("only Parquet fragments are supported");
+    }
+    kept_paths.insert(parquet_fragment->source().path());
+    fragments.push_back(std::move(parquet_fragment));
+  }
+  for (auto maybe_fragment : all_fragments) {
+    ARROW_ASSIGN_OR_RAISE(auto fragment, std::move(maybe_fragment));
+    ++stats->fragments;
+    const auto& source = static_cast<const arrow::dataset::FileFragment&>(*fragment).source();
+    if (kept_paths.count(source.path()) == 0) stats->bytes_skipped_fragments += source.Size();
+  }
+  stats->fragments_read = static_cast<int>(fragments.size());
+
+  parquet::ArrowReaderProperties arrow_properties;
+  arrow_properties.set_use_threads(true);
+  arrow_properties.set_pre_buffer(true);
+  NavReadOptions date_range;
+  date_range.min_date = query.min_date;
+  date_range.max_date = query.max_date;
+  std::vector<std::shared_ptr<arrow::Table>> pieces;
+  for (const auto& fragment : fragments) {
+    ARROW_ASSIGN_OR_RAISE(auto infile, fragment->source().Open());
+    parquet::arrow::FileReaderBuilder builder;
+    ARROW_RETURN_NOT_OK(builder.Open(infile));
+    std::unique_ptr<parquet::arrow::FileReader> reader;
+    ARROW_RETURN_NOT_OK(builder.properties(arrow_properties)->Build(&reader));
+
+    // (2) row group 裁剪，footer 直接用上面打开的 reader 读到的
+    ARROW_RETURN_NOT_OK(fragment->EnsureCompleteMetadata(reader.get()));
+    ARROW_ASSIGN_OR_RAISE(auto subset, fragment->Subset(filter));
+    const std::vector<int> row_groups =
+        static_cast<const arrow::dataset::ParquetFileFragment&>(*subset).row_groups();
+    auto metadata = reader->parquet_reader()->metadata();
+    const parquet::SchemaDescriptor* schema = metadata->schema();
+    const int fund_index = schema->ColumnIndex("fund_code");
+    const int date_index = schema->ColumnIndex("date");
+    if (fund_index < 0 || date_index < 0) {
+      return arrow::Status::KeyError(fragment->source().path(), " has no fund_code or date");
+    }
+    // 这个文件所在的桶里的基金，page index 只用它们来找行范围
+    std::vector<std::string> fragment_funds;
+    for (const auto& code : funds) {
+      if (layout.num_buckets == 0) {
+        fragment_funds.push_back(code);
+        continue;
+      }
+      namespace cp = arrow::compute;
+      ARROW_ASSIGN_OR_RAISE(auto in_bucket,
+                            cp::equal(cp::field_ref("bucket"),
+                                      cp::literal(FundBucket(code, layout.num_buckets)))
+                                .Bind(*dataset->schema()));
+      ARROW_ASSIGN_OR_RAISE(in_bucket, cp::SimplifyWithGuarantee(
+                                           in_bucket, fragment->partition_expression()));
+      if (in_bucket.IsSatisfiable()) fragment_funds.push_back(code);
+    }
+
+    // 返回的列加上过滤需要的列
+    std::vector<int> column_indices;
+    if (query.columns.empty()) {
+      for (int i = 0; i < schema->num_columns(); ++i) column_indices.push_back(i);
+    } else {
+      for (const auto& name : query.columns) {
+        const int index = schema->ColumnIndex(name);
+        if (index < 0) return arrow::Status::KeyError("no column '", name, "'");
+        column_indices.push_back(index);
+      }
+    }
+    if (!funds.empty()) column_indices.push_back(fund_index);
+    if (query.has_date_range()) column_indices.push_back(date_index);
+    std::sort(column_indices.begin(), column_indices.end());
+    column_indices.erase(std::unique(column_indices.begin(), column_indices.end()),
+                         column_indices.end());
+
+    stats->row_groups += metadata->num_row_groups();
+    stats->row_groups_read += static_cast<int>(row_groups.size());
+    for (int rg = 0; rg < metadata->num_row_groups(); ++rg) {
+      auto row_group = metadata->RowGroup(rg);
+      const bool keep = std::binary_search(row_groups.begin(), row_groups.end(), rg);
+      for (int i = 0; i < row_group->num_columns(); ++i) {
+        const int64_t size = row_group->ColumnChunk(i)->total_compressed_size();
+        if (!keep) {
+          stats->bytes_skipped_row_groups += size;
+        } else if (std::binary_search(column_indices.begin(), column_indices.end(), i)) {
+          stats->bytes_read += size;
+        } else {
+          stats->bytes_skipped_columns += size;
+        }
+      }
+    }
+    if (row_groups.empty()) continue;
+
+    // (3) page index：fund_code 和 date 两列各自可能命中的行范围取交集
+    std::vector<std::vector<std::pair<int64_t, int64_t>>> row_ranges(row_groups.size());
+    auto page_index_reader = reader->parquet_reader()->GetPageIndexReader();
+    for (size_t k = 0; k < row_groups.size(); ++k) {
+      const int64_t num_rows = metadata->RowGroup(row_groups[k])->num_rows();
+      row_ranges[k] = {{0, num_rows}};
+      auto row_group_index =
+          page_index_reader == nullptr ? nullptr : page_index_reader->RowGroup(row_groups[k]);
+      if (row_group_index == nullptr) continue;
+      if (!funds.empty()) {
+        auto column_index = std::dynamic_pointer_cast<parquet::ByteArrayColumnIndex>(
+            row_group_index->GetColumnIndex(fund_index));
+        auto offset_index = row_group_index->GetOffsetIndex(fund_index);
+        if (column_index != nullptr && offset_index != nullptr) {
+          row_ranges[k] = fund_query_internal::Intersect(
+              row_ranges[k], fund_query_internal::FundRows(*column_index, *offset_index,
+                                                           num_rows, fragment_funds));
+        }
+      }
+      if (query.has_date_range()) {
+        auto column_index = std::dynamic_pointer_cast<parquet::Int32ColumnIndex>(
+            row_group_index->GetColumnIndex(date_index));
+        auto offset_index = row_group_index->GetOffsetIndex(date_index);
+        if (column_index != nullptr && offset_index != nullptr) {
+          row_ranges[k] = fund_query_internal::Intersect(
+              row_ranges[k], nav_reader_internal::MatchingRows(*column_index, *offset_index,
+                                                               num_rows, date_range));
+        }
+      }
+      for (int i : column_indices) {
+        auto column_offsets = row_group_index->GetOffsetIndex(i);
+        if (column_offsets == nullptr) continue;
+        stats->bytes_outside_pages +=
+            nav_reader_internal::BytesOutside(*column_offsets, num_rows, row_ranges[k]);
+      }
+    }
+
+    ARROW_ASSIGN_OR_RAISE(auto table, reader->ReadRowGroups(row_groups, column_indices));
+    stats->rows_decoded += table->num_rows();
+    int64_t offset = 0;
+    for (size_t k = 0; k < row_groups.size(); ++k) {
+      for (const auto& range : row_ranges[k]) {
+        pieces.push_back(table->Slice(offset + range.first, range.second - range.first));
+      }
+      offset += metadata->RowGroup(row_groups[k])->num_rows();
+    }
+  }
+
+  // 没有命中任何行时返回空表，不带分区列，和有结果时一致
+  std::shared_ptr<arrow::Table> table;
+  if (pieces.empty()) {
+    auto schema = dataset->schema();
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    if (query.columns.empty()) {
+      for (const auto& field : schema->fields()) {
+        if ((layout.num_buckets > 0 && field->name() == "bucket") ||
+            (layout.year_partitioned && field->name() == "year")) {
+          continue;
+        }
+        fields.push_back(field);
+      }
+    }
+    for (const auto& name : query.columns) {
+      auto field = schema->GetFieldByName(name);
+      if (field == nullptr) return arrow::Status::KeyError("no column '", name, "'");
+      fields.push_back(field);
+    }
+    return arrow::Table::MakeEmpty(arrow::schema(fields));
+  }
+  ARROW_ASSIGN_OR_RAISE(table, arrow::ConcatenateTables(pieces));
+
+  // (4) 精确过滤，再按请求的顺序取列
+  std::vector<arrow::Datum> masks;
+  if (!funds.empty()) {
+    arrow::StringBuilder code_builder;
+    ARROW_RETURN_NOT_OK(code_builder.AppendValues(funds));
+    ARROW_ASSIGN_OR_RAISE(auto codes, code_builder.Finish());
+    ARROW_ASSIGN_OR_RAISE(
+        arrow::Datum mask,
+        arrow::compute::IsIn(table->GetColumnByName("fund_code"),
+                             arrow::compute::SetLookupOptions(codes)));
+    masks.push_back(std::move(mask));
+  }
+  if (query.has_date_range()) {
+    auto date = table->GetColumnByName("date");
+    ARROW_ASSIGN_OR_RAISE(
+        arrow::Datum lower,
+        arrow::compute::CallFunction(
+            "greater_equal", {date, std::make_shared<arrow::Date32Scalar>(query.min_date)}));
+    ARROW_ASSIGN_OR_RAISE(
+        arrow::Datum upper,
+        arrow::compute::CallFunction(
+            "less_equal", {date, std::make_shared<arrow::Date32Scalar>(query.max_date)}));
+    masks.push_back(std::move(lower));
+    masks.push_back(std::move(upper));
+  }
+  if (!masks.empty()) {
+    arrow::Datum mask = masks.front();
+    for (size_t i = 1; i < masks.size(); ++i) {
+      ARROW_ASSIGN_OR_RAISE(mask, arrow::compute::And(mask, masks[i]));
+    }
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum filtered, arrow::compute::Filter(table, mask));
+    table = filtered.table();
+  }
+  if (!query.columns.empty()) {
+    std::vector<int> indices;
+    for (const auto& name : query.columns) {
+      indices.push_back(table->schema()->GetFieldIndex(name));
+    }
+    ARROW_ASSIGN_OR_RAISE(table, table->SelectColumns(indices));
+  }
+  stats->rows_returned = table->num_rows();
+  return table;
+}
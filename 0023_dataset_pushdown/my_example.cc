@@ -0,0 +1,160 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "../0022_bucketed_layout/bucketed_layout.h"
+#include "../fund_panel/fund_panel.h"
+#include "fund_query.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+void PrintStats(const std::string& name, double ms, const FundQueryStats& stats) {
+  std::cout << "  " << name << ": " << ms << " ms, rows " << stats.rows_returned << " (decoded "
+            << stats.rows_decoded << "), fragments " << stats.fragments_read << "/"
+            << stats.fragments << ", row groups " << stats.row_groups_read << "/"
+            << stats.row_groups << std::endl;
+  std::cout << "    bytes read " << stats.bytes_read / 1024 << " KB, skipped: fragments "
+            << stats.bytes_skipped_fragments / 1024 << " KB, row groups "
+            << stats.bytes_skipped_row_groups / 1024 << " KB, columns "
+            << stats.bytes_skipped_columns / 1024 << " KB; pages outside range "
+            << stats.bytes_outside_pages / 1024 << " KB" << std::endl;
+}
+
+// (文档部分: 不下推)
+// 和 0004_datasets 一样：NewScan 之后直接 Finish，读入所有行和列，再在内存里过滤
+arrow::Result<std::shared_ptr<arrow::Table>> ScanEverything(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset, const FundQuery& query) {
+  ARROW_ASSIGN_OR_RAISE(auto scan_builder, dataset->NewScan());
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scan_builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(auto table, scanner->ToTable());
+  ARROW_ASSIGN_OR_RAISE(auto predicate, query.ToExpression().Bind(*table->schema()));
+  ARROW_ASSIGN_OR_RAISE(auto batch, table->CombineChunksToBatch());
+  ARROW_ASSIGN_OR_RAISE(
+      arrow::Datum mask,
+      arrow::compute::ExecuteScalarExpression(predicate, arrow::compute::ExecBatch(*batch)));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum filtered, arrow::compute::Filter(batch, mask));
+  ARROW_ASSIGN_OR_RAISE(table, arrow::Table::FromRecordBatches({filtered.record_batch()}));
+  return table->SelectColumns({table->schema()->GetFieldIndex("fund_code"),
+                               table->schema()->GetFieldIndex("date"),
+                               table->schema()->GetFieldIndex("adj_nav")});
+}
+// (文档部分: 不下推)
+
+// (文档部分: 扫描器下推)
+// 同样的表达式交给 ScannerBuilder：分区裁剪和 row group 统计信息由数据集完成
+arrow::Result<std::shared_ptr<arrow::Table>> ScanWithPushdown(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset, const FundQuery& query,
+    const FundQueryLayout& layout) {
+  ARROW_ASSIGN_OR_RAISE(auto scan_builder, dataset->NewScan());
+  ARROW_RETURN_NOT_OK(scan_builder->Filter(query.ToExpression(layout)));
+  ARROW_RETURN_NOT_OK(scan_builder->Project(query.columns));
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scan_builder->Finish());
+  return scanner->ToTable();
+}
+// (文档部分: 扫描器下推)
+
+arrow::Status RunQuery(const std::string& name,
+                       const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+                       const FundQuery& query, const FundQueryLayout& layout) {
+  std::cout << "== " << name << std::endl;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto everything, ScanEverything(dataset, query));
+  std::cout << "  scan everything, filter in memory: " << ElapsedMs(start_time) << " ms, rows "
+            << everything->num_rows() << std::endl;
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto scanned, ScanWithPushdown(dataset, query, layout));
+  std::cout << "  scanner Filter + Project: " << ElapsedMs(start_time) << " ms, rows "
+            << scanned->num_rows() << std::endl;
+
+  // (文档部分: 查询)
+  FundQueryStats stats;
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto table, ReadFundQuery(dataset, query, layout, &stats));
+  PrintStats("ReadFundQuery", ElapsedMs(start_time), stats);
+  // (文档部分: 查询)
+
+  if (table->num_rows() != everything->num_rows() ||
+      scanned->num_rows() != everything->num_rows()) {
+    return arrow::Status::Invalid("row counts differ for ", name);
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status RunMain() {
+  // (文档部分: 生成数据集)
+  // 0022 的 bucket + year 布局：5000 只基金、1500 个交易日（约 6 年）
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 5000;
+  panel_options.num_days = 1500;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  const std::string root = std::filesystem::current_path().string();
+  ARROW_ASSIGN_OR_RAISE(auto fs, arrow::fs::FileSystemFromUriOrPath(root));
+  const std::string base_dir = root + "/bucketed_dataset";
+  std::filesystem::remove_all(base_dir);
+  // row group 和 page 都设小一些，每个文件有几个 row group、每个 row group 有多个 page，
+  // 看统计信息和 page index 各能跳过多少
+  BucketedLayoutOptions layout_options;
+  layout_options.min_rows_per_group = 16 * 1024;
+  layout_options.max_rows_per_group = 16 * 1024;
+  layout_options.parquet_options.page_rows = 2000;
+  ARROW_RETURN_NOT_OK(WriteBucketedDataset(panel, fs, base_dir, layout_options));
+
+  // 分区列按写入时的类型解析，查询条件里的字面量类型才能和分区表达式对上
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  arrow::dataset::FileSystemFactoryOptions factory_options;
+  factory_options.partitioning = BucketedPartitioning();
+  ARROW_ASSIGN_OR_RAISE(auto factory, arrow::dataset::FileSystemDatasetFactory::Make(
+                                          fs, selector,
+                                          std::make_shared<arrow::dataset::ParquetFileFormat>(),
+                                          factory_options));
+  ARROW_ASSIGN_OR_RAISE(auto dataset, factory->Finish());
+  const FundQueryLayout layout = BucketedQueryLayout(layout_options);
+  // (文档部分: 生成数据集)
+
+  // (文档部分: 查询)
+  const int32_t first_day = panel_options.start_date;
+  FundQuery query;
+  query.columns = {"fund_code", "date", "adj_nav"};
+  query.funds = {FundCode(1234)};
+  ARROW_RETURN_NOT_OK(RunQuery("one fund, all dates", dataset, query, layout));
+
+  query.min_date = TradingDay(first_day, 500);
+  query.max_date = TradingDay(first_day, 749);
+  ARROW_RETURN_NOT_OK(RunQuery("one fund, one year", dataset, query, layout));
+
+  query.funds.clear();
+  for (int i = 0; i < 20; ++i) query.funds.push_back(FundCode(i * 250 + 1));
+  query.min_date = TradingDay(first_day, 1440);
+  query.max_date = TradingDay(first_day, 1499);
+  ARROW_RETURN_NOT_OK(RunQuery("20 funds, last 60 days", dataset, query, layout));
+
+  // 不限基金时桶号帮不上忙，文件内按基金排序，统计信息和 page index 也跳不过多少
+  query.funds.clear();
+  ARROW_RETURN_NOT_OK(RunQuery("all funds, last 60 days", dataset, query, layout));
+  // (文档部分: 查询)
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
@@ -0,0 +1,461 @@
+// 数据集的元数据缓存：把目录下每个 Parquet 文件的路径、大小、修改时间、分区取值、
+// 各 row group 的行数和 date / fund_code 统计信息存进一个 Arrow IPC 文件
+// （默认 root/_manifest.arrow），文件的 schema 序列化后放在 IPC schema 的元数据里。
+// FileSystemDatasetFactory 每次都要递归列目录、解析分区路径、打开 footer 推断 schema，
+// 查询时再逐个打开 footer 读统计信息；有了 manifest，DatasetFromManifest 只读一个文件，
+// 用 ParquetFileFormat::MakeFragment 直接构造 fragment：
+//   - 分区表达式里除了分区取值，还加上文件的日期范围和基金代码范围，
+//     GetFragments 不读 footer 也能裁剪；
+//   - 给定 FundQuery 时先用 manifest 里的 row group 统计信息选出文件和 row group，
+//     只为可能命中的 row group 构造 fragment。
+// RefreshManifest 列一次目录，大小和修改时间都没变的文件直接沿用旧记录，
+// 只读新增和修改过的文件的 footer，已删除的文件从 manifest 中去掉。
+// _ 和 . 开头的文件和目录会被跳过，和 FileSystemDatasetFactory 的默认规则一致。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <arrow/util/base64.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/arrow/schema.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/statistics.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../0022_bucketed_layout/bucketed_layout.h"
+#include "../0023_dataset_pushdown/fund_query.h"
+
+constexpr char kManifestFileName[] = "_manifest.arrow";
+
+struct ManifestRowGroup {
+  int64_t num_rows = 0;
+  // 没有统计信息时为 false，此时下面的范围没有意义，不能用来裁剪
+  bool has_statistics = false;
+  int32_t min_date = 0;
+  int32_t max_date = 0;
+  std::string min_fund;
+  std::string max_fund;
+};
+
+struct ManifestFile {
+  // 相对于数据集根目录的路径
+  std::string path;
+  int64_t size = 0;
+  int64_t mtime_ns = 0;
+  // 各分区字段的取值，和 DatasetManifest::partition_schema 一一对应，缺失的字段为 null
+  std::vector<std::shared_ptr<arrow::Scalar>> partition_values;
+  std::vector<ManifestRowGroup> row_groups;
+};
+
+struct DatasetManifest {
+  // Hive 分区的字段，例如 0022 的 (bucket, year)
+  std::shared_ptr<arrow::Schema> partition_schema;
+  // 所有文件共同的 schema，第一次读 footer 时确定
+  std::shared_ptr<arrow::Schema> file_schema;
+  // 按路径排序
+  std::vector<ManifestFile> files;
+};
+
+struct ManifestRefreshStats {
+  int64_t files = 0;
+  int64_t unchanged = 0;
+  int64_t added = 0;
+  int64_t changed = 0;
+  int64_t removed = 0;
+};
+
+namespace dataset_manifest_internal {
+
+inline std::vector<std::string> SplitPath(const std::string& path) {
+  std::vector<std::string> segments;
+  size_t begin = 0;
+  while (begin <= path.size()) {
+    size_t end = path.find('/', begin);
+    if (end == std::string::npos) end = path.size();
+    segments.push_back(path.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return segments;
+}
+
+inline arrow::Result<ManifestFile> ReadFooter(
+    const std::shared_ptr<arrow::fs::FileSystem>& filesystem, const arrow::fs::FileInfo& info,
+    const std::string& relative_path, const arrow::Schema& partition_schema,
+    std::shared_ptr<arrow::Schema>* file_schema) {
+  ManifestFile file;
+  file.path = relative_path;
+  file.size = info.size();
+  file.mtime_ns = info.mtime().time_since_epoch().count();
+
+  // 分区取值：路径中每一级 "name=value" 的目录
+  file.partition_values.resize(partition_schema.num_fields());
+  for (int i = 0; i < partition_schema.num_fields(); ++i) {
+    file.partition_values[i] = arrow::MakeNullScalar(partition_schema.field(i)->type());
+  }
+  auto segments = SplitPath(relative_path);
+  segments.pop_back();
+  for (const auto& segment : segments) {
+    ARROW_ASSIGN_OR_RAISE(auto key, arrow::dataset::HivePartitioning::ParseKey(
+                                        segment, arrow::dataset::HivePartitioningOptions()));
+    if (!key.has_value() || !key->value.has_value()) continue;
+    const int index = partition_schema.GetFieldIndex(key->name);
+    if (index < 0) continue;
+    ARROW_ASSIGN_OR_RAISE(file.partition_values[index],
+                          arrow::Scalar::Parse(partition_schema.field(index)->type(),
+                                               *key->value));
+  }
+
+  ARROW_ASSIGN_OR_RAISE(auto infile, filesystem->OpenInputFile(info));
+  parquet::arrow::FileReaderBuilder builder;
+  ARROW_RETURN_NOT_OK(builder.Open(infile));
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  ARROW_RETURN_NOT_OK(builder.Build(&reader));
+  std::shared_ptr<arrow::Schema> schema;
+  ARROW_RETURN_NOT_OK(reader->GetSchema(&schema));
+  if (*file_schema == nullptr) {
+    *file_schema = schema;
+  } else if (!schema->Equals(**file_schema, /*check_metadata=*/false)) {
+    return arrow::Status::Invalid(relative_path, " has a different schema: ",
+                                  schema->ToString());
+  }
+
+  auto metadata = reader->parquet_reader()->metadata();
+  const int date_index = metadata->schema()->ColumnIndex("date");
+  const int fund_index = metadata->schema()->ColumnIndex("fund_code");
+  for (int rg = 0; rg < metadata->num_row_groups(); ++rg) {
+    auto row_group = metadata->RowGroup(rg);
+    ManifestRowGroup entry;
+    entry.num_rows = row_group->num_rows();
+    if (date_index >= 0 && fund_index >= 0) {
+      auto dates = row_group->ColumnChunk(date_index)->statistics();
+      auto funds = row_group->ColumnChunk(fund_index)->statistics();
+      if (dates != nullptr && dates->HasMinMax() && funds != nullptr && funds->HasMinMax()) {
+        auto typed_dates = std::static_pointer_cast<parquet::Int32Statistics>(dates);
+        auto typed_funds = std::static_pointer_cast<parquet::ByteArrayStatistics>(funds);
+        entry.has_statistics = true;
+        entry.min_date = typed_dates->min();
+        entry.max_date = typed_dates->max();
+        entry.min_fund = parquet::ByteArrayToString(typed_funds->min());
+        entry.max_fund = parquet::ByteArrayToString(typed_funds->max());
+      }
+    }
+    file.row_groups.push_back(std::move(entry));
+  }
+  return file;
+}
+
+// 文件的分区表达式：分区取值，加上所有 row group 合起来的日期范围和基金代码范围
+inline arrow::compute::Expression FileGuarantee(const DatasetManifest& manifest,
+                                                const ManifestFile& file) {
+  namespace cp = arrow::compute;
+  std::vector<cp::Expression> conditions;
+  for (int i = 0; i < manifest.partition_schema->num_fields(); ++i) {
+    if (!file.partition_values[i]->is_valid) continue;
+    conditions.push_back(cp::equal(cp::field_ref(manifest.partition_schema->field(i)->name()),
+                                   cp::literal(file.partition_values[i])));
+  }
+  bool has_statistics = !file.row_groups.empty();
+  int32_t min_date = std::numeric_limits<int32_t>::max();
+  int32_t max_date = std::numeric_limits<int32_t>::min();
+  std::string min_fund, max_fund;
+  for (size_t rg = 0; rg < file.row_groups.size(); ++rg) {
+    const auto& row_group = file.row_groups[rg];
+    has_statistics &= row_group.has_statistics;
+    min_date = std::min(min_date, row_group.min_date);
+    max_date = std::max(max_date, row_group.max_date);
+    if (rg == 0 || row_group.min_fund < min_fund) min_fund = row_group.min_fund;
+    if (rg == 0 || row_group.max_fund > max_fund) max_fund = row_group.max_fund;
+  }
+  if (has_statistics) {
+    conditions.push_back(
+        cp::greater_equal(cp::field_ref("date"), cp::literal(arrow::Date32Scalar(min_date))));
+    conditions.push_back(
+        cp::less_equal(cp::field_ref("date"), cp::literal(arrow::Date32Scalar(max_date))));
+    conditions.push_back(cp::greater_equal(cp::field_ref("fund_code"), cp::literal(min_fund)));
+    conditions.push_back(cp::less_equal(cp::field_ref("fund_code"), cp::literal(max_fund)));
+  }
+  return cp::and_(conditions);
+}
+
+// 用 manifest 里的统计信息判断 row group 是否可能命中查询，funds 已排序
+inline bool MayMatch(const ManifestRowGroup& row_group, const FundQuery& query,
+                     const std::vector<std::string>& funds) {
+  if (!row_group.has_statistics) return true;
+  if (row_group.max_date < query.min_date || row_group.min_date > query.max_date) return false;
+  if (funds.empty()) return true;
+  auto it = std::lower_bound(funds.begin(), funds.end(), row_group.min_fund);
+  return it != funds.end() && *it <= row_group.max_fund;
+}
+
+}  // namespace dataset_manifest_internal
+
+// 列一次 base_dir，更新 manifest：只读新增和修改过的文件的 footer。
+// manifest 为空时（只设置了 partition_schema）就是从头建立
+inline arrow::Result<ManifestRefreshStats> RefreshManifest(
+    const std::shared_ptr<arrow::fs::FileSystem>& filesystem, const std::string& base_dir,
+    DatasetManifest* manifest) {
+  if (manifest->partition_schema == nullptr) manifest->partition_schema = arrow::schema({});
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  ARROW_ASSIGN_OR_RAISE(auto infos, filesystem->GetFileInfo(selector));
+
+  std::map<std::string, ManifestFile*> known;
+  for (auto& file : manifest->files) known[file.path] = &file;
+  ManifestRefreshStats stats;
+  std::vector<ManifestFile> files;
+  for (const auto& info : infos) {
+    if (!info.IsFile()) continue;
+    if (info.path().compare(0, base_dir.size() + 1, base_dir + "/") != 0) {
+      return arrow::Status::Invalid(info.path(), " is not under ", base_dir);
+    }
+    const std::string relative = info.path().substr(base_dir.size() + 1);
+    bool ignored = false;
+    for (const auto& segment : dataset_manifest_internal::SplitPath(relative)) {
+      ignored |= segment.empty() || segment[0] == '_' || segment[0] == '.';
+    }
+    if (ignored) continue;
+    ++stats.files;
+    auto it = known.find(relative);
+    if (it != known.end() && it->second->size == info.size() &&
+        it->second->mtime_ns == info.mtime().time_since_epoch().count()) {
+      ++stats.unchanged;
+      files.push_back(std::move(*it->second));
+      known.erase(it);
+      continue;
+    }
+    ++(it == known.end() ? stats.added : stats.changed);
+    if (it != known.end()) known.erase(it);
+    ARROW_ASSIGN_OR_RAISE(auto file, dataset_manifest_internal::ReadFooter(
+                                         filesystem, info, relative,
+                                         *manifest->partition_schema, &manifest->file_schema));
+    files.push_back(std::move(file));
+  }
+  stats.removed = static_cast<int64_t>(known.size());
+  std::sort(files.begin(), files.end(),
+            [](const ManifestFile& a, const ManifestFile& b) { return a.path < b.path; });
+  manifest->files = std::move(files);
+  return stats;
+}
+
+// 每个 row group 一行，分区取值是一个 struct 列（字段就是 partition_schema），
+// 没有 row group 的文件也占一行，row_group 为 -1
+inline arrow::Status WriteManifest(const DatasetManifest& manifest,
+                                   const std::shared_ptr<arrow::fs::FileSystem>& filesystem,
+                                   const std::string& path) {
+  if (manifest.file_schema == nullptr) {
+    return arrow::Status::Invalid("manifest has no file schema");
+  }
+  arrow::StringBuilder path_builder, min_fund_builder, max_fund_builder;
+  arrow::Int64Builder size_builder, mtime_builder, rows_builder;
+  arrow::Int32Builder row_group_builder;
+  arrow::Date32Builder min_date_builder, max_date_builder;
+  std::vector<std::shared_ptr<arrow::ArrayBuilder>> partition_builders;
+  for (const auto& field : manifest.partition_schema->fields()) {
+    ARROW_ASSIGN_OR_RAISE(auto builder, arrow::MakeBuilder(field->type()));
+    partition_builders.push_back(std::move(builder));
+  }
+  auto append_row = [&](const ManifestFile& file, int32_t rg) -> arrow::Status {
+    ARROW_RETURN_NOT_OK(path_builder.Append(file.path));
+    ARROW_RETURN_NOT_OK(size_builder.Append(file.size));
+    ARROW_RETURN_NOT_OK(mtime_builder.Append(file.mtime_ns));
+    for (size_t i = 0; i < partition_builders.size(); ++i) {
+      ARROW_RETURN_NOT_OK(partition_builders[i]->AppendScalar(*file.partition_values[i]));
+    }
+    ARROW_RETURN_NOT_OK(row_group_builder.Append(rg));
+    const ManifestRowGroup empty;
+    const ManifestRowGroup& row_group = rg < 0 ? empty : file.row_groups[rg];
+    ARROW_RETURN_NOT_OK(rows_builder.Append(row_group.num_rows));
+    if (!row_group.has_statistics) {
+      ARROW_RETURN_NOT_OK(min_date_builder.AppendNull());
+      ARROW_RETURN_NOT_OK(max_date_builder.AppendNull());
+      ARROW_RETURN_NOT_OK(min_fund_builder.AppendNull());
+      return max_fund_builder.AppendNull();
+    }
+    ARROW_RETURN_NOT_OK(min_date_builder.Append(row_group.min_date));
+    ARROW_RETURN_NOT_OK(max_date_builder.Append(row_group.max_date));
+    ARROW_RETURN_NOT_OK(min_fund_builder.Append(row_group.min_fund));
+    return max_fund_builder.Append(row_group.max_fund);
+  };
+  for (const auto& file : manifest.files) {
+    if (file.row_groups.empty()) ARROW_RETURN_NOT_OK(append_row(file, -1));
+    for (int32_t rg = 0; rg < static_cast<int32_t>(file.row_groups.size()); ++rg) {
+      ARROW_RETURN_NOT_OK(append_row(file, rg));
+    }
+  }
+
+  arrow::ArrayVector partition_children;
+  for (auto& builder : partition_builders) {
+    ARROW_ASSIGN_OR_RAISE(auto child, builder->Finish());
+    partition_children.push_back(std::move(child));
+  }
+  // 没有分区时 struct 没有子列，StructArray::Make 推断不出行数，这里直接给出行数
+  auto partition = std::make_shared<arrow::StructArray>(
+      arrow::struct_(manifest.partition_schema->fields()), path_builder.length(),
+      partition_children);
+  ARROW_ASSIGN_OR_RAISE(auto serialized_schema,
+                        arrow::ipc::SerializeSchema(*manifest.file_schema));
+  auto metadata = arrow::key_value_metadata(
+      {"file_schema"}, {arrow::util::base64_encode(serialized_schema->ToString())});
+  auto schema = arrow::schema({arrow::field("path", arrow::utf8()),
+                               arrow::field("size", arrow::int64()),
+                               arrow::field("mtime_ns", arrow::int64()),
+                               arrow::field("partition", partition->type()),
+                               arrow::field("row_group", arrow::int32()),
+                               arrow::field("num_rows", arrow::int64()),
+                               arrow::field("min_date", arrow::date32()),
+                               arrow::field("max_date", arrow::date32()),
+                               arrow::field("min_fund", arrow::utf8()),
+                               arrow::field("max_fund", arrow::utf8())},
+                              metadata);
+  std::vector<std::shared_ptr<arrow::Array>> columns(schema->num_fields());
+  ARROW_RETURN_NOT_OK(path_builder.Finish(&columns[0]));
+  ARROW_RETURN_NOT_OK(size_builder.Finish(&columns[1]));
+  ARROW_RETURN_NOT_OK(mtime_builder.Finish(&columns[2]));
+  columns[3] = partition;
+  ARROW_RETURN_NOT_OK(row_group_builder.Finish(&columns[4]));
+  ARROW_RETURN_NOT_OK(rows_builder.Finish(&columns[5]));
+  ARROW_RETURN_NOT_OK(min_date_builder.Finish(&columns[6]));
+  ARROW_RETURN_NOT_OK(max_date_builder.Finish(&columns[7]));
+  ARROW_RETURN_NOT_OK(min_fund_builder.Finish(&columns[8]));
+  ARROW_RETURN_NOT_OK(max_fund_builder.Finish(&columns[9]));
+  auto batch = arrow::RecordBatch::Make(schema, columns[0]->length(), columns);
+
+  // 先写临时文件再改名，读者不会看到写了一半的 manifest
+  const std::string temp_path = path + ".tmp";
+  ARROW_ASSIGN_OR_RAISE(auto outfile, filesystem->OpenOutputStream(temp_path));
+  ARROW_ASSIGN_OR_RAISE(auto writer, arrow::ipc::MakeFileWriter(outfile, schema));
+  ARROW_RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+  ARROW_RETURN_NOT_OK(writer->Close());
+  ARROW_RETURN_NOT_OK(outfile->Close());
+  return filesystem->Move(temp_path, path);
+}
+
+inline arrow::Result<DatasetManifest> ReadManifest(
+    const std::shared_ptr<arrow::fs::FileSystem>& filesystem, const std::string& path) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, filesystem->OpenInputFile(path));
+  ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(infile));
+  auto schema = reader->schema();
+  DatasetManifest manifest;
+  if (schema->metadata() == nullptr) return arrow::Status::Invalid(path, " has no file schema");
+  ARROW_ASSIGN_OR_RAISE(auto encoded, schema->metadata()->Get("file_schema"));
+  ARROW_ASSIGN_OR_RAISE(auto decoded, arrow::util::base64_decode(encoded));
+  arrow::io::BufferReader schema_reader(std::make_shared<arrow::Buffer>(decoded));
+  arrow::ipc::DictionaryMemo memo;
+  ARROW_ASSIGN_OR_RAISE(manifest.file_schema, arrow::ipc::ReadSchema(&schema_reader, &memo));
+  manifest.partition_schema = arrow::schema(schema->GetFieldByName("partition")->type()->fields());
+
+  for (int b = 0; b < reader->num_record_batches(); ++b) {
+    ARROW_ASSIGN_OR_RAISE(auto batch, reader->ReadRecordBatch(b));
+    const auto& paths = static_cast<const arrow::StringArray&>(*batch->GetColumnByName("path"));
+    const auto& sizes = static_cast<const arrow::Int64Array&>(*batch->GetColumnByName("size"));
+    const auto& mtimes =
+        static_cast<const arrow::Int64Array&>(*batch->GetColumnByName("mtime_ns"));
+    const auto& partition =
+        static_cast<const arrow::StructArray&>(*batch->GetColumnByName("partition"));
+    const auto& row_groups =
+        static_cast<const arrow::Int32Array&>(*batch->GetColumnByName("row_group"));
+    const auto& rows = static_cast<const arrow::Int64Array&>(*batch->GetColumnByName("num_rows"));
+    const auto& min_dates =
+        static_cast<const arrow::Date32Array&>(*batch->GetColumnByName("min_date"));
+    const auto& max_dates =
+        static_cast<const arrow::Date32Array&>(*batch->GetColumnByName("max_date"));
+    const auto& min_funds =
+        static_cast<const arrow::StringArray&>(*batch->GetColumnByName("min_fund"));
+    const auto& max_funds =
+        static_cast<const arrow::StringArray&>(*batch->GetColumnByName("max_fund"));
+    for (int64_t i = 0; i < batch->num_rows(); ++i) {
+      // 同一个文件的 row group 是连续的几行
+      if (manifest.files.empty() || manifest.files.back().path != paths.GetView(i)) {
+        ManifestFile file;
+        file.path = paths.GetString(i);
+        file.size = sizes.Value(i);
+        file.mtime_ns = mtimes.Value(i);
+        for (int f = 0; f < partition.num_fields(); ++f) {
+          ARROW_ASSIGN_OR_RAISE(auto value, partition.field(f)->GetScalar(i));
+          file.partition_values.push_back(std::move(value));
+        }
+        manifest.files.push_back(std::move(file));
+      }
+      if (row_groups.Value(i) < 0) continue;
+      ManifestRowGroup row_group;
+      row_group.num_rows = rows.Value(i);
+      row_group.has_statistics = min_dates.IsValid(i);
+      if (row_group.has_statistics) {
+        row_group.min_date = min_dates.Value(i);
+        row_group.max_date = max_dates.Value(i);
+        row_group.min_fund = min_funds.GetString(i);
+        row_group.max_fund = max_funds.GetString(i);
+      }
+      manifest.files.back().row_groups.push_back(std::move(row_group));
+    }
+  }
+  return manifest;
+}
+
+// 用 manifest 构造数据集，不列目录、不读 footer。
+// query 为空时包含所有文件和 row group；否则只包含 manifest 统计信息判断为可能命中的。
+// 有 bucket 分区时（layout.num_buckets > 0），一个文件只用它所在桶里的基金判断，同 0023
+inline arrow::Result<std::shared_ptr<arrow::dataset::FileSystemDataset>> DatasetFromManifest(
+    const DatasetManifest& manifest, const std::shared_ptr<arrow::fs::FileSystem>& filesystem,
+    const std::string& base_dir, const FundQuery& query = FundQuery(),
+    const FundQueryLayout& layout = FundQueryLayout()) {
+  if (manifest.file_schema == nullptr) {
+    return arrow::Status::Invalid("manifest has no file schema");
+  }
+  arrow::FieldVector fields = manifest.file_schema->fields();
+  for (const auto& field : manifest.partition_schema->fields()) fields.push_back(field);
+  auto schema = arrow::schema(fields);
+  const int bucket_index = manifest.partition_schema->GetFieldIndex("bucket");
+
+  std::vector<std::string> funds = query.funds;
+  std::sort(funds.begin(), funds.end());
+  auto format = std::make_shared<arrow::dataset::ParquetFileFormat>();
+  std::vector<std::shared_ptr<arrow::dataset::FileFragment>> fragments;
+  std::vector<std::string> file_funds;
+  for (const auto& file : manifest.files) {
+    const std::vector<std::string>* candidates = &funds;
+    if (!funds.empty() && layout.num_buckets > 0 && bucket_index >= 0 &&
+        file.partition_values[bucket_index]->is_valid) {
+      const int32_t bucket =
+          static_cast<const arrow::Int32Scalar&>(*file.partition_values[bucket_index]).value;
+      file_funds.clear();
+      for (const auto& code : funds) {
+        if (FundBucket(code, layout.num_buckets) == bucket) file_funds.push_back(code);
+      }
+      if (file_funds.empty()) continue;
+      candidates = &file_funds;
+    }
+    std::vector<int> row_groups;
+    for (int rg = 0; rg < static_cast<int>(file.row_groups.size()); ++rg) {
+      if (dataset_manifest_internal::MayMatch(file.row_groups[rg], query, *candidates)) {
+        row_groups.push_back(rg);
+      }
+    }
+    if (row_groups.empty()) continue;
+
+    // 大小和修改时间已知，打开文件时不用再 stat
+    arrow::fs::FileInfo info(base_dir + "/" + file.path, arrow::fs::FileType::File);
+    info.set_size(file.size);
+    info.set_mtime(arrow::fs::TimePoint(arrow::fs::TimePoint::duration(file.mtime_ns)));
+    ARROW_ASSIGN_OR_RAISE(
+        auto fragment,
+        format->MakeFragment(arrow::dataset::FileSource(std::move(info), filesystem),
+                             dataset_manifest_internal::FileGuarantee(manifest, file),
+                             manifest.file_schema, std::move(row_groups)));
+    fragments.push_back(std::move(fragment));
+  }
+  return arrow::dataset::FileSystemDataset::Make(
+      schema, arrow::compute::literal(true), format, filesystem, std::move(fragments),
+      std::make_shared<arrow::dataset::HivePartitioning>(manifest.partition_schema));
+}
@@ -0,0 +1,194 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "../0014_parquet_nav_writer/nav_writer_properties.h"
+#include "../0015_parquet_pruned_reader/nav_reader.h"
+#include "../0022_bucketed_layout/bucketed_layout.h"
+#include "../0023_dataset_pushdown/fund_query.h"
+#include "../fund_panel/fund_panel.h"
+#include "dataset_manifest.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+// (文档部分: 目录发现)
+// 和 0004_datasets 一样用 FileSystemDatasetFactory 发现文件。
+// inspect_all 为 true 时打开每个 footer 检查 schema，否则只看第一个文件
+arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> Discover(
+    const std::shared_ptr<arrow::fs::FileSystem>& fs, const std::string& base_dir,
+    bool inspect_all) {
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  arrow::dataset::FileSystemFactoryOptions factory_options;
+  factory_options.partitioning = BucketedPartitioning();
+  ARROW_ASSIGN_OR_RAISE(auto factory, arrow::dataset::FileSystemDatasetFactory::Make(
+                                          fs, selector,
+                                          std::make_shared<arrow::dataset::ParquetFileFormat>(),
+                                          factory_options));
+  arrow::dataset::FinishOptions finish_options;
+  if (inspect_all) {
+    finish_options.inspect_options.fragments = arrow::dataset::InspectOptions::kInspectAllFragments;
+  }
+  return factory->Finish(finish_options);
+}
+// (文档部分: 目录发现)
+
+arrow::Result<int64_t> CountRows(const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+                                 const FundQuery& query, const FundQueryLayout& layout) {
+  ARROW_ASSIGN_OR_RAISE(auto scan_builder, dataset->NewScan());
+  ARROW_RETURN_NOT_OK(scan_builder->Filter(query.ToExpression(layout)));
+  ARROW_RETURN_NOT_OK(scan_builder->Project(query.columns));
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scan_builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(auto table, scanner->ToTable());
+  return table->num_rows();
+}
+
+void PrintRefresh(const std::string& name, double ms, const ManifestRefreshStats& stats) {
+  std::cout << name << ": " << ms << " ms, " << stats.files << " files (" << stats.unchanged
+            << " unchanged, " << stats.added << " added, " << stats.changed << " changed, "
+            << stats.removed << " removed)" << std::endl;
+}
+
+arrow::Status RunMain() {
+  // (文档部分: 生成数据集)
+  // 0022 的布局，桶数设大一些，得到几千个小文件
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 5000;
+  panel_options.num_days = 1500;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  const std::string root = std::filesystem::current_path().string();
+  ARROW_ASSIGN_OR_RAISE(auto fs, arrow::fs::FileSystemFromUriOrPath(root));
+  const std::string base_dir = root + "/bucketed_dataset";
+  const std::string manifest_path = base_dir + "/" + kManifestFileName;
+  std::filesystem::remove_all(base_dir);
+  BucketedLayoutOptions layout_options;
+  layout_options.num_buckets = 512;
+  ARROW_RETURN_NOT_OK(WriteBucketedDataset(panel, fs, base_dir, layout_options));
+  const FundQueryLayout layout = BucketedQueryLayout(layout_options);
+  // (文档部分: 生成数据集)
+
+  FundQuery query;
+  query.funds = {FundCode(1234)};
+  query.min_date = TradingDay(panel_options.start_date, 500);
+  query.max_date = TradingDay(panel_options.start_date, 749);
+  query.columns = {"fund_code", "date", "adj_nav"};
+
+  // (文档部分: 对比)
+  for (bool inspect_all : {false, true}) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ARROW_ASSIGN_OR_RAISE(auto dataset, Discover(fs, base_dir, inspect_all));
+    const double discover_ms = ElapsedMs(start_time);
+    start_time = std::chrono::high_resolution_clock::now();
+    ARROW_ASSIGN_OR_RAISE(int64_t rows, CountRows(dataset, query, layout));
+    std::cout << (inspect_all ? "discover, inspect all footers: " : "discover: ")
+              << discover_ms << " ms, query " << ElapsedMs(start_time) << " ms (" << rows
+              << " rows)" << std::endl;
+  }
+
+  // 第一次建立 manifest 要读所有 footer，和发现时检查所有文件差不多
+  DatasetManifest manifest;
+  manifest.partition_schema = BucketedPartitionSchema();
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto refresh_stats, RefreshManifest(fs, base_dir, &manifest));
+  ARROW_RETURN_NOT_OK(WriteManifest(manifest, fs, manifest_path));
+  PrintRefresh("build manifest", ElapsedMs(start_time), refresh_stats);
+  std::cout << "manifest: " << std::filesystem::file_size(manifest_path) / 1024 << " KB"
+            << std::endl;
+
+  // (文档部分: 从 manifest 构造)
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(manifest, ReadManifest(fs, manifest_path));
+  const double load_ms = ElapsedMs(start_time);
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto full_dataset, DatasetFromManifest(manifest, fs, base_dir));
+  const double full_ms = ElapsedMs(start_time);
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(int64_t full_rows, CountRows(full_dataset, query, layout));
+  std::cout << "manifest: load " << load_ms << " ms, dataset " << full_ms << " ms ("
+            << full_dataset->files().size() << " files), query " << ElapsedMs(start_time)
+            << " ms (" << full_rows << " rows)" << std::endl;
+
+  // 按查询构造：只包含 manifest 统计信息判断为可能命中的文件和 row group
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto query_dataset,
+                        DatasetFromManifest(manifest, fs, base_dir, query, layout));
+  const double query_dataset_ms = ElapsedMs(start_time);
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(int64_t query_rows, CountRows(query_dataset, query, layout));
+  std::cout << "manifest, pruned for the query: dataset " << query_dataset_ms << " ms ("
+            << query_dataset->files().size() << " files), query " << ElapsedMs(start_time)
+            << " ms (" << query_rows << " rows)" << std::endl;
+  // (文档部分: 从 manifest 构造)
+  // (文档部分: 对比)
+
+  // (文档部分: 增量刷新)
+  // 改写一个文件（去掉一半的行）、删掉一个文件、新增一个分区
+  const std::string changed = base_dir + "/" + manifest.files[0].path;
+  const std::string removed = base_dir + "/" + manifest.files[1].path;
+  ARROW_ASSIGN_OR_RAISE(auto changed_table, ReadNavParquet(changed, NavReadOptions()));
+  ARROW_RETURN_NOT_OK(WriteNavParquet(*changed_table->Slice(0, changed_table->num_rows() / 2),
+                                      changed));
+  std::filesystem::remove(removed);
+  std::filesystem::create_directories(base_dir + "/bucket=0/year=2030");
+  ARROW_RETURN_NOT_OK(
+      WriteNavParquet(*changed_table, base_dir + "/bucket=0/year=2030/part-0.parquet"));
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(refresh_stats, RefreshManifest(fs, base_dir, &manifest));
+  ARROW_RETURN_NOT_OK(WriteManifest(manifest, fs, manifest_path));
+  PrintRefresh("incremental refresh", ElapsedMs(start_time), refresh_stats);
+
+  // 刷新后的 manifest 和重新发现的数据集行数一致
+  ARROW_ASSIGN_OR_RAISE(manifest, ReadManifest(fs, manifest_path));
+  ARROW_ASSIGN_OR_RAISE(full_dataset, DatasetFromManifest(manifest, fs, base_dir));
+  ARROW_ASSIGN_OR_RAISE(auto discovered, Discover(fs, base_dir, false));
+  ARROW_ASSIGN_OR_RAISE(int64_t manifest_rows, CountRows(full_dataset, FundQuery(), layout));
+  ARROW_ASSIGN_OR_RAISE(int64_t discovered_rows, CountRows(discovered, FundQuery(), layout));
+  std::cout << "rows after refresh: manifest " << manifest_rows << ", discovery "
+            << discovered_rows << std::endl;
+  // (文档部分: 增量刷新)
+
+  // (文档部分: 没有分区)
+  // 一个目录下直接放几个文件，不设置 partition_schema，manifest 里的分区列是没有字段的 struct
+  const std::string flat_dir = root + "/flat_dataset";
+  std::filesystem::remove_all(flat_dir);
+  std::filesystem::create_directories(flat_dir);
+  const int64_t part_rows = panel->num_rows() / 4;
+  for (int part = 0; part < 4; ++part) {
+    ARROW_RETURN_NOT_OK(WriteNavParquet(*panel->Slice(part * part_rows, part_rows),
+                                        flat_dir + "/part-" + std::to_string(part) + ".parquet"));
+  }
+  DatasetManifest flat_manifest;
+  ARROW_RETURN_NOT_OK(RefreshManifest(fs, flat_dir, &flat_manifest).status());
+  ARROW_RETURN_NOT_OK(WriteManifest(flat_manifest, fs, flat_dir + "/" + kManifestFileName));
+  ARROW_ASSIGN_OR_RAISE(flat_manifest, ReadManifest(fs, flat_dir + "/" + kManifestFileName));
+  ARROW_ASSIGN_OR_RAISE(auto flat_dataset,
+                        DatasetFromManifest(flat_manifest, fs, flat_dir, query));
+  ARROW_ASSIGN_OR_RAISE(int64_t flat_rows, CountRows(flat_dataset, query, FundQueryLayout()));
+  std::cout << "unpartitioned manifest: " << flat_manifest.files.size() << " files, "
+            << flat_dataset->files().size() << " files for the query (" << flat_rows
+            << " rows)" << std::endl;
+  // (文档部分: 没有分区)
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
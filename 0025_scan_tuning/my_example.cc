@@ -0,0 +1,118 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "../0022_bucketed_layout/bucketed_layout.h"
+#include "../fund_panel/fund_panel.h"
+#include "scan_tuning.h"
+// (文档部分: 包含)
+
+// 用法：my_example [最大核数]，默认是硬件线程数
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+void PrintScan(const std::string& name, const ScanResult& result) {
+  std::cout << name << ": " << result.rows << " rows, " << result.bytes / (1 << 20) << " MB in "
+            << result.seconds * 1000 << " ms, " << result.gb_per_second() << " GB/s, "
+            << result.batches << " batches" << std::endl;
+}
+
+arrow::Status RunMain(int max_cores) {
+  // (文档部分: 生成数据集)
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 8000;
+  panel_options.num_days = 1500;
+  const std::string root = std::filesystem::current_path().string();
+  ARROW_ASSIGN_OR_RAISE(auto fs, arrow::fs::FileSystemFromUriOrPath(root));
+  const std::string base_dir = root + "/bucketed_dataset";
+  std::filesystem::remove_all(base_dir);
+  {
+    ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+    ARROW_RETURN_NOT_OK(WriteBucketedDataset(panel, fs, base_dir));
+  }
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  arrow::dataset::FileSystemFactoryOptions factory_options;
+  factory_options.partitioning = BucketedPartitioning();
+  ARROW_ASSIGN_OR_RAISE(auto factory, arrow::dataset::FileSystemDatasetFactory::Make(
+                                          fs, selector,
+                                          std::make_shared<arrow::dataset::ParquetFileFormat>(),
+                                          factory_options));
+  ARROW_ASSIGN_OR_RAISE(auto dataset, factory->Finish());
+  // (文档部分: 生成数据集)
+
+  // (文档部分: 默认参数)
+  // 0004_datasets 的做法：默认扫描参数，ToTable 拼成一张表
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto scan_builder, dataset->NewScan());
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scan_builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(auto table, scanner->ToTable());
+  const double to_table_ms = ElapsedMs(start_time);
+  const int64_t table_bytes = arrow::util::TotalBufferSize(*table);
+  std::cout << "default ToTable: " << table->num_rows() << " rows in " << to_table_ms
+            << " ms, " << table_bytes / to_table_ms / 1e6 << " GB/s" << std::endl;
+  table.reset();
+
+  ARROW_ASSIGN_OR_RAISE(auto default_result, RunScan(dataset, ScanTuning()));
+  PrintScan("default options", default_result);
+  // (文档部分: 默认参数)
+
+  // (文档部分: 吞吐和核数)
+  // CPU 线程池从 1 个线程加到 max_cores，其他参数用默认值
+  std::cout << "cores  GB/s" << std::endl;
+  std::vector<int> cores;
+  for (int n = 1; n < max_cores; n *= 2) cores.push_back(n);
+  cores.push_back(max_cores);
+  std::vector<double> throughput;
+  for (int n : cores) {
+    ScanTuning tuning;
+    tuning.cpu_threads = n;
+    ARROW_ASSIGN_OR_RAISE(auto result, RunScan(dataset, tuning));
+    throughput.push_back(result.gb_per_second());
+  }
+  const double peak = *std::max_element(throughput.begin(), throughput.end());
+  for (size_t i = 0; i < cores.size(); ++i) {
+    std::printf("%5d  %5.2f  %s\n", cores[i], throughput[i],
+                std::string(static_cast<int>(50 * throughput[i] / peak), '#').c_str());
+  }
+  // (文档部分: 吞吐和核数)
+
+  // (文档部分: 自动校准)
+  CalibrationOptions calibration;
+  for (int n : cores) calibration.cpu_threads.push_back(n);
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto tuning, CalibrateScan(dataset, {}, calibration));
+  std::cout << "calibrated in " << ElapsedMs(start_time) << " ms: " << tuning.ToString()
+            << std::endl;
+  ARROW_ASSIGN_OR_RAISE(auto tuned_result, RunScan(dataset, tuning));
+  PrintScan("calibrated options", tuned_result);
+  // (文档部分: 自动校准)
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main(int argc, char** argv) {
+  const int max_cores =
+      argc > 1 ? std::stoi(argv[1])
+               : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  arrow::Status st = RunMain(max_cores);
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
@@ -0,0 +1,194 @@
+// 数据集扫描的调优参数：
+//   - fragment_readahead：同时读几个文件（fragment）；
+//   - batch_readahead：每个文件里预读几个 batch；
+//   - batch_size：每个 batch 最多的行数；
+//   - cpu_threads / io_threads：解码用的 CPU 线程池和读文件用的 IO 线程池的大小，0 表示不修改。
+// 线程池是进程全局的，ApplyThreadPools 会影响之后所有的计算和 IO。
+// CalibrateScan 在数据集的前几个文件上做短的探测扫描，每次只改一个参数，保留吞吐最高的取值。
+// 探测扫描读过的文件会留在页缓存里，冷启动时的吞吐要低一些，适合在同一批文件上反复扫描的场景。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/io/api.h>
+#include <arrow/util/byte_size.h>
+#include <arrow/util/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ScanTuning {
+  int32_t fragment_readahead = arrow::dataset::kDefaultFragmentReadahead;
+  int32_t batch_readahead = arrow::dataset::kDefaultBatchReadahead;
+  int64_t batch_size = arrow::dataset::kDefaultBatchSize;
+  int cpu_threads = 0;
+  int io_threads = 0;
+
+  std::string ToString() const {
+    std::ostringstream out;
+    out << "fragment_readahead=" << fragment_readahead << " batch_readahead=" << batch_readahead
+        << " batch_size=" << batch_size << " cpu_threads="
+        << (cpu_threads > 0 ? cpu_threads : arrow::GetCpuThreadPoolCapacity())
+        << " io_threads="
+        << (io_threads > 0 ? io_threads : arrow::io::GetIOThreadPoolCapacity());
+    return out.str();
+  }
+};
+
+struct ScanResult {
+  int64_t rows = 0;
+  int64_t batches = 0;
+  // 解码后的数据量
+  int64_t bytes = 0;
+  double seconds = 0;
+
+  double gb_per_second() const { return seconds > 0 ? bytes / seconds / 1e9 : 0; }
+};
+
+struct CalibrationOptions {
+  // 探测扫描用的文件数，0 表示整个数据集
+  int probe_fragments = 16;
+  // 每个取值扫描几次，取最快的一次
+  int repetitions = 2;
+  std::vector<int> cpu_threads;  // 空表示 1、2、4 …… 直到硬件线程数
+  std::vector<int> io_threads = {4, 8, 16, 32};
+  std::vector<int32_t> fragment_readahead = {1, 2, 4, 8, 16};
+  std::vector<int32_t> batch_readahead = {4, 16, 64};
+  std::vector<int64_t> batch_size = {32 * 1024, 128 * 1024, 512 * 1024};
+};
+
+inline arrow::Status ApplyThreadPools(const ScanTuning& tuning) {
+  if (tuning.cpu_threads > 0) {
+    ARROW_RETURN_NOT_OK(arrow::SetCpuThreadPoolCapacity(tuning.cpu_threads));
+  }
+  if (tuning.io_threads > 0) {
+    ARROW_RETURN_NOT_OK(arrow::io::SetIOThreadPoolCapacity(tuning.io_threads));
+  }
+  return arrow::Status::OK();
+}
+
+inline arrow::Status ApplyScanTuning(arrow::dataset::ScannerBuilder* builder,
+                                     const ScanTuning& tuning) {
+  ARROW_RETURN_NOT_OK(builder->UseThreads(true));
+  ARROW_RETURN_NOT_OK(builder->FragmentReadahead(tuning.fragment_readahead));
+  ARROW_RETURN_NOT_OK(builder->BatchReadahead(tuning.batch_readahead));
+  return builder->BatchSize(tuning.batch_size);
+}
+
+// 按 tuning 扫描一遍数据集，逐个 batch 统计行数和数据量，不把结果拼成一张表
+inline arrow::Result<ScanResult> RunScan(const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+                                         const ScanTuning& tuning,
+                                         const std::vector<std::string>& columns = {}) {
+  ARROW_RETURN_NOT_OK(ApplyThreadPools(tuning));
+  ARROW_ASSIGN_OR_RAISE(auto builder, dataset->NewScan());
+  ARROW_RETURN_NOT_OK(ApplyScanTuning(builder.get(), tuning));
+  if (!columns.empty()) ARROW_RETURN_NOT_OK(builder->Project(columns));
+  ARROW_ASSIGN_OR_RAISE(auto scanner, builder->Finish());
+
+  ScanResult result;
+  auto start_time = std::chrono::steady_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto reader, scanner->ToRecordBatchReader());
+  while (true) {
+    ARROW_ASSIGN_OR_RAISE(auto batch, reader->Next());
+    if (batch == nullptr) break;
+    ++result.batches;
+    result.rows += batch->num_rows();
+    result.bytes += arrow::util::TotalBufferSize(*batch);
+  }
+  ARROW_RETURN_NOT_OK(reader->Close());
+  result.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  return result;
+}
+
+namespace scan_tuning_internal {
+
+// 只含数据集前 n 个文件的数据集，用于探测扫描
+inline arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> ProbeDataset(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset, int n) {
+  auto file_dataset = std::dynamic_pointer_cast<arrow::dataset::FileSystemDataset>(dataset);
+  if (n <= 0 || file_dataset == nullptr) return dataset;
+  ARROW_ASSIGN_OR_RAISE(auto fragment_iterator, file_dataset->GetFragments());
+  std::vector<std::shared_ptr<arrow::dataset::FileFragment>> fragments;
+  for (auto maybe_fragment : fragment_iterator) {
+    ARROW_ASSIGN_OR_RAISE(auto fragment, std::move(maybe_fragment));
+    fragments.push_back(std::static_pointer_cast<arrow::dataset::FileFragment>(fragment));
+    if (static_cast<int>(fragments.size()) == n) break;
+  }
+  ARROW_ASSIGN_OR_RAISE(
+      auto probe, arrow::dataset::FileSystemDataset::Make(
+                      file_dataset->schema(), file_dataset->partition_expression(),
+                      file_dataset->format(), file_dataset->filesystem(), std::move(fragments),
+                      file_dataset->partitioning()));
+  return probe;
+}
+
+// 依次尝试 values 中的每个取值，把最快的写回 *field
+template <typename T>
+arrow::Result<double> Sweep(const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+                            const std::vector<std::string>& columns, int repetitions,
+                            const std::vector<T>& values, ScanTuning* tuning,
+                            T ScanTuning::*field) {
+  double best = -1;
+  T best_value = tuning->*field;
+  for (const T& value : values) {
+    ScanTuning candidate = *tuning;
+    candidate.*field = value;
+    double seconds = 0;
+    for (int r = 0; r < repetitions; ++r) {
+      ARROW_ASSIGN_OR_RAISE(auto result, RunScan(dataset, candidate, columns));
+      seconds = r == 0 ? result.seconds : std::min(seconds, result.seconds);
+    }
+    if (best < 0 || seconds < best) {
+      best = seconds;
+      best_value = value;
+    }
+  }
+  tuning->*field = best_value;
+  return best;
+}
+
+}  // namespace scan_tuning_internal
+
+// 逐个参数做探测扫描，返回吞吐最高的组合。线程池最后被设成返回的大小
+inline arrow::Result<ScanTuning> CalibrateScan(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+    const std::vector<std::string>& columns = {},
+    const CalibrationOptions& options = CalibrationOptions()) {
+  ARROW_ASSIGN_OR_RAISE(auto probe,
+                        scan_tuning_internal::ProbeDataset(dataset, options.probe_fragments));
+  std::vector<int> cpu_threads = options.cpu_threads;
+  if (cpu_threads.empty()) {
+    const int hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (int n = 1; n < hardware; n *= 2) cpu_threads.push_back(n);
+    cpu_threads.push_back(hardware);
+  }
+  ScanTuning tuning;
+  tuning.cpu_threads = arrow::GetCpuThreadPoolCapacity();
+  tuning.io_threads = arrow::io::GetIOThreadPoolCapacity();
+  // 先预热一次，让探测扫描都在同样的缓存状态下进行
+  ARROW_RETURN_NOT_OK(RunScan(probe, tuning, columns).status());
+  const int repetitions = options.repetitions;
+  using scan_tuning_internal::Sweep;
+  ARROW_RETURN_NOT_OK(
+      Sweep(probe, columns, repetitions, cpu_threads, &tuning, &ScanTuning::cpu_threads)
+          .status());
+  ARROW_RETURN_NOT_OK(
+      Sweep(probe, columns, repetitions, options.io_threads, &tuning, &ScanTuning::io_threads)
+          .status());
+  ARROW_RETURN_NOT_OK(Sweep(probe, columns, repetitions, options.fragment_readahead, &tuning,
+                            &ScanTuning::fragment_readahead)
+                          .status());
+  ARROW_RETURN_NOT_OK(Sweep(probe, columns, repetitions, options.batch_readahead, &tuning,
+                            &ScanTuning::batch_readahead)
+                          .status());
+  ARROW_RETURN_NOT_OK(
+      Sweep(probe, columns, repetitions, options.batch_size, &tuning, &ScanTuning::batch_size)
+          .status());
+  ARROW_RETURN_NOT_OK(ApplyThreadPools(tuning));
+  return tuning;
+}
@@ -0,0 +1,313 @@
+// 数据集的压缩和重新排序。目录结构：
+//   root/CURRENT                         当前版本的目录名，例如 "v000002"
+//   root/v000002/year=2016/part-0.parquet
+// 每次压缩都写一个新的版本目录：选中的分区把所有小文件读出来，按 sort_keys 排序后
+// 重写成每个最多 max_rows_per_file 行的文件；其他分区的文件用硬链接放进新目录，不复制数据。
+// 新版本先写到临时目录 v000003.tmp，写完后 rename 成 v000003，再写 CURRENT.tmp 并 rename 成
+// CURRENT，读者要么看到旧版本、要么看到新版本。压缩中途退出留下的临时目录和比 CURRENT 新的
+// 版本目录都没有发布过，下次压缩时删掉，新版本的编号总是 CURRENT 加一。
+// 旧版本保留 keep_versions 个，已经打开旧版本的读者可以继续读。
+// 用 std::filesystem 做硬链接和 rename，只支持本地文件系统。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../0014_parquet_nav_writer/nav_writer_properties.h"
+#include "../0015_parquet_pruned_reader/nav_reader.h"
+
+constexpr char kCurrentFileName[] = "CURRENT";
+
+struct CompactionOptions {
+  // 压缩后文件内的排序键，默认按日期，日期范围查询可以用 row group 统计信息跳过
+  std::vector<std::string> sort_keys = {"date", "fund_code"};
+  // 每个文件最多的行数
+  int64_t max_rows_per_file = 4 << 20;
+  // 写入配置，row_group_rows 决定压缩后 row group 的大小
+  NavParquetOptions parquet_options;
+  // 只压缩这些分区（相对于版本目录的路径，例如 "year=2016"），空表示全部
+  std::vector<std::string> partitions;
+  // 压缩后保留的版本数（包括新版本）
+  int keep_versions = 2;
+};
+
+struct CompactionStats {
+  std::string old_version;
+  std::string new_version;
+  int partitions_compacted = 0;
+  int64_t files_before = 0;
+  int64_t files_after = 0;
+  // 硬链接到新版本的文件数
+  int64_t files_linked = 0;
+  int64_t row_groups_before = 0;
+  int64_t row_groups_after = 0;
+  int64_t rows_rewritten = 0;
+  double seconds = 0;
+};
+
+namespace dataset_compaction_internal {
+
+inline std::string VersionName(int version) {
+  char name[16];
+  std::snprintf(name, sizeof(name), "v%06d", version);
+  return name;
+}
+
+// VersionName 生成的目录名：v 加 6 位数字。根目录下其他的目录（例如手工备份的 vbackup）不是版本
+inline bool IsVersionName(const std::string& name) {
+  if (name.size() != 7 || name[0] != 'v') return false;
+  return std::all_of(name.begin() + 1, name.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+// 版本编号，name 必须满足 IsVersionName
+inline int VersionNumber(const std::string& name) { return std::stoi(name.substr(1)); }
+
+// 写到一半的新版本目录：版本名加 .tmp
+inline bool IsTempVersionName(const std::string& name) {
+  constexpr char kSuffix[] = ".tmp";
+  const size_t suffix_size = sizeof(kSuffix) - 1;
+  return name.size() > suffix_size &&
+         name.compare(name.size() - suffix_size, suffix_size, kSuffix) == 0 &&
+         IsVersionName(name.substr(0, name.size() - suffix_size));
+}
+
+// 根目录下所有子目录的名字，按名字排序
+inline arrow::Result<std::vector<std::string>> ListDirectories(const std::filesystem::path& root) {
+  std::vector<std::string> names;
+  std::error_code error;
+  for (std::filesystem::directory_iterator it(root, error), end; !error && it != end;
+       it.increment(error)) {
+    const bool is_directory = it->is_directory(error);
+    if (error) break;
+    if (is_directory) names.push_back(it->path().filename().string());
+  }
+  if (error) return arrow::Status::IOError("cannot list ", root.string(), ": ", error.message());
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+inline arrow::Status RemoveDirectory(const std::filesystem::path& path) {
+  std::error_code error;
+  std::filesystem::remove_all(path, error);
+  if (error) return arrow::Status::IOError("cannot remove ", path.string(), ": ", error.message());
+  return arrow::Status::OK();
+}
+
+// 删除没有发布过的目录：压缩中途退出留下的临时目录，和比当前版本新的版本目录
+inline arrow::Status RemoveUnpublishedVersions(const std::filesystem::path& root,
+                                               const std::string& current) {
+  ARROW_ASSIGN_OR_RAISE(auto names, ListDirectories(root));
+  for (const auto& name : names) {
+    if (IsTempVersionName(name) ||
+        (IsVersionName(name) && VersionNumber(name) > VersionNumber(current))) {
+      ARROW_RETURN_NOT_OK(RemoveDirectory(root / name));
+    }
+  }
+  return arrow::Status::OK();
+}
+
+// 版本目录中的数据文件，按所在的分区目录分组，_ 和 . 开头的跳过
+inline arrow::Result<std::map<std::string, std::vector<std::filesystem::path>>> ListPartitions(
+    const std::filesystem::path& version_dir) {
+  std::map<std::string, std::vector<std::filesystem::path>> partitions;
+  std::error_code error;
+  for (std::filesystem::recursive_directory_iterator it(version_dir, error), end;
+       !error && it != end; it.increment(error)) {
+    const bool is_regular_file = it->is_regular_file(error);
+    if (error) break;
+    if (!is_regular_file) continue;
+    const auto relative = it->path().lexically_relative(version_dir);
+    bool ignored = false;
+    for (const auto& segment : relative) {
+      const std::string name = segment.string();
+      ignored |= name.empty() || name[0] == '_' || name[0] == '.';
+    }
+    if (!ignored) partitions[relative.parent_path().generic_string()].push_back(it->path());
+  }
+  if (error) {
+    return arrow::Status::IOError("cannot list ", version_dir.string(), ": ", error.message());
+  }
+  for (auto& [partition, files] : partitions) std::sort(files.begin(), files.end());
+  return partitions;
+}
+
+inline arrow::Result<int64_t> CountRowGroups(const std::filesystem::path& path) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, arrow::io::ReadableFile::Open(path.string()));
+  parquet::arrow::FileReaderBuilder builder;
+  ARROW_RETURN_NOT_OK(builder.Open(infile));
+  return builder.raw_reader()->metadata()->num_row_groups();
+}
+
+}  // namespace dataset_compaction_internal
+
+// 当前版本的目录名
+inline arrow::Result<std::string> CurrentVersion(const std::string& root) {
+  std::ifstream in(root + "/" + kCurrentFileName);
+  std::string version;
+  if (!in || !std::getline(in, version) || version.empty()) {
+    return arrow::Status::IOError("no ", kCurrentFileName, " in ", root);
+  }
+  if (!dataset_compaction_internal::IsVersionName(version)) {
+    return arrow::Status::IOError(kCurrentFileName, " in ", root, " names '", version,
+                                  "', not a version directory");
+  }
+  return version;
+}
+
+// 把 CURRENT 原子地指向 version
+inline arrow::Status PublishVersion(const std::string& root, const std::string& version) {
+  const std::string temp_path = root + "/" + kCurrentFileName + ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::trunc);
+    out << version << "\n";
+    out.flush();
+    if (!out) return arrow::Status::IOError("cannot write ", temp_path);
+  }
+  std::error_code error;
+  std::filesystem::rename(temp_path, root + "/" + kCurrentFileName, error);
+  if (error) return arrow::Status::IOError("cannot publish ", version, ": ", error.message());
+  return arrow::Status::OK();
+}
+
+// 打开当前版本。返回的数据集只引用这个版本的文件，之后的压缩不影响它
+inline arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> OpenCurrentDataset(
+    const std::shared_ptr<arrow::fs::FileSystem>& filesystem, const std::string& root,
+    const std::shared_ptr<arrow::dataset::Partitioning>& partitioning) {
+  ARROW_ASSIGN_OR_RAISE(auto version, CurrentVersion(root));
+  arrow::fs::FileSelector selector;
+  selector.base_dir = root + "/" + version;
+  selector.recursive = true;
+  arrow::dataset::FileSystemFactoryOptions factory_options;
+  factory_options.partitioning = partitioning;
+  ARROW_ASSIGN_OR_RAISE(auto factory, arrow::dataset::FileSystemDatasetFactory::Make(
+                                          filesystem, selector,
+                                          std::make_shared<arrow::dataset::ParquetFileFormat>(),
+                                          factory_options));
+  return factory->Finish();
+}
+
+// 删除没有发布过的目录，以及当前版本之前除最新的 keep 个之外的版本目录（当前版本总是保留）
+inline arrow::Status RemoveOldVersions(const std::string& root, int keep) {
+  using dataset_compaction_internal::IsVersionName;
+  ARROW_ASSIGN_OR_RAISE(auto current, CurrentVersion(root));
+  ARROW_RETURN_NOT_OK(dataset_compaction_internal::RemoveUnpublishedVersions(root, current));
+  ARROW_ASSIGN_OR_RAISE(auto names, dataset_compaction_internal::ListDirectories(root));
+  std::vector<std::string> versions;
+  for (const auto& name : names) {
+    if (IsVersionName(name)) versions.push_back(name);
+  }
+  const int excess = static_cast<int>(versions.size()) - std::max(keep, 1);
+  for (int i = 0; i < excess; ++i) {
+    if (versions[i] == current) continue;
+    ARROW_RETURN_NOT_OK(
+        dataset_compaction_internal::RemoveDirectory(std::filesystem::path(root) / versions[i]));
+  }
+  return arrow::Status::OK();
+}
+
+// 把当前版本压缩成一个新版本并切换过去
+inline arrow::Result<CompactionStats> CompactDataset(
+    const std::string& root, const CompactionOptions& options = CompactionOptions()) {
+  namespace fs = std::filesystem;
+  if (options.max_rows_per_file <= 0) {
+    return arrow::Status::Invalid("max_rows_per_file must be positive, got ",
+                                  options.max_rows_per_file);
+  }
+  auto start_time = std::chrono::steady_clock::now();
+  CompactionStats stats;
+  ARROW_ASSIGN_OR_RAISE(stats.old_version, CurrentVersion(root));
+  // 上次压缩中途退出留下的目录没有发布过，删掉后从 CURRENT 的下一个编号开始
+  ARROW_RETURN_NOT_OK(
+      dataset_compaction_internal::RemoveUnpublishedVersions(root, stats.old_version));
+  stats.new_version = dataset_compaction_internal::VersionName(
+      dataset_compaction_internal::VersionNumber(stats.old_version) + 1);
+  const fs::path old_dir = fs::path(root) / stats.old_version;
+  const fs::path new_dir = fs::path(root) / stats.new_version;
+  const fs::path temp_dir = fs::path(root) / (stats.new_version + ".tmp");
+
+  std::vector<arrow::compute::SortKey> sort_keys;
+  for (const auto& key : options.sort_keys) sort_keys.emplace_back(key);
+  ARROW_ASSIGN_OR_RAISE(auto partitions, dataset_compaction_internal::ListPartitions(old_dir));
+  for (const auto& [partition, files] : partitions) {
+    const fs::path partition_dir = temp_dir / partition;
+    std::error_code error;
+    fs::create_directories(partition_dir, error);
+    if (error) {
+      return arrow::Status::IOError("cannot create ", partition_dir.string(), ": ",
+                                    error.message());
+    }
+    stats.files_before += static_cast<int64_t>(files.size());
+    const bool selected =
+        options.partitions.empty() ||
+        std::find(options.partitions.begin(), options.partitions.end(), partition) !=
+            options.partitions.end();
+    if (!selected) {
+      for (const auto& file : files) {
+        fs::create_hard_link(file, partition_dir / file.filename(), error);
+        if (error) {
+          return arrow::Status::IOError("cannot link ", file.string(), ": ", error.message());
+        }
+        ARROW_ASSIGN_OR_RAISE(int64_t row_groups,
+                              dataset_compaction_internal::CountRowGroups(file));
+        stats.row_groups_before += row_groups;
+        stats.row_groups_after += row_groups;
+        ++stats.files_linked;
+      }
+      stats.files_after += static_cast<int64_t>(files.size());
+      continue;
+    }
+
+    // 选中的分区：读入所有文件，排序后按 max_rows_per_file 切成几个文件
+    ++stats.partitions_compacted;
+    std::vector<std::shared_ptr<arrow::Table>> pieces;
+    for (const auto& file : files) {
+      ARROW_ASSIGN_OR_RAISE(int64_t row_groups, dataset_compaction_internal::CountRowGroups(file));
+      stats.row_groups_before += row_groups;
+      ARROW_ASSIGN_OR_RAISE(auto piece, ReadNavParquet(file.string(), NavReadOptions()));
+      pieces.push_back(std::move(piece));
+    }
+    ARROW_ASSIGN_OR_RAISE(auto table, arrow::ConcatenateTables(pieces));
+    pieces.clear();
+    ARROW_ASSIGN_OR_RAISE(auto indices, arrow::compute::SortIndices(
+                                            table, arrow::compute::SortOptions(sort_keys)));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum sorted, arrow::compute::Take(table, indices));
+    table = sorted.table();
+    stats.rows_rewritten += table->num_rows();
+    int part = 0;
+    for (int64_t offset = 0; offset < table->num_rows(); offset += options.max_rows_per_file) {
+      const fs::path path = partition_dir / ("part-" + std::to_string(part++) + ".parquet");
+      ARROW_RETURN_NOT_OK(WriteNavParquet(*table->Slice(offset, options.max_rows_per_file),
+                                          path.string(), options.parquet_options));
+      ARROW_ASSIGN_OR_RAISE(int64_t row_groups, dataset_compaction_internal::CountRowGroups(path));
+      stats.row_groups_after += row_groups;
+      ++stats.files_after;
+    }
+  }
+
+  // 所有文件都写完才把临时目录换成版本目录
+  std::error_code error;
+  fs::rename(temp_dir, new_dir, error);
+  if (error) {
+    return arrow::Status::IOError("cannot rename ", temp_dir.string(), ": ", error.message());
+  }
+  ARROW_RETURN_NOT_OK(PublishVersion(root, stats.new_version));
+  ARROW_RETURN_NOT_OK(RemoveOldVersions(root, options.keep_versions));
+  stats.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  return stats;
+}
@@ -0,0 +1,174 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "../fund_panel/fund_panel.h"
+#include "dataset_compaction.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+std::shared_ptr<arrow::dataset::Partitioning> YearPartitioning() {
+  return std::make_shared<arrow::dataset::HivePartitioning>(
+      arrow::schema({arrow::field("year", arrow::int64())}));
+}
+
+// (文档部分: 每日写入)
+// 和 0004_datasets 一样用 FileSystemDataset::Write 写一天的数据，按年份分区。
+// 每天写一个新文件，已有的文件不动
+arrow::Status WriteDay(const std::shared_ptr<arrow::Table>& rows,
+                       const std::shared_ptr<arrow::fs::FileSystem>& fs,
+                       const std::string& base_dir, int day) {
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum years, arrow::compute::Year(rows->GetColumnByName("date")));
+  ARROW_ASSIGN_OR_RAISE(auto table, rows->AddColumn(rows->num_columns(),
+                                                    arrow::field("year", arrow::int64()),
+                                                    years.chunked_array()));
+  auto reader = std::make_shared<arrow::TableBatchReader>(table);
+  auto scanner_builder = arrow::dataset::ScannerBuilder::FromRecordBatchReader(reader);
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scanner_builder->Finish());
+  auto format = std::make_shared<arrow::dataset::ParquetFileFormat>();
+  arrow::dataset::FileSystemDatasetWriteOptions write_options;
+  write_options.file_write_options = format->DefaultWriteOptions();
+  write_options.filesystem = fs;
+  write_options.base_dir = base_dir;
+  write_options.partitioning = YearPartitioning();
+  write_options.basename_template = "day-" + std::to_string(day) + "-{i}.parquet";
+  write_options.existing_data_behavior = arrow::dataset::ExistingDataBehavior::kOverwriteOrIgnore;
+  return arrow::dataset::FileSystemDataset::Write(write_options, scanner);
+}
+// (文档部分: 每日写入)
+
+// (文档部分: 扫描)
+// 全表扫描，和最近 20 个交易日的日期范围查询
+arrow::Status BenchmarkScan(const std::string& name,
+                            const std::shared_ptr<arrow::fs::FileSystem>& fs,
+                            const std::string& root, int32_t first_day) {
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto dataset, OpenCurrentDataset(fs, root, YearPartitioning()));
+  const double open_ms = ElapsedMs(start_time);
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto scan_builder, dataset->NewScan());
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scan_builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(auto table, scanner->ToTable());
+  const double scan_ms = ElapsedMs(start_time);
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto range_builder, dataset->NewScan());
+  ARROW_RETURN_NOT_OK(range_builder->Filter(arrow::compute::greater_equal(
+      arrow::compute::field_ref("date"),
+      arrow::compute::literal(arrow::Date32Scalar(first_day)))));
+  ARROW_RETURN_NOT_OK(range_builder->Project({"fund_code", "date", "adj_nav"}));
+  ARROW_ASSIGN_OR_RAISE(auto range_scanner, range_builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(auto range, range_scanner->ToTable());
+  const double range_ms = ElapsedMs(start_time);
+
+  std::cout << name << ": open " << open_ms << " ms, full scan " << table->num_rows()
+            << " rows in " << scan_ms << " ms, last 20 days " << range->num_rows()
+            << " rows in " << range_ms << " ms" << std::endl;
+  return arrow::Status::OK();
+}
+// (文档部分: 扫描)
+
+void PrintCompaction(const CompactionStats& stats) {
+  std::cout << "compacted " << stats.old_version << " -> " << stats.new_version << " in "
+            << stats.seconds * 1000 << " ms: " << stats.partitions_compacted
+            << " partitions, files " << stats.files_before << " -> " << stats.files_after
+            << " (" << stats.files_linked << " linked), row groups " << stats.row_groups_before
+            << " -> " << stats.row_groups_after << ", " << stats.rows_rewritten
+            << " rows rewritten" << std::endl;
+}
+
+arrow::Status RunMain() {
+  // (文档部分: 生成数据集)
+  // 2000 只基金、500 个交易日（2015、2016 两年），每天写一次。
+  // 每天约 5% 的净值晚一天到，和第二天的数据一起写入，所以相邻文件的日期范围有重叠
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 2000;
+  panel_options.num_days = 500;
+  panel_options.date_major = true;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  const int num_funds = panel_options.num_funds;
+  auto late = [](int fund, int day) { return (fund * 7919 + day * 104729) % 20 == 0; };
+
+  const std::string root = std::filesystem::current_path().string() + "/nav_history";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root);
+  ARROW_ASSIGN_OR_RAISE(auto fs, arrow::fs::FileSystemFromUriOrPath(root));
+  const std::string first_version = dataset_compaction_internal::VersionName(1);
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (int day = 0; day <= panel_options.num_days; ++day) {
+    arrow::Int64Builder index_builder;
+    for (int fund = 0; fund < num_funds; ++fund) {
+      if (day > 0 && late(fund, day - 1)) {
+        ARROW_RETURN_NOT_OK(index_builder.Append(int64_t{day - 1} * num_funds + fund));
+      }
+    }
+    for (int fund = 0; day < panel_options.num_days && fund < num_funds; ++fund) {
+      if (!late(fund, day)) {
+        ARROW_RETURN_NOT_OK(index_builder.Append(int64_t{day} * num_funds + fund));
+      }
+    }
+    ARROW_ASSIGN_OR_RAISE(auto indices, index_builder.Finish());
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum rows, arrow::compute::Take(panel, indices));
+    ARROW_RETURN_NOT_OK(WriteDay(rows.table(), fs, root + "/" + first_version, day));
+  }
+  ARROW_RETURN_NOT_OK(PublishVersion(root, first_version));
+  std::cout << "daily writes: " << ElapsedMs(start_time) << " ms" << std::endl;
+  // (文档部分: 生成数据集)
+
+  const int32_t last_20_days = TradingDay(panel_options.start_date, panel_options.num_days - 20);
+  ARROW_RETURN_NOT_OK(BenchmarkScan("before", fs, root, last_20_days));
+
+  // (文档部分: 压缩)
+  // 读者在压缩前打开的数据集，压缩后仍然可以读
+  ARROW_ASSIGN_OR_RAISE(auto old_reader, OpenCurrentDataset(fs, root, YearPartitioning()));
+
+  // 先只压缩已经结束的 2015 年，2016 年的文件硬链接到新版本
+  CompactionOptions options;
+  options.parquet_options.row_group_rows = 64 * 1024;
+  options.partitions = {"year=2015"};
+  ARROW_ASSIGN_OR_RAISE(auto stats, CompactDataset(root, options));
+  PrintCompaction(stats);
+  ARROW_RETURN_NOT_OK(BenchmarkScan("after compacting 2015", fs, root, last_20_days));
+  // 旧版本还在（keep_versions = 2），压缩前打开的读者读到的仍是旧文件
+  ARROW_ASSIGN_OR_RAISE(auto old_builder, old_reader->NewScan());
+  ARROW_ASSIGN_OR_RAISE(auto old_scanner, old_builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(int64_t old_rows, old_scanner->CountRows());
+  std::cout << "reader opened before compaction: " << old_rows << " rows" << std::endl;
+
+  options.partitions.clear();
+  ARROW_ASSIGN_OR_RAISE(stats, CompactDataset(root, options));
+  PrintCompaction(stats);
+  ARROW_RETURN_NOT_OK(BenchmarkScan("after compacting everything", fs, root, last_20_days));
+  // (文档部分: 压缩)
+
+  // 压缩不改变行数
+  ARROW_ASSIGN_OR_RAISE(auto current, OpenCurrentDataset(fs, root, YearPartitioning()));
+  ARROW_ASSIGN_OR_RAISE(auto count_builder, current->NewScan());
+  ARROW_ASSIGN_OR_RAISE(auto count_scanner, count_builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(int64_t rows, count_scanner->CountRows());
+  std::cout << "rows in " << stats.new_version << ": " << rows << " (panel " << panel->num_rows()
+            << ")" << std::endl;
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
@@ -0,0 +1,181 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "../0023_dataset_pushdown/fund_query.h"
+#include "../fund_panel/fund_panel.h"
+#include "sidecar_index.h"
+// (文档部分: 包含)
+
+// 用法：my_example [托管行数] [交易日数]，默认 200 个托管行 × 500 天 = 100000 个文件
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+std::shared_ptr<arrow::dataset::Partitioning> CustodianPartitioning() {
+  return std::make_shared<arrow::dataset::HivePartitioning>(
+      arrow::schema({arrow::field("custodian", arrow::int32())}));
+}
+
+// (文档部分: 每日写入)
+// 和 0004_datasets 一样用 FileSystemDataset::Write 写一天的数据，按托管行分区，
+// 每个托管行每天一个文件。写完一个文件就生成它的 sidecar
+arrow::Status WriteDay(const std::shared_ptr<arrow::Table>& rows,
+                       const std::shared_ptr<arrow::fs::FileSystem>& fs,
+                       const std::string& base_dir, int day) {
+  auto reader = std::make_shared<arrow::TableBatchReader>(rows);
+  auto scanner_builder = arrow::dataset::ScannerBuilder::FromRecordBatchReader(reader);
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scanner_builder->Finish());
+  auto format = std::make_shared<arrow::dataset::ParquetFileFormat>();
+  arrow::dataset::FileSystemDatasetWriteOptions write_options;
+  write_options.file_write_options = format->DefaultWriteOptions();
+  write_options.filesystem = fs;
+  write_options.base_dir = base_dir;
+  write_options.partitioning = CustodianPartitioning();
+  write_options.basename_template = "day-" + std::to_string(day) + "-{i}.parquet";
+  write_options.existing_data_behavior = arrow::dataset::ExistingDataBehavior::kOverwriteOrIgnore;
+  return WriteDatasetWithSidecars(write_options, scanner);
+}
+// (文档部分: 每日写入)
+
+arrow::Result<int64_t> CountRows(const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+                                 const FundQuery& query) {
+  ARROW_ASSIGN_OR_RAISE(auto scan_builder, dataset->NewScan());
+  ARROW_RETURN_NOT_OK(scan_builder->Filter(query.ToExpression()));
+  ARROW_RETURN_NOT_OK(scan_builder->Project(query.columns));
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scan_builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(auto table, scanner->ToTable());
+  return table->num_rows();
+}
+
+void PrintLookup(const std::string& name, double ms, int64_t rows,
+                 const SidecarLookupStats& stats) {
+  std::cout << name << ": " << ms << " ms, " << rows << " rows, row groups " << stats.row_groups
+            << " (zone map pruned " << stats.row_groups_pruned_by_zone_map << ", bloom pruned "
+            << stats.row_groups_pruned_by_bloom << ", read " << stats.row_groups_matched
+            << " in " << stats.files_matched << " files)" << std::endl;
+}
+
+arrow::Status RunMain(int num_custodians, int num_days) {
+  // (文档部分: 生成数据集)
+  // 每个托管行 100 只基金，基金按代码打散到各托管行，
+  // 所以一个文件里的基金代码从头到尾都有，min/max 裁剪不掉任何文件
+  FundPanelOptions panel_options;
+  panel_options.num_funds = num_custodians * 100;
+  panel_options.num_days = num_days;
+  panel_options.date_major = true;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  const int num_funds = panel_options.num_funds;
+  arrow::Int32Builder custodian_builder;
+  for (int fund = 0; fund < num_funds; ++fund) {
+    ARROW_RETURN_NOT_OK(custodian_builder.Append((fund * 7919) % num_custodians));
+  }
+  ARROW_ASSIGN_OR_RAISE(auto custodian_array, custodian_builder.Finish());
+  auto custodians = std::make_shared<arrow::ChunkedArray>(custodian_array);
+
+  const std::string root = std::filesystem::current_path().string();
+  ARROW_ASSIGN_OR_RAISE(auto fs, arrow::fs::FileSystemFromUriOrPath(root));
+  const std::string base_dir = root + "/daily_dataset";
+  std::filesystem::remove_all(base_dir);
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (int day = 0; day < num_days; ++day) {
+    auto rows = panel->Slice(int64_t{day} * num_funds, num_funds);
+    ARROW_ASSIGN_OR_RAISE(rows, rows->AddColumn(rows->num_columns(),
+                                                arrow::field("custodian", arrow::int32()),
+                                                custodians));
+    ARROW_RETURN_NOT_OK(WriteDay(rows, fs, base_dir, day));
+  }
+  std::cout << "daily writes with sidecars: " << int64_t{num_custodians} * num_days
+            << " files in " << ElapsedMs(start_time) << " ms" << std::endl;
+  panel.reset();
+  // (文档部分: 生成数据集)
+
+  FundQuery query;
+  query.funds = {FundCode(1234)};
+  query.columns = {"fund_code", "date", "adj_nav"};
+  FundQuery recent = query;
+  recent.min_date = TradingDay(panel_options.start_date, num_days - 20);
+
+  // (文档部分: 不用索引)
+  // 发现文件后用 Filter 点查：每个文件的 footer 都要打开，min/max 裁剪不掉，
+  // 每个 row group 的 fund_code 列都要解码。第二次查询时 footer 已经缓存在 fragment 里
+  start_time = std::chrono::high_resolution_clock::now();
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  arrow::dataset::FileSystemFactoryOptions factory_options;
+  factory_options.partitioning = CustodianPartitioning();
+  ARROW_ASSIGN_OR_RAISE(auto factory, arrow::dataset::FileSystemDatasetFactory::Make(
+                                          fs, selector,
+                                          std::make_shared<arrow::dataset::ParquetFileFormat>(),
+                                          factory_options));
+  ARROW_ASSIGN_OR_RAISE(auto dataset, factory->Finish());
+  std::cout << "discover: " << ElapsedMs(start_time) << " ms, "
+            << std::static_pointer_cast<arrow::dataset::FileSystemDataset>(dataset)->files().size()
+            << " files" << std::endl;
+  for (const char* name : {"scan, footers cold", "scan, footers cached"}) {
+    start_time = std::chrono::high_resolution_clock::now();
+    ARROW_ASSIGN_OR_RAISE(int64_t rows, CountRows(dataset, query));
+    std::cout << name << ": " << ElapsedMs(start_time) << " ms, " << rows << " rows"
+              << std::endl;
+  }
+  // (文档部分: 不用索引)
+
+  // (文档部分: 用索引)
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto catalog, LoadSidecars(fs, base_dir, CustodianPartitioning()));
+  std::cout << "load sidecars: " << ElapsedMs(start_time) << " ms, " << catalog.files.size()
+            << " files" << std::endl;
+
+  for (const FundQuery& lookup : {query, recent}) {
+    start_time = std::chrono::high_resolution_clock::now();
+    SidecarLookupStats stats;
+    ARROW_ASSIGN_OR_RAISE(auto pruned, SidecarDataset(catalog, fs, base_dir, lookup, &stats));
+    ARROW_ASSIGN_OR_RAISE(int64_t rows, CountRows(pruned, lookup));
+    PrintLookup(lookup.has_date_range() ? "sidecar lookup, last 20 days" : "sidecar lookup",
+                ElapsedMs(start_time), rows, stats);
+  }
+
+  // 逐个点查 100 只基金，取平均延迟
+  const int num_lookups = std::min(100, num_funds);
+  int64_t total_rows = 0;
+  SidecarLookupStats total_stats;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < num_lookups; ++i) {
+    FundQuery lookup = query;
+    lookup.funds = {FundCode(1 + i * 197 % num_funds)};
+    ARROW_ASSIGN_OR_RAISE(auto pruned,
+                          SidecarDataset(catalog, fs, base_dir, lookup, &total_stats));
+    ARROW_ASSIGN_OR_RAISE(int64_t rows, CountRows(pruned, lookup));
+    total_rows += rows;
+  }
+  std::cout << num_lookups << " sidecar lookups: " << ElapsedMs(start_time) / num_lookups
+            << " ms each, " << total_rows / num_lookups << " rows and "
+            << total_stats.files_matched / num_lookups << " files each, "
+            << total_stats.row_groups_pruned_by_bloom * 100.0 / total_stats.row_groups
+            << "% of row groups pruned by bloom" << std::endl;
+  // (文档部分: 用索引)
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main(int argc, char** argv) {
+  const int num_custodians = argc > 1 ? std::stoi(argv[1]) : 200;
+  const int num_days = argc > 2 ? std::stoi(argv[2]) : 500;
+  arrow::Status st = RunMain(num_custodians, num_days);
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
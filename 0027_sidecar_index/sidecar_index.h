@@ -0,0 +1,414 @@
+// 基金代码点查用的旁路索引（sidecar）。
+// 按天写入的数据集里，一个文件包含很多只代码不相邻的基金，fund_code 列是字典编码的字符串，
+// row group 的 min/max 几乎覆盖整个代码范围，点查一只基金时统计信息什么也裁剪不掉，
+// 只能打开每个文件的 footer、解码每个 row group 的 fund_code 列。
+// 这里在每个数据文件旁边写一个小的 Arrow IPC 文件（part-0.parquet 对应 _part-0.parquet.sidecar），
+// 每个 row group 一行：行数、date 和 fund_code 的 min/max（zone map），
+// 以及 fund_code 的分块布隆过滤器（split block Bloom filter）。
+// 布隆过滤器的分块方式、盐值和哈希（XXH64，种子 0）都和 Parquet 规范一致，
+// 位数组可以直接交给 parquet::BlockSplitBloomFilter::Init。
+// 文件名以 _ 开头，FileSystemDatasetFactory、0024 的 manifest 和 0026 的压缩都会跳过它。
+// WriteDatasetWithSidecars 走 0004 的 FileSystemDataset::Write，写完后读回每个新文件的两列生成索引。
+// 查询前 LoadSidecars 把所有 sidecar 读进内存（列一次目录，不打开 Parquet 文件），
+// SidecarDataset 只用内存里的 zone map 和布隆过滤器挑出可能命中的 row group，
+// 扫描时只有这些文件的 footer 会被打开。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <arrow/util/base64.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/bloom_filter.h>
+#include <parquet/xxhasher.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../0023_dataset_pushdown/fund_query.h"
+#include "../dataset_write/dataset_write.h"
+
+constexpr char kSidecarSuffix[] = ".sidecar";
+
+struct SidecarOptions {
+  // 布隆过滤器的假阳性率，位数组的大小按 row group 里不同基金的个数确定
+  double false_positive_rate = 0.001;
+};
+
+struct SidecarRowGroup {
+  int64_t num_rows = 0;
+  // row group 里 fund_code 或 date 全是 null 时为 false，此时 zone map 没有意义
+  bool has_values = false;
+  int32_t min_date = 0;
+  int32_t max_date = 0;
+  std::string min_fund;
+  std::string max_fund;
+  // 布隆过滤器的位数组，长度是 32 字节（一个 block）的倍数
+  std::string bloom;
+};
+
+struct SidecarFile {
+  // 数据文件相对于数据集根目录的路径
+  std::string path;
+  // 由数据文件所在目录解析出的分区表达式
+  arrow::compute::Expression partition_expression = arrow::compute::literal(true);
+  std::vector<SidecarRowGroup> row_groups;
+};
+
+// 数据集所有 sidecar 在内存里的副本
+struct SidecarCatalog {
+  std::shared_ptr<arrow::Schema> file_schema;
+  std::shared_ptr<arrow::dataset::Partitioning> partitioning;
+  // 按路径排序
+  std::vector<SidecarFile> files;
+};
+
+struct SidecarLookupStats {
+  int64_t files = 0;
+  int64_t row_groups = 0;
+  int64_t row_groups_pruned_by_zone_map = 0;
+  int64_t row_groups_pruned_by_bloom = 0;
+  // 需要打开 footer 的文件和要读的 row group
+  int64_t files_matched = 0;
+  int64_t row_groups_matched = 0;
+};
+
+// 数据文件对应的 sidecar 路径
+inline std::string SidecarPath(const std::string& data_path) {
+  const size_t slash = data_path.rfind('/');
+  const size_t name = slash == std::string::npos ? 0 : slash + 1;
+  return data_path.substr(0, name) + "_" + data_path.substr(name) + kSidecarSuffix;
+}
+
+namespace sidecar_index_internal {
+
+constexpr size_t kBytesPerBlock = 32;
+
+// Parquet 规范里分块布隆过滤器的 8 个盐值
+constexpr uint32_t kSalt[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                               0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+inline uint64_t HashFund(std::string_view code) {
+  static const parquet::XxHasher hasher;
+  return hasher.Hash(code);
+}
+
+// 哈希的高 32 位选 block，低 32 位分别乘以 8 个盐值，在 block 的 8 个字里各置一位
+inline size_t BlockOffset(uint64_t hash, size_t num_bytes) {
+  const uint64_t num_blocks = num_bytes / kBytesPerBlock;
+  return static_cast<size_t>(((hash >> 32) * num_blocks) >> 32) * kBytesPerBlock;
+}
+
+inline void BlockMask(uint64_t hash, uint32_t mask[8]) {
+  const uint32_t key = static_cast<uint32_t>(hash);
+  for (int i = 0; i < 8; ++i) mask[i] = uint32_t{1} << ((key * kSalt[i]) >> 27);
+}
+
+inline void BloomInsert(std::string* bits, uint64_t hash) {
+  const size_t offset = BlockOffset(hash, bits->size());
+  uint32_t mask[8], block[8];
+  BlockMask(hash, mask);
+  std::memcpy(block, bits->data() + offset, kBytesPerBlock);
+  for (int i = 0; i < 8; ++i) block[i] |= mask[i];
+  std::memcpy(bits->data() + offset, block, kBytesPerBlock);
+}
+
+inline bool BloomFind(std::string_view bits, uint64_t hash) {
+  if (bits.empty()) return true;
+  const size_t offset = BlockOffset(hash, bits.size());
+  uint32_t mask[8], block[8];
+  BlockMask(hash, mask);
+  std::memcpy(block, bits.data() + offset, kBytesPerBlock);
+  for (int i = 0; i < 8; ++i) {
+    if ((block[i] & mask[i]) == 0) return false;
+  }
+  return true;
+}
+
+// 解码每个 row group 的 fund_code 和 date 两列，得到 zone map 和布隆过滤器
+inline arrow::Result<std::vector<SidecarRowGroup>> IndexRowGroups(
+    parquet::arrow::FileReader* reader, const arrow::Schema& schema,
+    const SidecarOptions& options) {
+  const int fund_index = schema.GetFieldIndex("fund_code");
+  const int date_index = schema.GetFieldIndex("date");
+  if (fund_index < 0 || date_index < 0) {
+    return arrow::Status::Invalid("sidecar needs fund_code and date columns");
+  }
+  std::vector<SidecarRowGroup> row_groups;
+  std::vector<uint64_t> hashes;
+  for (int rg = 0; rg < reader->num_row_groups(); ++rg) {
+    ARROW_ASSIGN_OR_RAISE(auto table, reader->ReadRowGroup(rg, {fund_index, date_index}));
+    SidecarRowGroup entry;
+    entry.num_rows = table->num_rows();
+    bool has_funds = false, has_dates = false;
+    hashes.clear();
+    for (const auto& chunk : table->column(0)->chunks()) {
+      const auto& codes = static_cast<const arrow::StringArray&>(*chunk);
+      for (int64_t i = 0; i < codes.length(); ++i) {
+        if (codes.IsNull(i)) continue;
+        const std::string_view code = codes.GetView(i);
+        hashes.push_back(HashFund(code));
+        if (!has_funds || code < entry.min_fund) entry.min_fund = std::string(code);
+        if (!has_funds || code > entry.max_fund) entry.max_fund = std::string(code);
+        has_funds = true;
+      }
+    }
+    for (const auto& chunk : table->column(1)->chunks()) {
+      const auto& dates = static_cast<const arrow::Date32Array&>(*chunk);
+      for (int64_t i = 0; i < dates.length(); ++i) {
+        if (dates.IsNull(i)) continue;
+        const int32_t date = dates.Value(i);
+        if (!has_dates || date < entry.min_date) entry.min_date = date;
+        if (!has_dates || date > entry.max_date) entry.max_date = date;
+        has_dates = true;
+      }
+    }
+    entry.has_values = has_funds && has_dates;
+
+    // 同一只基金在 row group 里出现多次，按不同哈希值的个数确定位数组大小
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+    const uint32_t num_bytes = parquet::BlockSplitBloomFilter::OptimalNumOfBytes(
+        std::max<uint64_t>(hashes.size(), 1), options.false_positive_rate);
+    entry.bloom.assign(num_bytes, '\0');
+    for (uint64_t hash : hashes) BloomInsert(&entry.bloom, hash);
+    row_groups.push_back(std::move(entry));
+  }
+  return row_groups;
+}
+
+inline std::shared_ptr<arrow::Schema> SidecarSchema(
+    const std::shared_ptr<arrow::KeyValueMetadata>& metadata) {
+  return arrow::schema({arrow::field("num_rows", arrow::int64()),
+                        arrow::field("min_date", arrow::date32()),
+                        arrow::field("max_date", arrow::date32()),
+                        arrow::field("min_fund", arrow::utf8()),
+                        arrow::field("max_fund", arrow::utf8()),
+                        arrow::field("bloom", arrow::binary())},
+                       metadata);
+}
+
+// 每个 row group 一行，数据文件的 schema 序列化后放在元数据里（同 0024 的 manifest）
+inline arrow::Status WriteSidecar(const std::shared_ptr<arrow::fs::FileSystem>& filesystem,
+                                  const std::string& path, const arrow::Schema& file_schema,
+                                  const std::vector<SidecarRowGroup>& row_groups) {
+  arrow::Int64Builder rows_builder;
+  arrow::Date32Builder min_date_builder, max_date_builder;
+  arrow::StringBuilder min_fund_builder, max_fund_builder;
+  arrow::BinaryBuilder bloom_builder;
+  for (const auto& row_group : row_groups) {
+    ARROW_RETURN_NOT_OK(rows_builder.Append(row_group.num_rows));
+    ARROW_RETURN_NOT_OK(bloom_builder.Append(row_group.bloom));
+    if (!row_group.has_values) {
+      ARROW_RETURN_NOT_OK(min_date_builder.AppendNull());
+      ARROW_RETURN_NOT_OK(max_date_builder.AppendNull());
+      ARROW_RETURN_NOT_OK(min_fund_builder.AppendNull());
+      ARROW_RETURN_NOT_OK(max_fund_builder.AppendNull());
+      continue;
+    }
+    ARROW_RETURN_NOT_OK(min_date_builder.Append(row_group.min_date));
+    ARROW_RETURN_NOT_OK(max_date_builder.Append(row_group.max_date));
+    ARROW_RETURN_NOT_OK(min_fund_builder.Append(row_group.min_fund));
+    ARROW_RETURN_NOT_OK(max_fund_builder.Append(row_group.max_fund));
+  }
+  ARROW_ASSIGN_OR_RAISE(auto serialized_schema, arrow::ipc::SerializeSchema(file_schema));
+  auto schema = SidecarSchema(arrow::key_value_metadata(
+      {"file_schema"}, {arrow::util::base64_encode(serialized_schema->ToString())}));
+  std::vector<std::shared_ptr<arrow::Array>> columns(schema->num_fields());
+  ARROW_RETURN_NOT_OK(rows_builder.Finish(&columns[0]));
+  ARROW_RETURN_NOT_OK(min_date_builder.Finish(&columns[1]));
+  ARROW_RETURN_NOT_OK(max_date_builder.Finish(&columns[2]));
+  ARROW_RETURN_NOT_OK(min_fund_builder.Finish(&columns[3]));
+  ARROW_RETURN_NOT_OK(max_fund_builder.Finish(&columns[4]));
+  ARROW_RETURN_NOT_OK(bloom_builder.Finish(&columns[5]));
+  auto batch = arrow::RecordBatch::Make(schema, columns[0]->length(), columns);
+
+  // 先写临时文件再改名，临时文件同样以 _ 开头
+  const std::string temp_path = path + ".tmp";
+  ARROW_ASSIGN_OR_RAISE(auto outfile, filesystem->OpenOutputStream(temp_path));
+  ARROW_ASSIGN_OR_RAISE(auto writer, arrow::ipc::MakeFileWriter(outfile, schema));
+  ARROW_RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+  ARROW_RETURN_NOT_OK(writer->Close());
+  ARROW_RETURN_NOT_OK(outfile->Close());
+  return filesystem->Move(temp_path, path);
+}
+
+inline arrow::Status ReadSidecar(const std::shared_ptr<arrow::fs::FileSystem>& filesystem,
+                                 const arrow::fs::FileInfo& info,
+                                 std::shared_ptr<arrow::Schema>* file_schema,
+                                 std::vector<SidecarRowGroup>* row_groups) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, filesystem->OpenInputFile(info));
+  ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(infile));
+  auto metadata = reader->schema()->metadata();
+  if (metadata == nullptr) return arrow::Status::Invalid(info.path(), " has no file schema");
+  ARROW_ASSIGN_OR_RAISE(auto encoded, metadata->Get("file_schema"));
+  // 同一个写入路径写出的文件 schema 相同，只解析第一个
+  if (*file_schema == nullptr) {
+    ARROW_ASSIGN_OR_RAISE(auto decoded, arrow::util::base64_decode(encoded));
+    arrow::io::BufferReader schema_reader(std::make_shared<arrow::Buffer>(decoded));
+    arrow::ipc::DictionaryMemo memo;
+    ARROW_ASSIGN_OR_RAISE(*file_schema, arrow::ipc::ReadSchema(&schema_reader, &memo));
+  }
+
+  for (int b = 0; b < reader->num_record_batches(); ++b) {
+    ARROW_ASSIGN_OR_RAISE(auto batch, reader->ReadRecordBatch(b));
+    const auto& rows = static_cast<const arrow::Int64Array&>(*batch->column(0));
+    const auto& min_dates = static_cast<const arrow::Date32Array&>(*batch->column(1));
+    const auto& max_dates = static_cast<const arrow::Date32Array&>(*batch->column(2));
+    const auto& min_funds = static_cast<const arrow::StringArray&>(*batch->column(3));
+    const auto& max_funds = static_cast<const arrow::StringArray&>(*batch->column(4));
+    const auto& blooms = static_cast<const arrow::BinaryArray&>(*batch->column(5));
+    for (int64_t i = 0; i < batch->num_rows(); ++i) {
+      SidecarRowGroup row_group;
+      row_group.num_rows = rows.Value(i);
+      row_group.has_values = min_dates.IsValid(i);
+      if (row_group.has_values) {
+        row_group.min_date = min_dates.Value(i);
+        row_group.max_date = max_dates.Value(i);
+        row_group.min_fund = min_funds.GetString(i);
+        row_group.max_fund = max_funds.GetString(i);
+      }
+      row_group.bloom = blooms.GetString(i);
+      row_groups->push_back(std::move(row_group));
+    }
+  }
+  return arrow::Status::OK();
+}
+
+}  // namespace sidecar_index_internal
+
+// 为一个已经写好的 Parquet 文件生成 sidecar
+inline arrow::Status BuildSidecar(const std::shared_ptr<arrow::fs::FileSystem>& filesystem,
+                                  const std::string& data_path,
+                                  const SidecarOptions& options = SidecarOptions()) {
+  ARROW_ASSIGN_OR_RAISE(auto infile, filesystem->OpenInputFile(data_path));
+  parquet::arrow::FileReaderBuilder builder;
+  ARROW_RETURN_NOT_OK(builder.Open(infile));
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  ARROW_RETURN_NOT_OK(builder.Build(&reader));
+  std::shared_ptr<arrow::Schema> schema;
+  ARROW_RETURN_NOT_OK(reader->GetSchema(&schema));
+  ARROW_ASSIGN_OR_RAISE(auto row_groups,
+                        sidecar_index_internal::IndexRowGroups(reader.get(), *schema, options));
+  return sidecar_index_internal::WriteSidecar(filesystem, SidecarPath(data_path), *schema,
+                                              row_groups);
+}
+
+// 代替 0004 的 FileSystemDataset::Write：写数据集，并为写出的每个文件生成 sidecar，
+// Write 返回后读回 fund_code 和 date 两列生成索引（IO 线程池里不能同步读，见 dataset_write.h）
+inline arrow::Status WriteDatasetWithSidecars(
+    const arrow::dataset::FileSystemDatasetWriteOptions& write_options,
+    const std::shared_ptr<arrow::dataset::Scanner>& scanner,
+    const SidecarOptions& options = SidecarOptions()) {
+  ARROW_ASSIGN_OR_RAISE(auto written, WriteDatasetCollectingPaths(write_options, scanner));
+  for (const auto& path : written) {
+    ARROW_RETURN_NOT_OK(BuildSidecar(write_options.filesystem, path, options));
+  }
+  return arrow::Status::OK();
+}
+
+// 列一次 base_dir，把所有 sidecar 读进内存。不打开任何 Parquet 文件，
+// 没有 sidecar 的数据文件不在结果里（可以先用 BuildSidecar 补上）
+inline arrow::Result<SidecarCatalog> LoadSidecars(
+    const std::shared_ptr<arrow::fs::FileSystem>& filesystem, const std::string& base_dir,
+    const std::shared_ptr<arrow::dataset::Partitioning>& partitioning) {
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  ARROW_ASSIGN_OR_RAISE(auto infos, filesystem->GetFileInfo(selector));
+  const std::string suffix = kSidecarSuffix;
+  SidecarCatalog catalog;
+  catalog.partitioning = partitioning;
+  for (const auto& info : infos) {
+    const std::string name = info.base_name();
+    if (!info.IsFile() || name.size() <= suffix.size() + 1 || name[0] != '_' ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+      continue;
+    }
+    if (info.path().compare(0, base_dir.size() + 1, base_dir + "/") != 0) {
+      return arrow::Status::Invalid(info.path(), " is not under ", base_dir);
+    }
+    const std::string relative_dir =
+        info.dir_name().size() > base_dir.size() ? info.dir_name().substr(base_dir.size() + 1)
+                                                 : "";
+    SidecarFile file;
+    file.path = (relative_dir.empty() ? "" : relative_dir + "/") +
+                name.substr(1, name.size() - 1 - suffix.size());
+    ARROW_ASSIGN_OR_RAISE(file.partition_expression, partitioning->Parse(relative_dir));
+    ARROW_RETURN_NOT_OK(sidecar_index_internal::ReadSidecar(
+        filesystem, info, &catalog.file_schema, &file.row_groups));
+    catalog.files.push_back(std::move(file));
+  }
+  std::sort(catalog.files.begin(), catalog.files.end(),
+            [](const SidecarFile& a, const SidecarFile& b) { return a.path < b.path; });
+  return catalog;
+}
+
+// 只用内存里的 sidecar 挑出可能命中 query 的 row group，构造只包含它们的数据集。
+// 先看日期和基金代码的 zone map，再查布隆过滤器；扫描时仍要用 query 过滤（布隆过滤器有假阳性）
+inline arrow::Result<std::shared_ptr<arrow::dataset::FileSystemDataset>> SidecarDataset(
+    const SidecarCatalog& catalog, const std::shared_ptr<arrow::fs::FileSystem>& filesystem,
+    const std::string& base_dir, const FundQuery& query, SidecarLookupStats* stats = nullptr) {
+  if (catalog.file_schema == nullptr) return arrow::Status::Invalid("no sidecars loaded");
+  arrow::FieldVector fields = catalog.file_schema->fields();
+  for (const auto& field : catalog.partitioning->schema()->fields()) fields.push_back(field);
+  auto schema = arrow::schema(fields);
+
+  std::vector<std::string> funds = query.funds;
+  std::sort(funds.begin(), funds.end());
+  std::vector<uint64_t> hashes;
+  for (const auto& code : funds) hashes.push_back(sidecar_index_internal::HashFund(code));
+
+  SidecarLookupStats local_stats;
+  if (stats == nullptr) stats = &local_stats;
+  auto format = std::make_shared<arrow::dataset::ParquetFileFormat>();
+  std::vector<std::shared_ptr<arrow::dataset::FileFragment>> fragments;
+  for (const auto& file : catalog.files) {
+    ++stats->files;
+    std::vector<int> row_groups;
+    for (int rg = 0; rg < static_cast<int>(file.row_groups.size()); ++rg) {
+      const auto& row_group = file.row_groups[rg];
+      ++stats->row_groups;
+      if (row_group.has_values) {
+        bool in_range = row_group.max_date >= query.min_date &&
+                        row_group.min_date <= query.max_date;
+        if (in_range && !funds.empty()) {
+          auto it = std::lower_bound(funds.begin(), funds.end(), row_group.min_fund);
+          in_range = it != funds.end() && *it <= row_group.max_fund;
+        }
+        if (!in_range) {
+          ++stats->row_groups_pruned_by_zone_map;
+          continue;
+        }
+      }
+      bool may_contain = hashes.empty();
+      for (uint64_t hash : hashes) {
+        may_contain = may_contain || sidecar_index_internal::BloomFind(row_group.bloom, hash);
+      }
+      if (!may_contain) {
+        ++stats->row_groups_pruned_by_bloom;
+        continue;
+      }
+      row_groups.push_back(rg);
+    }
+    if (row_groups.empty()) continue;
+    ++stats->files_matched;
+    stats->row_groups_matched += static_cast<int64_t>(row_groups.size());
+    ARROW_ASSIGN_OR_RAISE(
+        auto fragment,
+        format->MakeFragment(arrow::dataset::FileSource(base_dir + "/" + file.path, filesystem),
+                             file.partition_expression, catalog.file_schema,
+                             std::move(row_groups)));
+    fragments.push_back(std::move(fragment));
+  }
+  return arrow::dataset::FileSystemDataset::Make(schema, arrow::compute::literal(true), format,
+                                                 filesystem, std::move(fragments),
+                                                 catalog.partitioning);
+}
@@ -0,0 +1,222 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <map>
+
+#include "../0023_dataset_pushdown/fund_query.h"
+#include "../fund_panel/fund_panel.h"
+#include "partial_aggregates.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+std::shared_ptr<arrow::dataset::Partitioning> YearPartitioning() {
+  return std::make_shared<arrow::dataset::HivePartitioning>(
+      arrow::schema({arrow::field("year", arrow::int64())}));
+}
+
+// (文档部分: 每月写入)
+// 和 0004_datasets 一样用 FileSystemDataset::Write 写一个月的数据，按年份分区，
+// 同时为写出的文件生成按（基金, 月）聚合的文件
+arrow::Status WriteMonth(const std::shared_ptr<arrow::Table>& rows,
+                         const std::shared_ptr<arrow::fs::FileSystem>& fs,
+                         const std::string& base_dir, int month) {
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum years, arrow::compute::Year(rows->GetColumnByName("date")));
+  ARROW_ASSIGN_OR_RAISE(auto table, rows->AddColumn(rows->num_columns(),
+                                                    arrow::field("year", arrow::int64()),
+                                                    years.chunked_array()));
+  auto reader = std::make_shared<arrow::TableBatchReader>(table);
+  auto scanner_builder = arrow::dataset::ScannerBuilder::FromRecordBatchReader(reader);
+  ARROW_ASSIGN_OR_RAISE(auto scanner, scanner_builder->Finish());
+  auto format = std::make_shared<arrow::dataset::ParquetFileFormat>();
+  arrow::dataset::FileSystemDatasetWriteOptions write_options;
+  write_options.file_write_options = format->DefaultWriteOptions();
+  write_options.filesystem = fs;
+  write_options.base_dir = base_dir;
+  write_options.partitioning = YearPartitioning();
+  write_options.basename_template = "month-" + std::to_string(month) + "-{i}.parquet";
+  write_options.existing_data_behavior = arrow::dataset::ExistingDataBehavior::kOverwriteOrIgnore;
+  return WriteDatasetWithPartials(write_options, scanner);
+}
+// (文档部分: 每月写入)
+
+arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> Discover(
+    const std::shared_ptr<arrow::fs::FileSystem>& fs, const std::string& base_dir) {
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  arrow::dataset::FileSystemFactoryOptions factory_options;
+  factory_options.partitioning = YearPartitioning();
+  ARROW_ASSIGN_OR_RAISE(auto factory, arrow::dataset::FileSystemDatasetFactory::Make(
+                                          fs, selector,
+                                          std::make_shared<arrow::dataset::ParquetFileFormat>(),
+                                          factory_options));
+  return factory->Finish();
+}
+
+// (文档部分: 直接计算)
+// 对照：读出范围内的所有原始行，按基金逐日计算，回撤是精确值
+arrow::Result<std::map<std::string, RangeStats>> RawRangeStats(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset, const FundQuery& query,
+    const FundQueryLayout& layout) {
+  ARROW_ASSIGN_OR_RAISE(auto builder, dataset->NewScan());
+  ARROW_RETURN_NOT_OK(builder->Filter(query.ToExpression(layout)));
+  ARROW_RETURN_NOT_OK(builder->Project({"fund_code", "date", "adj_nav"}));
+  ARROW_ASSIGN_OR_RAISE(auto scanner, builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(auto rows, scanner->ToTable());
+  const arrow::compute::SortOptions sort_options(
+      {arrow::compute::SortKey("fund_code"), arrow::compute::SortKey("date")});
+  ARROW_ASSIGN_OR_RAISE(auto indices, arrow::compute::SortIndices(rows, sort_options));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum sorted, arrow::compute::Take(rows, indices));
+  ARROW_ASSIGN_OR_RAISE(auto table, sorted.table()->CombineChunks());
+  const auto& codes = static_cast<const arrow::StringArray&>(*table->column(0)->chunk(0));
+  const auto& navs = static_cast<const arrow::DoubleArray&>(*table->column(2)->chunk(0));
+
+  std::map<std::string, RangeStats> result;
+  std::vector<double> returns;
+  for (int64_t begin = 0; begin < table->num_rows();) {
+    int64_t end = begin;
+    while (end < table->num_rows() && codes.GetView(end) == codes.GetView(begin)) ++end;
+    returns.clear();
+    RangeStats stats;
+    double last = 0, peak = 0;
+    for (int64_t i = begin; i < end; ++i) {
+      if (navs.IsNull(i)) continue;
+      const double nav = navs.Value(i);
+      if (last > 0) returns.push_back(nav / last - 1);
+      last = nav;
+      peak = std::max(peak, nav);
+      stats.max_drawdown_low = std::max(stats.max_drawdown_low, 1 - nav / peak);
+    }
+    stats.max_drawdown_high = stats.max_drawdown_low;
+    stats.count = static_cast<int64_t>(returns.size());
+    double sum = 0, compounded = 1;
+    for (double r : returns) {
+      sum += r;
+      compounded *= 1 + r;
+    }
+    stats.total_return = compounded - 1;
+    stats.mean = sum / stats.count;
+    double m2 = 0;
+    for (double r : returns) m2 += (r - stats.mean) * (r - stats.mean);
+    stats.volatility = std::sqrt(m2 / (stats.count - 1) * 252.0);
+    stats.sharpe = stats.mean * 252.0 / stats.volatility;
+    result[codes.GetString(begin)] = stats;
+    begin = end;
+  }
+  return result;
+}
+// (文档部分: 直接计算)
+
+void PrintStats(const std::string& name, double ms, const RangeStats& stats) {
+  std::cout << name << ": " << ms << " ms, " << stats.count << " returns, total return "
+            << stats.total_return << ", volatility " << stats.volatility << ", sharpe "
+            << stats.sharpe << ", max drawdown [" << stats.max_drawdown_low << ", "
+            << stats.max_drawdown_high << "]" << std::endl;
+}
+
+arrow::Status RunMain() {
+  // (文档部分: 生成数据集)
+  // 2000 只基金、1500 个交易日，每个月写一次
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 2000;
+  panel_options.num_days = 1500;
+  panel_options.date_major = true;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  const int num_funds = panel_options.num_funds;
+
+  const std::string root = std::filesystem::current_path().string();
+  ARROW_ASSIGN_OR_RAISE(auto fs, arrow::fs::FileSystemFromUriOrPath(root));
+  const std::string base_dir = root + "/monthly_dataset";
+  std::filesystem::remove_all(base_dir);
+  auto start_time = std::chrono::high_resolution_clock::now();
+  int written_months = 0;
+  for (int day = 0; day < panel_options.num_days;) {
+    const int64_t month =
+        partial_aggregates_internal::MonthOf(TradingDay(panel_options.start_date, day));
+    int end = day;
+    while (end < panel_options.num_days &&
+           partial_aggregates_internal::MonthOf(TradingDay(panel_options.start_date, end)) ==
+               month) {
+      ++end;
+    }
+    ARROW_RETURN_NOT_OK(WriteMonth(panel->Slice(int64_t{day} * num_funds,
+                                                int64_t{end - day} * num_funds),
+                                   fs, base_dir, written_months++));
+    day = end;
+  }
+  std::cout << "monthly writes with partials: " << written_months << " months in "
+            << ElapsedMs(start_time) << " ms" << std::endl;
+  ARROW_ASSIGN_OR_RAISE(auto data, Discover(fs, base_dir));
+  ARROW_ASSIGN_OR_RAISE(auto partials, Discover(fs, base_dir + "/" + kPartialsDir));
+  const FundQueryLayout layout{0, true};
+  // (文档部分: 生成数据集)
+
+  // (文档部分: 对比)
+  // 日期范围的首尾都不在月初月末，首尾两个月读原始行
+  FundQuery query;
+  query.min_date = TradingDay(panel_options.start_date, 37);
+  query.max_date = TradingDay(panel_options.start_date, 1410);
+  FundQuery one_fund = query;
+  one_fund.funds = {FundCode(42)};
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto raw_one, RawRangeStats(data, one_fund, layout));
+  PrintStats("one fund, raw rows", ElapsedMs(start_time), raw_one[FundCode(42)]);
+  start_time = std::chrono::high_resolution_clock::now();
+  RangeQueryStats query_stats;
+  ARROW_ASSIGN_OR_RAISE(auto merged_one, QueryRangeStats(data, partials, one_fund, layout,
+                                                         PartialOptions(), &query_stats));
+  PrintStats("one fund, partials", ElapsedMs(start_time), merged_one[FundCode(42)]);
+  std::cout << "  " << query_stats.full_months << " full months from " << query_stats.partial_rows
+            << " partial rows, " << query_stats.edge_rows << " raw rows at the edges" << std::endl;
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto raw_all, RawRangeStats(data, query, layout));
+  const double raw_ms = ElapsedMs(start_time);
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto merged_all, QueryRangeStats(data, partials, query, layout,
+                                                         PartialOptions(), &query_stats));
+  const double merged_ms = ElapsedMs(start_time);
+  std::cout << "all " << merged_all.size() << " funds: raw rows " << raw_ms << " ms, partials "
+            << merged_ms << " ms (" << query_stats.partial_rows << " partial rows, "
+            << query_stats.edge_rows << " raw rows)" << std::endl;
+  // (文档部分: 对比)
+
+  // 两种算法的结果只差浮点误差，精确回撤落在上下界之间
+  double max_diff = 0;
+  int outside = 0;
+  for (const auto& [fund, raw] : raw_all) {
+    const RangeStats& merged = merged_all[fund];
+    max_diff = std::max({max_diff, std::abs(raw.sharpe - merged.sharpe),
+                         std::abs(raw.volatility - merged.volatility),
+                         std::abs(raw.total_return - merged.total_return)});
+    const double tolerance = 1e-12;
+    outside += raw.max_drawdown_low < merged.max_drawdown_low - tolerance ||
+               raw.max_drawdown_low > merged.max_drawdown_high + tolerance;
+  }
+  std::cout << "max difference in sharpe / volatility / total return: " << max_diff
+            << ", exact drawdowns outside the bounds: " << outside << std::endl;
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
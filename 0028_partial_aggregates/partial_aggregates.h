@@ -0,0 +1,430 @@
+// 按（基金, 月）预先聚合的收益率统计，用来即时回答任意日期范围的夏普比率、波动率和近似最大回撤。
+// 目录结构：
+//   base_dir/year=2015/month-0-0.parquet             数据文件（0004 的 FileSystemDataset::Write）
+//   base_dir/_partials/year=2015/month-0-0.parquet   同一个文件按（基金, 月）聚合后的结果
+// _partials 以 _ 开头，发现数据文件时会被跳过；它自己也能按同样的分区方式作为数据集打开。
+// 每个（基金, 月）一行：月内第一个和最后一个有效净值及其日期，月内相邻有效净值之间的
+// 收益率个数、和、平方和、复合收益率，以及净值的最小值和最大值。
+// 按日期先后相邻的两段可以合并：衔接处的收益率由前一段最后的净值和后一段第一个净值算出，
+// 其余各项相加、相乘或取 min/max。
+// 查询 [min_date, max_date] 时，整月落在范围内的月份只读聚合结果，只有首尾不完整的月份读原始行，
+// 按日期顺序合并后和直接用范围内的原始行计算的结果相同（只差浮点加法的顺序）。
+// 缺失的净值跳过，收益率相对于上一个有效净值，同 0006 的 cal_sharpe_ratio.cpp。
+// 月内最高点和最低点的先后顺序不知道，最大回撤只能给出上下界。
+// 用 std::filesystem 建目录、按本地路径读写，只支持本地文件系统。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../0014_parquet_nav_writer/nav_writer_properties.h"
+#include "../0015_parquet_pruned_reader/nav_reader.h"
+#include "../0023_dataset_pushdown/fund_query.h"
+#include "../dataset_write/dataset_write.h"
+
+constexpr char kPartialsDir[] = "_partials";
+
+struct PartialOptions {
+  // 计算收益率用的净值列
+  std::string nav_column = "adj_nav";
+  double periods_per_year = 252.0;
+};
+
+// 一只基金在一段连续日期内的部分聚合结果，通常是一个月
+struct NavPartial {
+  std::string fund_code;
+  // 月份序号 year * 12 + (month - 1)
+  int32_t month = 0;
+  int32_t first_date = 0;
+  int32_t last_date = 0;
+  double first_nav = 0;
+  double last_nav = 0;
+  // 收益率的个数（有效净值个数 - 1）、和、平方和
+  int64_t count = 0;
+  double sum = 0;
+  double sum_squares = 0;
+  // 复合收益率 prod(1 + r) - 1
+  double compounded = 0;
+  double min_nav = 0;
+  double max_nav = 0;
+};
+
+struct RangeStats {
+  // 收益率的个数
+  int64_t count = 0;
+  double total_return = 0;
+  double mean = 0;
+  // 年化波动率和年化夏普比率（无风险利率取 0，样本标准差 ddof = 1）
+  double volatility = 0;
+  double sharpe = 0;
+  // 最大回撤的下界和上界
+  double max_drawdown_low = 0;
+  double max_drawdown_high = 0;
+};
+
+struct RangeQueryStats {
+  // 整月用聚合结果回答的月份数，读到的聚合结果行数
+  int64_t full_months = 0;
+  int64_t partial_rows = 0;
+  // 首尾不完整月份读的原始行数
+  int64_t edge_rows = 0;
+};
+
+namespace partial_aggregates_internal {
+
+// date32（1970-01-01 起的天数）所在的月份序号，和 0023 的 YearOf 用同样的公历换算
+inline int64_t MonthOf(int64_t days) {
+  const int64_t z = days + 719468;
+  const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const int64_t doe = z - era * 146097;
+  const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const int64_t mp = (5 * doy + 2) / 153;
+  const int64_t month = mp < 10 ? mp + 3 : mp - 9;
+  return (yoe + era * 400 + (month <= 2 ? 1 : 0)) * 12 + month - 1;
+}
+
+// 月份第一天的 date32
+inline int64_t MonthStart(int64_t month_index) {
+  const int64_t y0 = (month_index >= 0 ? month_index : month_index - 11) / 12;
+  const int64_t month = month_index - y0 * 12 + 1;
+  const int64_t y = month <= 2 ? y0 - 1 : y0;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const int64_t yoe = y - era * 400;
+  const int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5;
+  const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+inline void AddReturn(NavPartial* partial, double r) {
+  ++partial->count;
+  partial->sum += r;
+  partial->sum_squares += r * r;
+  partial->compounded = (1 + partial->compounded) * (1 + r) - 1;
+}
+
+// 把日期在 *into 之后的 next 接到 *into 后面
+inline void Append(NavPartial* into, const NavPartial& next) {
+  AddReturn(into, next.first_nav / into->last_nav - 1);
+  into->count += next.count;
+  into->sum += next.sum;
+  into->sum_squares += next.sum_squares;
+  into->compounded = (1 + into->compounded) * (1 + next.compounded) - 1;
+  into->last_date = next.last_date;
+  into->last_nav = next.last_nav;
+  into->min_nav = std::min(into->min_nav, next.min_nav);
+  into->max_nav = std::max(into->max_nav, next.max_nav);
+}
+
+inline arrow::Result<std::shared_ptr<arrow::Array>> Column(const arrow::Table& table,
+                                                           const std::string& name,
+                                                           arrow::Type::type type) {
+  auto column = table.GetColumnByName(name);
+  if (column == nullptr) return arrow::Status::KeyError("no column '", name, "'");
+  if (column->type()->id() != type) {
+    return arrow::Status::TypeError("column '", name, "' is ", column->type()->ToString());
+  }
+  if (column->num_chunks() == 1) return column->chunk(0);
+  return arrow::Concatenate(column->chunks());
+}
+
+}  // namespace partial_aggregates_internal
+
+// 把原始行（fund_code、date 和净值列，顺序任意）按（基金, 月）聚合，结果按基金和月份排序
+inline arrow::Result<std::vector<NavPartial>> ComputePartials(
+    const std::shared_ptr<arrow::Table>& rows, const PartialOptions& options = PartialOptions()) {
+  namespace internal = partial_aggregates_internal;
+  const arrow::compute::SortOptions sort_options(
+      {arrow::compute::SortKey("fund_code"), arrow::compute::SortKey("date")});
+  ARROW_ASSIGN_OR_RAISE(auto indices, arrow::compute::SortIndices(rows, sort_options));
+  const arrow::Table& table = *rows;
+  ARROW_ASSIGN_OR_RAISE(auto code_array,
+                        internal::Column(table, "fund_code", arrow::Type::STRING));
+  ARROW_ASSIGN_OR_RAISE(auto date_array, internal::Column(table, "date", arrow::Type::DATE32));
+  ARROW_ASSIGN_OR_RAISE(auto nav_array,
+                        internal::Column(table, options.nav_column, arrow::Type::DOUBLE));
+  const auto& codes = static_cast<const arrow::StringArray&>(*code_array);
+  const auto& dates = static_cast<const arrow::Date32Array&>(*date_array);
+  const auto& navs = static_cast<const arrow::DoubleArray&>(*nav_array);
+  const auto& order = static_cast<const arrow::UInt64Array&>(*indices);
+
+  std::vector<NavPartial> partials;
+  for (int64_t k = 0; k < order.length(); ++k) {
+    const int64_t i = static_cast<int64_t>(order.Value(k));
+    if (codes.IsNull(i) || dates.IsNull(i) || navs.IsNull(i)) continue;
+    const int32_t date = dates.Value(i);
+    const double nav = navs.Value(i);
+    const int32_t month = static_cast<int32_t>(internal::MonthOf(date));
+    NavPartial* last = partials.empty() ? nullptr : &partials.back();
+    if (last != nullptr && last->month == month && last->fund_code == codes.GetView(i)) {
+      internal::AddReturn(last, nav / last->last_nav - 1);
+      last->last_date = date;
+      last->last_nav = nav;
+      last->min_nav = std::min(last->min_nav, nav);
+      last->max_nav = std::max(last->max_nav, nav);
+      continue;
+    }
+    NavPartial partial;
+    partial.fund_code = codes.GetString(i);
+    partial.month = month;
+    partial.first_date = partial.last_date = date;
+    partial.first_nav = partial.last_nav = partial.min_nav = partial.max_nav = nav;
+    partials.push_back(std::move(partial));
+  }
+  return partials;
+}
+
+inline arrow::Result<std::shared_ptr<arrow::Table>> PartialsToTable(
+    const std::vector<NavPartial>& partials) {
+  arrow::StringBuilder code_builder;
+  arrow::Int32Builder month_builder;
+  arrow::Date32Builder first_date_builder, last_date_builder;
+  arrow::Int64Builder count_builder;
+  arrow::DoubleBuilder first_nav_builder, last_nav_builder, sum_builder, sum_squares_builder,
+      compounded_builder, min_nav_builder, max_nav_builder;
+  for (const auto& partial : partials) {
+    ARROW_RETURN_NOT_OK(code_builder.Append(partial.fund_code));
+    ARROW_RETURN_NOT_OK(month_builder.Append(partial.month));
+    ARROW_RETURN_NOT_OK(first_date_builder.Append(partial.first_date));
+    ARROW_RETURN_NOT_OK(last_date_builder.Append(partial.last_date));
+    ARROW_RETURN_NOT_OK(first_nav_builder.Append(partial.first_nav));
+    ARROW_RETURN_NOT_OK(last_nav_builder.Append(partial.last_nav));
+    ARROW_RETURN_NOT_OK(count_builder.Append(partial.count));
+    ARROW_RETURN_NOT_OK(sum_builder.Append(partial.sum));
+    ARROW_RETURN_NOT_OK(sum_squares_builder.Append(partial.sum_squares));
+    ARROW_RETURN_NOT_OK(compounded_builder.Append(partial.compounded));
+    ARROW_RETURN_NOT_OK(min_nav_builder.Append(partial.min_nav));
+    ARROW_RETURN_NOT_OK(max_nav_builder.Append(partial.max_nav));
+  }
+  auto schema = arrow::schema({arrow::field("fund_code", arrow::utf8()),
+                               arrow::field("month", arrow::int32()),
+                               arrow::field("first_date", arrow::date32()),
+                               arrow::field("last_date", arrow::date32()),
+                               arrow::field("first_nav", arrow::float64()),
+                               arrow::field("last_nav", arrow::float64()),
+                               arrow::field("count", arrow::int64()),
+                               arrow::field("sum", arrow::float64()),
+                               arrow::field("sum_squares", arrow::float64()),
+                               arrow::field("compounded", arrow::float64()),
+                               arrow::field("min_nav", arrow::float64()),
+                               arrow::field("max_nav", arrow::float64())});
+  std::vector<std::shared_ptr<arrow::Array>> columns(schema->num_fields());
+  ARROW_RETURN_NOT_OK(code_builder.Finish(&columns[0]));
+  ARROW_RETURN_NOT_OK(month_builder.Finish(&columns[1]));
+  ARROW_RETURN_NOT_OK(first_date_builder.Finish(&columns[2]));
+  ARROW_RETURN_NOT_OK(last_date_builder.Finish(&columns[3]));
+  ARROW_RETURN_NOT_OK(first_nav_builder.Finish(&columns[4]));
+  ARROW_RETURN_NOT_OK(last_nav_builder.Finish(&columns[5]));
+  ARROW_RETURN_NOT_OK(count_builder.Finish(&columns[6]));
+  ARROW_RETURN_NOT_OK(sum_builder.Finish(&columns[7]));
+  ARROW_RETURN_NOT_OK(sum_squares_builder.Finish(&columns[8]));
+  ARROW_RETURN_NOT_OK(compounded_builder.Finish(&columns[9]));
+  ARROW_RETURN_NOT_OK(min_nav_builder.Finish(&columns[10]));
+  ARROW_RETURN_NOT_OK(max_nav_builder.Finish(&columns[11]));
+  return arrow::Table::Make(schema, columns);
+}
+
+// PartialsToTable 的逆过程，表可以来自多个文件，行的顺序任意
+inline arrow::Result<std::vector<NavPartial>> PartialsFromTable(const arrow::Table& table) {
+  namespace internal = partial_aggregates_internal;
+  using arrow::Type;
+  ARROW_ASSIGN_OR_RAISE(auto codes, internal::Column(table, "fund_code", Type::STRING));
+  ARROW_ASSIGN_OR_RAISE(auto months, internal::Column(table, "month", Type::INT32));
+  ARROW_ASSIGN_OR_RAISE(auto first_dates, internal::Column(table, "first_date", Type::DATE32));
+  ARROW_ASSIGN_OR_RAISE(auto last_dates, internal::Column(table, "last_date", Type::DATE32));
+  ARROW_ASSIGN_OR_RAISE(auto first_navs, internal::Column(table, "first_nav", Type::DOUBLE));
+  ARROW_ASSIGN_OR_RAISE(auto last_navs, internal::Column(table, "last_nav", Type::DOUBLE));
+  ARROW_ASSIGN_OR_RAISE(auto counts, internal::Column(table, "count", Type::INT64));
+  ARROW_ASSIGN_OR_RAISE(auto sums, internal::Column(table, "sum", Type::DOUBLE));
+  ARROW_ASSIGN_OR_RAISE(auto sum_squares, internal::Column(table, "sum_squares", Type::DOUBLE));
+  ARROW_ASSIGN_OR_RAISE(auto compounded, internal::Column(table, "compounded", Type::DOUBLE));
+  ARROW_ASSIGN_OR_RAISE(auto min_navs, internal::Column(table, "min_nav", Type::DOUBLE));
+  ARROW_ASSIGN_OR_RAISE(auto max_navs, internal::Column(table, "max_nav", Type::DOUBLE));
+  auto value = [](const std::shared_ptr<arrow::Array>& array, int64_t i) {
+    return static_cast<const arrow::DoubleArray&>(*array).Value(i);
+  };
+  auto date = [](const std::shared_ptr<arrow::Array>& array, int64_t i) {
+    return static_cast<const arrow::Date32Array&>(*array).Value(i);
+  };
+  std::vector<NavPartial> partials(table.num_rows());
+  for (int64_t i = 0; i < table.num_rows(); ++i) {
+    NavPartial& partial = partials[i];
+    partial.fund_code = static_cast<const arrow::StringArray&>(*codes).GetString(i);
+    partial.month = static_cast<const arrow::Int32Array&>(*months).Value(i);
+    partial.first_date = date(first_dates, i);
+    partial.last_date = date(last_dates, i);
+    partial.first_nav = value(first_navs, i);
+    partial.last_nav = value(last_navs, i);
+    partial.count = static_cast<const arrow::Int64Array&>(*counts).Value(i);
+    partial.sum = value(sums, i);
+    partial.sum_squares = value(sum_squares, i);
+    partial.compounded = value(compounded, i);
+    partial.min_nav = value(min_navs, i);
+    partial.max_nav = value(max_navs, i);
+  }
+  return partials;
+}
+
+// 一只基金按日期排好序、互不重叠的若干段合并成范围内的统计量
+inline arrow::Result<RangeStats> MergePartials(const std::vector<NavPartial>& pieces,
+                                               double periods_per_year = 252.0) {
+  RangeStats stats;
+  if (pieces.empty()) return stats;
+  NavPartial merged = pieces[0];
+  double peak = 0;
+  for (size_t p = 0; p < pieces.size(); ++p) {
+    const NavPartial& piece = pieces[p];
+    if (p > 0) {
+      if (piece.first_date <= merged.last_date) {
+        return arrow::Status::Invalid("overlapping partials for ", piece.fund_code, " at date ",
+                                      piece.first_date);
+      }
+      partial_aggregates_internal::Append(&merged, piece);
+    }
+    // 段内第一个净值一定在最低点之前、最后一个净值一定在最高点之后，由此得到回撤的下界；
+    // 假设最高点在最低点之前，得到上界
+    const double peak_before_min = std::max(peak, piece.first_nav);
+    const double peak_with_max = std::max(peak, piece.max_nav);
+    stats.max_drawdown_low = std::max({stats.max_drawdown_low, 1 - piece.min_nav / peak_before_min,
+                                       1 - piece.last_nav / peak_with_max});
+    stats.max_drawdown_high = std::max(stats.max_drawdown_high, 1 - piece.min_nav / peak_with_max);
+    peak = peak_with_max;
+  }
+  stats.count = merged.count;
+  stats.total_return = merged.compounded;
+  if (merged.count == 0) return stats;
+  const double n = static_cast<double>(merged.count);
+  stats.mean = merged.sum / n;
+  if (merged.count > 1) {
+    const double variance = std::max(0.0, (merged.sum_squares - merged.sum * stats.mean) / (n - 1));
+    stats.volatility = std::sqrt(variance * periods_per_year);
+    stats.sharpe = stats.volatility > 0 ? stats.mean * periods_per_year / stats.volatility : 0;
+  }
+  return stats;
+}
+
+// 数据文件对应的聚合文件：base_dir/_partials/<相对路径>
+inline std::string PartialsPath(const std::string& base_dir, const std::string& data_path) {
+  return base_dir + "/" + kPartialsDir + data_path.substr(base_dir.size());
+}
+
+// 读一个已经写好的数据文件，写出它的聚合文件
+inline arrow::Status WritePartialsFor(const std::string& base_dir, const std::string& data_path,
+                                      const PartialOptions& options = PartialOptions()) {
+  NavReadOptions read_options;
+  read_options.columns = {"fund_code", "date", options.nav_column};
+  ARROW_ASSIGN_OR_RAISE(auto rows, ReadNavParquet(data_path, read_options));
+  ARROW_ASSIGN_OR_RAISE(auto partials, ComputePartials(rows, options));
+  ARROW_ASSIGN_OR_RAISE(auto table, PartialsToTable(partials));
+  const std::string path = PartialsPath(base_dir, data_path);
+  std::error_code error;
+  std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+  if (error) return arrow::Status::IOError("cannot create ", path, ": ", error.message());
+  return WriteNavParquet(*table, path);
+}
+
+// 代替 0004 的 FileSystemDataset::Write：写数据集，并为写出的每个文件生成聚合文件。
+// 和 0027 的 WriteDatasetWithSidecars 一样，Write 返回后再读回新文件（IO 线程池里不能同步读）
+inline arrow::Status WriteDatasetWithPartials(
+    const arrow::dataset::FileSystemDatasetWriteOptions& write_options,
+    const std::shared_ptr<arrow::dataset::Scanner>& scanner,
+    const PartialOptions& options = PartialOptions()) {
+  ARROW_ASSIGN_OR_RAISE(auto written, WriteDatasetCollectingPaths(write_options, scanner));
+  for (const auto& path : written) {
+    ARROW_RETURN_NOT_OK(WritePartialsFor(write_options.base_dir, path, options));
+  }
+  return arrow::Status::OK();
+}
+
+// 查询 query.funds（空表示全部）在 [query.min_date, query.max_date] 内的统计量。
+// data 是原始数据集，partials 是 base_dir/_partials 按同样分区方式打开的数据集
+inline arrow::Result<std::map<std::string, RangeStats>> QueryRangeStats(
+    const std::shared_ptr<arrow::dataset::Dataset>& data,
+    const std::shared_ptr<arrow::dataset::Dataset>& partials, const FundQuery& query,
+    const FundQueryLayout& layout = FundQueryLayout(),
+    const PartialOptions& options = PartialOptions(), RangeQueryStats* stats = nullptr) {
+  namespace cp = arrow::compute;
+  namespace internal = partial_aggregates_internal;
+  RangeQueryStats local_stats;
+  if (stats == nullptr) stats = &local_stats;
+  *stats = RangeQueryStats();
+
+  // 完整落在范围内的月份 [first_month, last_month]
+  const int64_t min_month = internal::MonthOf(query.min_date);
+  const int64_t max_month = internal::MonthOf(query.max_date);
+  const int64_t first_month = min_month + (internal::MonthStart(min_month) < query.min_date);
+  const int64_t last_month = max_month - (internal::MonthStart(max_month + 1) - 1 > query.max_date);
+
+  std::map<std::string, std::vector<NavPartial>> pieces;
+  auto read_rows = [&](int64_t min_date, int64_t max_date) -> arrow::Status {
+    if (min_date > max_date) return arrow::Status::OK();
+    FundQuery edge = query;
+    edge.min_date = static_cast<int32_t>(min_date);
+    edge.max_date = static_cast<int32_t>(max_date);
+    ARROW_ASSIGN_OR_RAISE(auto builder, data->NewScan());
+    ARROW_RETURN_NOT_OK(builder->Filter(edge.ToExpression(layout)));
+    ARROW_RETURN_NOT_OK(builder->Project({"fund_code", "date", options.nav_column}));
+    ARROW_ASSIGN_OR_RAISE(auto scanner, builder->Finish());
+    ARROW_ASSIGN_OR_RAISE(auto rows, scanner->ToTable());
+    stats->edge_rows += rows->num_rows();
+    ARROW_ASSIGN_OR_RAISE(auto edge_partials, ComputePartials(rows, options));
+    for (auto& partial : edge_partials) pieces[partial.fund_code].push_back(std::move(partial));
+    return arrow::Status::OK();
+  };
+
+  if (first_month > last_month) {
+    ARROW_RETURN_NOT_OK(read_rows(query.min_date, query.max_date));
+  } else {
+    ARROW_RETURN_NOT_OK(read_rows(query.min_date, internal::MonthStart(first_month) - 1));
+    ARROW_RETURN_NOT_OK(read_rows(internal::MonthStart(last_month + 1), query.max_date));
+    stats->full_months = last_month - first_month + 1;
+
+    FundQuery funds_only;
+    funds_only.funds = query.funds;
+    std::vector<cp::Expression> conditions = {funds_only.ToExpression()};
+    const bool bounded_below = query.min_date != std::numeric_limits<int32_t>::min();
+    const bool bounded_above = query.max_date != std::numeric_limits<int32_t>::max();
+    if (bounded_below) {
+      conditions.push_back(cp::greater_equal(cp::field_ref("month"),
+                                             cp::literal(static_cast<int32_t>(first_month))));
+      if (layout.year_partitioned) {
+        conditions.push_back(
+            cp::greater_equal(cp::field_ref("year"), cp::literal(first_month / 12)));
+      }
+    }
+    if (bounded_above) {
+      conditions.push_back(cp::less_equal(cp::field_ref("month"),
+                                          cp::literal(static_cast<int32_t>(last_month))));
+      if (layout.year_partitioned) {
+        conditions.push_back(cp::less_equal(cp::field_ref("year"), cp::literal(last_month / 12)));
+      }
+    }
+    ARROW_ASSIGN_OR_RAISE(auto builder, partials->NewScan());
+    ARROW_RETURN_NOT_OK(builder->Filter(cp::and_(conditions)));
+    ARROW_ASSIGN_OR_RAISE(auto scanner, builder->Finish());
+    ARROW_ASSIGN_OR_RAISE(auto table, scanner->ToTable());
+    stats->partial_rows = table->num_rows();
+    ARROW_ASSIGN_OR_RAISE(auto month_partials, PartialsFromTable(*table));
+    for (auto& partial : month_partials) pieces[partial.fund_code].push_back(std::move(partial));
+  }
+
+  std::map<std::string, RangeStats> result;
+  for (auto& [fund, fund_pieces] : pieces) {
+    std::sort(fund_pieces.begin(), fund_pieces.end(),
+              [](const NavPartial& a, const NavPartial& b) { return a.first_date < b.first_date; });
+    ARROW_ASSIGN_OR_RAISE(result[fund], MergePartials(fund_pieces, options.periods_per_year));
+  }
+  return result;
+}
@@ -0,0 +1,204 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "../0022_bucketed_layout/bucketed_layout.h"
+#include "../fund_panel/fund_panel.h"
+#include "streaming_writer.h"
+// (文档部分: 包含)
+
+// 用法：my_example [最大核数] [总行数]，默认是硬件线程数和 800 万行
+
+std::shared_ptr<arrow::dataset::Partitioning> BucketPartitioning() {
+  return std::make_shared<arrow::dataset::HivePartitioning>(
+      arrow::schema({arrow::field("bucket", arrow::int32())}));
+}
+
+// (文档部分: 行情推送)
+// 模拟一个不断推送净值的数据源：每个 batch 是某一天一部分基金的净值，按需生成，
+// 不会把全部数据放在内存里。基金代码按哈希分到 num_buckets 个桶，每个 batch 都包含所有桶的行
+class NavFeedReader : public arrow::RecordBatchReader {
+ public:
+  NavFeedReader(int num_funds, int num_buckets, int64_t batch_rows, int64_t total_rows)
+      : num_funds_(num_funds), batch_rows_(batch_rows), remaining_rows_(total_rows),
+        adj_nav_(num_funds, 1.0), rng_(42), daily_return_(0.0003, 0.01) {
+    schema_ = FundPanelSchema();
+    schema_ = *schema_->AddField(schema_->num_fields(), arrow::field("bucket", arrow::int32()));
+    for (int f = 0; f < num_funds; ++f) {
+      codes_.push_back(FundCode(f + 1));
+      buckets_.push_back(FundBucket(codes_.back(), num_buckets));
+    }
+  }
+
+  std::shared_ptr<arrow::Schema> schema() const override { return schema_; }
+
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* out) override {
+    const int64_t rows = std::min(batch_rows_, remaining_rows_);
+    if (rows == 0) {
+      *out = nullptr;
+      return arrow::Status::OK();
+    }
+    arrow::StringBuilder code_builder;
+    arrow::Date32Builder date_builder;
+    arrow::DoubleBuilder nav_builder, cum_nav_builder, adj_nav_builder;
+    arrow::Int32Builder bucket_builder;
+    ARROW_RETURN_NOT_OK(code_builder.Reserve(rows));
+    ARROW_RETURN_NOT_OK(code_builder.ReserveData(rows * 7));
+    ARROW_RETURN_NOT_OK(date_builder.Reserve(rows));
+    ARROW_RETURN_NOT_OK(nav_builder.Reserve(rows));
+    ARROW_RETURN_NOT_OK(cum_nav_builder.Reserve(rows));
+    ARROW_RETURN_NOT_OK(adj_nav_builder.Reserve(rows));
+    ARROW_RETURN_NOT_OK(bucket_builder.Reserve(rows));
+    for (int64_t i = 0; i < rows; ++i) {
+      if (next_fund_ == num_funds_) {
+        next_fund_ = 0;
+        date_ = TradingDay(date_ + 1, 0);
+      }
+      const int f = next_fund_++;
+      adj_nav_[f] *= 1.0 + daily_return_(rng_);
+      const double nav = std::round(adj_nav_[f] * 10000.0) / 10000.0;
+      code_builder.UnsafeAppend(codes_[f]);
+      date_builder.UnsafeAppend(date_);
+      nav_builder.UnsafeAppend(nav);
+      cum_nav_builder.UnsafeAppend(nav);
+      adj_nav_builder.UnsafeAppend(nav);
+      bucket_builder.UnsafeAppend(buckets_[f]);
+    }
+    remaining_rows_ -= rows;
+    std::vector<std::shared_ptr<arrow::Array>> columns(6);
+    ARROW_RETURN_NOT_OK(code_builder.Finish(&columns[0]));
+    ARROW_RETURN_NOT_OK(date_builder.Finish(&columns[1]));
+    ARROW_RETURN_NOT_OK(nav_builder.Finish(&columns[2]));
+    ARROW_RETURN_NOT_OK(cum_nav_builder.Finish(&columns[3]));
+    ARROW_RETURN_NOT_OK(adj_nav_builder.Finish(&columns[4]));
+    ARROW_RETURN_NOT_OK(bucket_builder.Finish(&columns[5]));
+    *out = arrow::RecordBatch::Make(schema_, rows, std::move(columns));
+    return arrow::Status::OK();
+  }
+
+ private:
+  const int num_funds_;
+  const int64_t batch_rows_;
+  int64_t remaining_rows_;
+  std::shared_ptr<arrow::Schema> schema_;
+  std::vector<std::string> codes_;
+  std::vector<int32_t> buckets_;
+  std::vector<double> adj_nav_;
+  std::mt19937_64 rng_;
+  std::normal_distribution<double> daily_return_;
+  int next_fund_ = 0;
+  int32_t date_ = TradingDay(16440, 0);
+};
+// (文档部分: 行情推送)
+
+constexpr int kNumFunds = 50000;
+constexpr int kNumBuckets = 512;
+
+arrow::Result<StreamingWriteStats> WriteFeed(const StreamingWriteOptions& options,
+                                             int64_t total_rows) {
+  std::filesystem::remove_all(options.base_dir);
+  auto feed = std::make_shared<NavFeedReader>(kNumFunds, kNumBuckets, 16 * 1024, total_rows);
+  return WriteStream(feed, options);
+}
+
+void PrintWrite(const std::string& name, const StreamingWriteStats& stats) {
+  std::cout << name << ": " << stats.rows << " rows in " << stats.seconds * 1000 << " ms, "
+            << stats.mb_per_second() << " MB/s, " << stats.files << " files, row groups of "
+            << stats.rows_per_group << " rows, peak memory " << stats.peak_memory / (1 << 20)
+            << " MB, peak queue " << stats.peak_queued_bytes / (1 << 20) << " MB, "
+            << stats.producer_waits << " producer waits, " << stats.memory_waits
+            << " memory waits" << std::endl;
+}
+
+arrow::Status RunMain(int max_cores, int64_t total_rows) {
+  const std::string root = std::filesystem::current_path().string();
+  ARROW_ASSIGN_OR_RAISE(auto fs, arrow::fs::FileSystemFromUriOrPath(root));
+  StreamingWriteOptions base;
+  base.filesystem = fs;
+  base.base_dir = root + "/streamed_dataset";
+  base.partitioning = BucketPartitioning();
+
+  // (文档部分: 默认参数)
+  // 0004_datasets 的写入参数：FileSystemDataset::Write 和 ParquetFileFormat 的默认值，
+  // 最多 900 个打开的文件，row group 最多 100 万行，不设最小行数。每个输入 batch 按桶拆开后
+  // 直接交给各自文件的 Parquet 写入器，每次只写几十行，吞吐很低
+  StreamingWriteOptions defaults = base;
+  defaults.max_open_files = 900;
+  defaults.max_rows_per_file = 0;
+  defaults.max_rows_per_group = 1 << 20;
+  defaults.min_rows_per_group = 0;
+  defaults.nav_writer_properties = false;
+  defaults.max_queued_bytes = int64_t{1} << 40;
+  defaults.memory_budget = int64_t{1} << 40;
+  ARROW_ASSIGN_OR_RAISE(auto default_stats, WriteFeed(defaults, total_rows));
+  PrintWrite("0004 defaults", default_stats);
+  // (文档部分: 默认参数)
+
+  // (文档部分: 内存预算)
+  // 每个桶一个打开的文件，row group 的行数按 256 MB 的预算推算
+  StreamingWriteOptions budgeted = base;
+  budgeted.max_open_files = kNumBuckets;
+  budgeted.max_queued_bytes = 16 << 20;
+  budgeted.memory_budget = 256 << 20;
+  ARROW_ASSIGN_OR_RAISE(auto budgeted_stats, WriteFeed(budgeted, total_rows));
+  PrintWrite("256 MB budget", budgeted_stats);
+
+  // 打开的文件数少于分区数：每个 batch 都包含所有桶，写入器不停地关文件、开新文件，
+  // 内存更少，但得到大量小文件和很小的 row group，吞吐也低得多，这里只写 1/16 的行
+  StreamingWriteOptions few_files = budgeted;
+  few_files.max_open_files = 64;
+  ARROW_ASSIGN_OR_RAISE(auto few_files_stats, WriteFeed(few_files, total_rows / 16));
+  PrintWrite("64 open files", few_files_stats);
+  // (文档部分: 内存预算)
+
+  // (文档部分: 吞吐和核数)
+  // CPU 和 IO 线程池从 1 个线程加到 max_cores，其他参数和 256 MB 预算一样
+  std::cout << "cores  MB/s  peak MB" << std::endl;
+  std::vector<int> cores;
+  for (int n = 1; n < max_cores; n *= 2) cores.push_back(n);
+  cores.push_back(max_cores);
+  std::vector<StreamingWriteStats> results;
+  for (int n : cores) {
+    StreamingWriteOptions options = budgeted;
+    options.cpu_threads = n;
+    options.io_threads = n;
+    ARROW_ASSIGN_OR_RAISE(auto stats, WriteFeed(options, total_rows));
+    results.push_back(stats);
+  }
+  double peak = 0;
+  for (const auto& stats : results) peak = std::max(peak, stats.mb_per_second());
+  for (size_t i = 0; i < cores.size(); ++i) {
+    std::printf("%5d  %4.0f  %7lld  %s\n", cores[i], results[i].mb_per_second(),
+                static_cast<long long>(results[i].peak_memory >> 20),
+                std::string(static_cast<int>(50 * results[i].mb_per_second() / peak), '#')
+                    .c_str());
+  }
+  // (文档部分: 吞吐和核数)
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main(int argc, char** argv) {
+  const int max_cores =
+      argc > 1 ? std::stoi(argv[1])
+               : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  const int64_t total_rows = argc > 2 ? std::stoll(argv[2]) : 8000000;
+  arrow::Status st = RunMain(max_cores, total_rows);
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
@@ -0,0 +1,370 @@
+// 把一个没有尽头的 RecordBatchReader（例如行情推送）写成分区数据集。
+// 0004 里 FileSystemDataset::Write 的输入是内存表上的 TableBatchReader，写入参数都用默认值：
+// 最多同时打开 900 个文件、每个 row group 最多 100 万行。写入器把每个输入 batch 按分区拆开，
+// 每个打开的文件攒着一个没写完的 row group，分区很多时内存随打开的文件数和 row group 增长。
+// WriteStream 在它前面加了一层：
+//   - 读线程从上游读 batch 放进按字节计的有界队列，队列满时读线程停下来（反压），
+//     上游只会被读到写入跟得上的位置；
+//   - 写入器从队列取 batch 前检查默认内存池，超过 memory_budget 时等 IO 线程写出一部分；
+//   - max_open_files、max_rows_per_file 直接交给数据集写入器，打开的文件数到上限时
+//     写入器关掉最早打开的文件，之后写到同一分区的行进入新文件；
+//   - max_rows_per_group 为 0 时按内存预算推算：预算减去队列后平均分给每个打开的文件，
+//     再减去每个 Parquet 写入器固定占用的内存，剩下的是攒着的行。数据集写入器和 Parquet 的
+//     row group 设成同样的行数，每行按输入大小的三倍计：按分区拆开的小 batch 各自有缓冲区
+//     和对齐填充，约两倍；Parquet 写入器在下一次写入时才关闭上一个 row group，约一倍。
+// FileSystemDataset::Write 自己只在还没写出的行超过 8M 行时才暂停读输入
+// （kDefaultDatasetWriterMaxRowsQueued，公开接口不能修改），IO 跟不上时这些行都在内存里，
+// 所以要在它读输入的地方按内存反压。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+#include <arrow/io/api.h>
+#include <arrow/util/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../0014_parquet_nav_writer/nav_writer_properties.h"
+#include "../0020_coalescing_writer/coalescing_writer.h"
+
+struct StreamingWriteOptions {
+  std::shared_ptr<arrow::fs::FileSystem> filesystem;
+  std::string base_dir;
+  std::shared_ptr<arrow::dataset::Partitioning> partitioning;
+  std::string basename_template = "part-{i}.parquet";
+  // 同时打开的文件数上限
+  uint32_t max_open_files = 64;
+  // 一个文件最多的行数，0 表示不限
+  uint64_t max_rows_per_file = 4 << 20;
+  // 每个 row group 的行数，0 表示按 memory_budget 推算。都不超过 max_rows_per_file
+  uint64_t max_rows_per_group = 0;
+  // 攒够多少行才写出一个 row group。-1 表示攒够整个 row group；
+  // 0 是 FileSystemDataset::Write 的默认值，按分区拆开的行直接交给 Parquet 写入器
+  int64_t min_rows_per_group = -1;
+  // 分区数上限，高基数分区要调大
+  int max_partitions = 1 << 16;
+  // 读线程和写入器之间的队列上限（字节）
+  int64_t max_queued_bytes = 32 << 20;
+  // 队列 + 所有打开文件 + 写入器里还没写出的行的总预算（字节），
+  // 和默认内存池的已分配字节数比较，所以要算上进程里其他用默认内存池的内存
+  int64_t memory_budget = 256 << 20;
+  // 超过预算后等待写入器释放内存，这么长时间内存没有下降就不再等
+  std::chrono::milliseconds memory_stall_timeout{20};
+  // 每个打开的 Parquet 写入器固定占用的内存（各列的编码缓冲区等），
+  // 和列数、page 大小有关，默认值是 my_example 在 fund_panel 的列上实测的
+  int64_t file_overhead_bytes = 128 << 10;
+  // 写入期间 CPU / IO 线程池的大小，WriteStream 返回时恢复原来的大小。0 表示不修改
+  int cpu_threads = 0;
+  int io_threads = 0;
+  // false 时用 ParquetFileFormat 默认的写入配置（0004 的做法），不用 parquet_options
+  bool nav_writer_properties = true;
+  NavParquetOptions parquet_options;
+};
+
+struct StreamingWriteStats {
+  int64_t rows = 0;
+  int64_t batches = 0;
+  // 输入 batch 引用的数据量
+  int64_t bytes = 0;
+  int64_t files = 0;
+  uint64_t rows_per_group = 0;
+  // 队列满、读线程等待的次数，以及队列里最多时的字节数
+  int64_t producer_waits = 0;
+  // 超过内存预算、写入器暂停读取的次数
+  int64_t memory_waits = 0;
+  int64_t peak_queued_bytes = 0;
+  // 每次入队和出队时采样的默认内存池已分配字节数的最大值
+  int64_t peak_memory = 0;
+  double seconds = 0;
+
+  double mb_per_second() const { return seconds > 0 ? bytes / seconds / 1e6 : 0; }
+};
+
+namespace streaming_writer_internal {
+
+// 按字节计的有界队列，一个读线程入队，数据集写入器出队
+class BatchQueue {
+ public:
+  explicit BatchQueue(int64_t max_bytes) : max_bytes_(max_bytes) {}
+
+  // 队列满时等待；消费端已经关闭时返回 false
+  bool Push(std::shared_ptr<arrow::RecordBatch> batch, int64_t bytes,
+            StreamingWriteStats* stats) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // 队列为空时总是放得下，单个 batch 超过上限也不会卡住
+    if (!closed_ && !batches_.empty() && queued_bytes_ + bytes > max_bytes_) {
+      ++stats->producer_waits;
+      changed_.wait(lock, [&] {
+        return closed_ || batches_.empty() || queued_bytes_ + bytes <= max_bytes_;
+      });
+    }
+    if (closed_) return false;
+    batches_.emplace_back(std::move(batch), bytes);
+    queued_bytes_ += bytes;
+    stats->peak_queued_bytes = std::max(stats->peak_queued_bytes, queued_bytes_);
+    changed_.notify_all();
+    return true;
+  }
+
+  // 上游读完或出错
+  void Finish(arrow::Status status) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    status_ = std::move(status);
+    changed_.notify_all();
+  }
+
+  // 消费端不再读取，让等待中的读线程退出
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    changed_.notify_all();
+  }
+
+  // 读完时返回 nullptr
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> Pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [&] { return finished_ || !batches_.empty(); });
+    if (batches_.empty()) {
+      ARROW_RETURN_NOT_OK(status_);
+      return nullptr;
+    }
+    auto [batch, bytes] = std::move(batches_.front());
+    batches_.pop_front();
+    queued_bytes_ -= bytes;
+    changed_.notify_all();
+    return batch;
+  }
+
+ private:
+  const int64_t max_bytes_;
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::deque<std::pair<std::shared_ptr<arrow::RecordBatch>, int64_t>> batches_;
+  int64_t queued_bytes_ = 0;
+  bool finished_ = false;
+  bool closed_ = false;
+  arrow::Status status_;
+};
+
+// 数据集写入器看到的输入：从队列里取 batch。
+// 写入器把读到的 batch 交给 IO 线程池写文件，写得比读得慢时 batch 在写入器里越积越多
+// （最多 8M 行）。默认内存池超过预算时先不读，等写入器写出一部分。
+// 攒着的行要等更多输入才能凑成 row group 写出，预算之外也可能有别的内存，
+// 所以内存池超过 stall_timeout 没有下降时不再等待，避免卡住
+class QueueReader : public arrow::RecordBatchReader {
+ public:
+  QueueReader(std::shared_ptr<arrow::Schema> schema, BatchQueue* queue, int64_t memory_budget,
+              std::chrono::milliseconds stall_timeout, std::atomic<int64_t>* peak_memory,
+              std::atomic<int64_t>* memory_waits)
+      : schema_(std::move(schema)), queue_(queue), memory_budget_(memory_budget),
+        stall_timeout_(stall_timeout), peak_memory_(peak_memory), memory_waits_(memory_waits) {}
+
+  std::shared_ptr<arrow::Schema> schema() const override { return schema_; }
+
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* batch) override {
+    WaitForMemory();
+    ARROW_ASSIGN_OR_RAISE(*batch, queue_->Pop());
+    SampleMemory(peak_memory_);
+    return arrow::Status::OK();
+  }
+
+  static void SampleMemory(std::atomic<int64_t>* peak) {
+    const int64_t allocated = arrow::default_memory_pool()->bytes_allocated();
+    int64_t previous = peak->load();
+    while (allocated > previous && !peak->compare_exchange_weak(previous, allocated)) {
+    }
+  }
+
+ private:
+  void WaitForMemory() {
+    arrow::MemoryPool* pool = arrow::default_memory_pool();
+    int64_t lowest = pool->bytes_allocated();
+    if (lowest <= memory_budget_) return;
+    ++*memory_waits_;
+    auto last_progress = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - last_progress < stall_timeout_) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      const int64_t allocated = pool->bytes_allocated();
+      if (allocated <= memory_budget_) return;
+      if (allocated < lowest) {
+        lowest = allocated;
+        last_progress = std::chrono::steady_clock::now();
+      }
+    }
+  }
+
+  std::shared_ptr<arrow::Schema> schema_;
+  BatchQueue* queue_;
+  const int64_t memory_budget_;
+  const std::chrono::milliseconds stall_timeout_;
+  std::atomic<int64_t>* peak_memory_;
+  std::atomic<int64_t>* memory_waits_;
+};
+
+// 修改全局的 CPU / IO 线程池大小，析构时改回原来的大小，出错返回的路径也会恢复
+class ScopedThreadPoolCapacity {
+ public:
+  ScopedThreadPoolCapacity() = default;
+  ScopedThreadPoolCapacity(const ScopedThreadPoolCapacity&) = delete;
+  ScopedThreadPoolCapacity& operator=(const ScopedThreadPoolCapacity&) = delete;
+
+  ~ScopedThreadPoolCapacity() {
+    if (previous_cpu_threads_ > 0) {
+      ARROW_UNUSED(arrow::SetCpuThreadPoolCapacity(previous_cpu_threads_));
+    }
+    if (previous_io_threads_ > 0) {
+      ARROW_UNUSED(arrow::io::SetIOThreadPoolCapacity(previous_io_threads_));
+    }
+  }
+
+  // 0 表示不修改
+  arrow::Status Set(int cpu_threads, int io_threads) {
+    if (cpu_threads > 0) {
+      const int previous = arrow::GetCpuThreadPoolCapacity();
+      ARROW_RETURN_NOT_OK(arrow::SetCpuThreadPoolCapacity(cpu_threads));
+      previous_cpu_threads_ = previous;
+    }
+    if (io_threads > 0) {
+      const int previous = arrow::io::GetIOThreadPoolCapacity();
+      ARROW_RETURN_NOT_OK(arrow::io::SetIOThreadPoolCapacity(io_threads));
+      previous_io_threads_ = previous;
+    }
+    return arrow::Status::OK();
+  }
+
+ private:
+  int previous_cpu_threads_ = 0;
+  int previous_io_threads_ = 0;
+};
+
+}  // namespace streaming_writer_internal
+
+// 按内存预算推算 row group 的行数，结果在 [1024, 1 << 20] 之间
+inline uint64_t RowsPerGroupForBudget(const StreamingWriteOptions& options,
+                                      int64_t bytes_per_row) {
+  const int64_t for_files = std::max<int64_t>(options.memory_budget - options.max_queued_bytes, 0);
+  const int64_t per_file = for_files / std::max<int64_t>(options.max_open_files, 1) -
+                           options.file_overhead_bytes;
+  const int64_t rows = per_file / std::max<int64_t>(3 * bytes_per_row, 1);
+  return static_cast<uint64_t>(std::clamp<int64_t>(rows, 1024, 1 << 20));
+}
+
+// 把 reader 中的所有 batch 写成 options.base_dir 下的分区数据集，直到 reader 读完
+inline arrow::Result<StreamingWriteStats> WriteStream(
+    const std::shared_ptr<arrow::RecordBatchReader>& reader,
+    const StreamingWriteOptions& options) {
+  namespace internal = streaming_writer_internal;
+  internal::ScopedThreadPoolCapacity thread_pools;
+  ARROW_RETURN_NOT_OK(thread_pools.Set(options.cpu_threads, options.io_threads));
+  auto start_time = std::chrono::steady_clock::now();
+  StreamingWriteStats stats;
+  std::atomic<int64_t> peak_memory{0};
+  std::atomic<int64_t> memory_waits{0};
+
+  // 先读第一个 batch 估计每行的字节数，用来推算 row group 的行数
+  std::shared_ptr<arrow::RecordBatch> first;
+  ARROW_RETURN_NOT_OK(reader->ReadNext(&first));
+  int64_t first_bytes = 0;
+  if (first != nullptr) {
+    ARROW_ASSIGN_OR_RAISE(first_bytes, EstimateBatchBytes(*first));
+  }
+  stats.rows_per_group = options.max_rows_per_group;
+  if (stats.rows_per_group == 0) {
+    const int64_t bytes_per_row =
+        first == nullptr || first->num_rows() == 0 ? 64 : first_bytes / first->num_rows();
+    stats.rows_per_group = RowsPerGroupForBudget(options, bytes_per_row);
+  }
+  // FileSystemDataset::Write 要求 max_rows_per_group <= max_rows_per_file，
+  // min_rows_per_group <= max_rows_per_group
+  if (options.max_rows_per_file > 0) {
+    stats.rows_per_group = std::min(stats.rows_per_group, options.max_rows_per_file);
+  }
+  const uint64_t min_rows_per_group =
+      options.min_rows_per_group < 0
+          ? stats.rows_per_group
+          : std::min(static_cast<uint64_t>(options.min_rows_per_group), stats.rows_per_group);
+
+  internal::BatchQueue queue(options.max_queued_bytes);
+  std::thread producer([&, first, first_bytes]() mutable {
+    arrow::Status status;
+    std::shared_ptr<arrow::RecordBatch> batch = std::move(first);
+    int64_t bytes = first_bytes;
+    while (batch != nullptr) {
+      ++stats.batches;
+      stats.rows += batch->num_rows();
+      stats.bytes += bytes;
+      if (!queue.Push(std::move(batch), bytes, &stats)) break;
+      internal::QueueReader::SampleMemory(&peak_memory);
+      status = reader->ReadNext(&batch);
+      if (!status.ok()) break;
+      if (batch != nullptr) {
+        auto estimated = EstimateBatchBytes(*batch);
+        if (!estimated.ok()) {
+          status = estimated.status();
+          break;
+        }
+        bytes = *estimated;
+      }
+    }
+    queue.Finish(std::move(status));
+  });
+
+  auto format = std::make_shared<arrow::dataset::ParquetFileFormat>();
+  auto file_options = std::static_pointer_cast<arrow::dataset::ParquetFileWriteOptions>(
+      format->DefaultWriteOptions());
+  if (options.nav_writer_properties) {
+    NavParquetOptions parquet_options = options.parquet_options;
+    parquet_options.row_group_rows = static_cast<int64_t>(stats.rows_per_group);
+    file_options->writer_properties = NavWriterProperties(*reader->schema(), parquet_options);
+    file_options->arrow_writer_properties = NavArrowWriterProperties();
+  }
+
+  std::atomic<int64_t> files{0};
+  arrow::dataset::FileSystemDatasetWriteOptions write_options;
+  write_options.file_write_options = file_options;
+  write_options.filesystem = options.filesystem;
+  write_options.base_dir = options.base_dir;
+  write_options.partitioning = options.partitioning;
+  write_options.basename_template = options.basename_template;
+  write_options.max_partitions = options.max_partitions;
+  write_options.max_open_files = options.max_open_files;
+  write_options.max_rows_per_file = options.max_rows_per_file;
+  write_options.max_rows_per_group = stats.rows_per_group;
+  // 默认攒够整个 row group 再写；max_open_files 或 max_rows_per_file 关文件时会写出更小的 row group
+  write_options.min_rows_per_group = min_rows_per_group;
+  write_options.existing_data_behavior = arrow::dataset::ExistingDataBehavior::kOverwriteOrIgnore;
+  write_options.writer_post_finish = [&files](arrow::dataset::FileWriter*) {
+    ++files;
+    return arrow::Status::OK();
+  };
+
+  auto queue_reader = std::make_shared<internal::QueueReader>(
+      reader->schema(), &queue, options.memory_budget, options.memory_stall_timeout,
+      &peak_memory, &memory_waits);
+  auto scanner_builder = arrow::dataset::ScannerBuilder::FromRecordBatchReader(queue_reader);
+  auto scanner = scanner_builder->Finish();
+  arrow::Status status = scanner.ok()
+                             ? arrow::dataset::FileSystemDataset::Write(write_options, *scanner)
+                             : scanner.status();
+  // 写入失败时读线程可能还在等队列，先关掉队列再等它退出
+  queue.Close();
+  producer.join();
+  ARROW_RETURN_NOT_OK(status);
+
+  stats.files = files.load();
+  stats.peak_memory = peak_memory.load();
+  stats.memory_waits = memory_waits.load();
+  stats.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  return stats;
+}
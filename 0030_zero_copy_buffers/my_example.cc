@@ -0,0 +1,163 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../fund_panel/fund_panel.h"
+#include "zero_copy_buffers.h"
+// (文档部分: 包含)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+void PrintStats(const std::string& name, const ZeroCopyStats& stats) {
+  std::cout << name << ": wrapped " << stats.wrapped_buffers << " buffers ("
+            << stats.wrapped_bytes << " bytes), copied " << stats.copied_buffers << " buffers ("
+            << stats.copied_bytes << " bytes)" << std::endl;
+}
+
+arrow::Status RunMain() {
+  // (文档部分: 收益率)
+  // 和 0006_cal_sharpe_ratio/cal_sharpe_ratio.cpp 一样用 std::vector<double> 算出日收益率，
+  // 拿走 vector 变成 float64 数组，再用 Arrow 的计算函数算夏普比率
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 1;
+  panel_options.num_days = 2000;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  ARROW_ASSIGN_OR_RAISE(auto cum_navs,
+                        arrow::Concatenate(panel->GetColumnByName("cum_nav")->chunks()));
+  const auto& navs = static_cast<const arrow::DoubleArray&>(*cum_navs);
+  std::vector<double> returns;
+  double previous_nav = 0.0;
+  for (int64_t i = 0; i < navs.length(); ++i) {
+    const double nav = navs.Value(i);
+    if (previous_nav > 0.0) returns.push_back((nav - previous_nav) / previous_nav);
+    previous_nav = nav;
+  }
+  const double* returns_data = returns.data();
+  ZeroCopyStats stats;
+  ARROW_ASSIGN_OR_RAISE(auto return_array,
+                        ArrayFromVector(std::move(returns), nullptr, ZeroCopyOptions(), &stats));
+  // 数组的值就是原来 vector 的内存
+  std::cout << "returns array shares the vector's memory: " << std::boolalpha
+            << (static_cast<const arrow::DoubleArray&>(*return_array).raw_values() ==
+                returns_data)
+            << std::endl;
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum mean, arrow::compute::Mean(return_array));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum stddev,
+                        arrow::compute::Stddev(return_array, arrow::compute::VarianceOptions(1)));
+  const double sharpe = mean.scalar_as<arrow::DoubleScalar>().value * std::sqrt(252.0) /
+                        stddev.scalar_as<arrow::DoubleScalar>().value;
+  std::cout << "the result of sharpe ratio : " << sharpe << std::endl;
+  // (文档部分: 收益率)
+
+  // (文档部分: 复制和零复制)
+  // 2000 万个 double：0001_how_to_build 的做法是经过 Builder 的 AppendValues 复制一遍，
+  // ArrayFromVector 只分配一个 Buffer 对象
+  const int64_t num_values = 20000000;
+  std::vector<double> values(num_values);
+  for (int64_t i = 0; i < num_values; ++i) values[i] = i * 0.5;
+  arrow::MemoryPool* pool = arrow::default_memory_pool();
+
+  int64_t allocated_before = pool->bytes_allocated();
+  auto start_time = std::chrono::high_resolution_clock::now();
+  arrow::DoubleBuilder builder;
+  ARROW_RETURN_NOT_OK(builder.AppendValues(values));
+  ARROW_ASSIGN_OR_RAISE(auto copied, builder.Finish());
+  std::cout << "DoubleBuilder::AppendValues: " << ElapsedMs(start_time) << " ms, "
+            << (pool->bytes_allocated() - allocated_before) / (1 << 20)
+            << " MB allocated from the pool" << std::endl;
+
+  allocated_before = pool->bytes_allocated();
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto wrapped, ArrayFromVector(std::move(values)));
+  std::cout << "ArrayFromVector: " << ElapsedMs(start_time) << " ms, "
+            << (pool->bytes_allocated() - allocated_before) / (1 << 20)
+            << " MB allocated from the pool" << std::endl;
+  std::cout << "same values: " << copied->Equals(*wrapped) << std::endl;
+  copied.reset();
+  // (文档部分: 复制和零复制)
+
+  // (文档部分: 原始缓冲区)
+  // 其他库分配的内存：owner 是释放这段内存的 shared_ptr，数组持有它。
+  // 前一半从 64 字节对齐的地址开始；后一半错开 1 个字节，不满足 double 的对齐，会复制到内存池
+  const int64_t raw_length = 1000;
+  const int64_t raw_bytes = raw_length * 8;
+  std::shared_ptr<arrow::Array> aligned_array, misaligned_array;
+  ZeroCopyStats raw_stats;
+  {
+    std::shared_ptr<uint8_t> raw(
+        static_cast<uint8_t*>(std::aligned_alloc(64, 2 * raw_bytes + 64)), std::free);
+    uint8_t* misaligned = raw.get() + raw_bytes + 1;
+    for (int64_t i = 0; i < raw_length; ++i) {
+      const double value = i;
+      std::memcpy(raw.get() + i * 8, &value, 8);
+      std::memcpy(misaligned + i * 8, &value, 8);
+    }
+    ZeroCopyOptions simd_options;
+    simd_options.alignment = 64;
+    ARROW_ASSIGN_OR_RAISE(aligned_array,
+                          ArrayFromRaw(reinterpret_cast<const double*>(raw.get()), raw_length,
+                                       raw, nullptr, simd_options, &raw_stats));
+    ARROW_ASSIGN_OR_RAISE(misaligned_array,
+                          ArrayFromRaw(reinterpret_cast<const double*>(misaligned),
+                                       raw_length, raw, nullptr, ZeroCopyOptions(), &raw_stats));
+    // raw 在这里离开作用域，内存由 aligned_array 持有的 owner 保持有效
+  }
+  ARROW_RETURN_NOT_OK(aligned_array->ValidateFull());
+  ARROW_RETURN_NOT_OK(misaligned_array->ValidateFull());
+  PrintStats("raw buffers", raw_stats);
+  ARROW_ASSIGN_OR_RAISE(auto last, aligned_array->GetScalar(raw_length - 1));
+  std::cout << "aligned array after the owner left scope: " << aligned_array->length()
+            << " values, last " << last->ToString() << ", equal to the copied array: "
+            << aligned_array->Equals(*misaligned_array) << std::endl;
+  // (文档部分: 原始缓冲区)
+
+  // (文档部分: RecordBatch)
+  // 数值列零复制，字符串列还是用 Builder 构建；int32_t 天数作为 date32 列
+  ZeroCopyBatchBuilder batch_builder;
+  std::vector<int32_t> dates;
+  std::vector<double> nav_values;
+  arrow::StringBuilder code_builder;
+  for (int day = 0; day < 5; ++day) {
+    ARROW_RETURN_NOT_OK(code_builder.Append(FundCode(1)));
+    dates.push_back(TradingDay(panel_options.start_date, day));
+    nav_values.push_back(navs.Value(day));
+  }
+  ARROW_ASSIGN_OR_RAISE(auto codes, code_builder.Finish());
+  ARROW_RETURN_NOT_OK(batch_builder.AddArray("fund_code", codes));
+  ARROW_RETURN_NOT_OK(batch_builder.AddVector("date", std::move(dates), arrow::date32()));
+  ARROW_RETURN_NOT_OK(batch_builder.AddVector("cum_nav", std::move(nav_values)));
+  // 宽度不一致的类型会报错
+  std::vector<int32_t> wrong_width = {1, 2, 3, 4, 5};
+  std::cout << "int32_t as timestamp: "
+            << batch_builder.AddVector("bad", std::move(wrong_width),
+                                       arrow::timestamp(arrow::TimeUnit::SECOND))
+            << std::endl;
+  PrintStats("batch columns", batch_builder.stats());
+  ARROW_ASSIGN_OR_RAISE(auto batch, batch_builder.Finish());
+  ARROW_RETURN_NOT_OK(batch->ValidateFull());
+  std::cout << batch->ToString() << std::endl;
+  // (文档部分: RecordBatch)
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
@@ -0,0 +1,238 @@
+// 不复制数据，把已有的 C++ 内存（std::vector、其他库分配的原始缓冲区）包装成 Arrow 数组。
+// 0001_how_to_build 用 Int8Builder::AppendValues 从 C 数组构建数组，每个值复制一次；
+// 0006_cal_sharpe_ratio/cal_sharpe_ratio.cpp 里算出来的 std::vector<double> returns
+// 要交给 Arrow 计算或写文件时，也要先经过 Builder 复制一遍。
+//   - VectorBuffer<T> 是一个 arrow::Buffer 子类，拿走 std::vector<T> 的所有权，
+//     数组、batch、切片都引用这个 Buffer，最后一个引用释放时 vector 才释放；
+//   - WrapRawBuffer 包装原始指针：owner 非空时 Buffer 持有 owner 保证内存不会提前释放，
+//     owner 为空时和 arrow::Buffer::Wrap 一样只是借用，调用方负责内存比数组活得久；
+//   - 地址不满足对齐要求时复制到内存池（64 字节对齐），其他情况都不复制。
+//     默认只要求值类型本身的对齐（arrow::util::kValueAlignment），
+//     要交给按 64 字节对齐优化的代码时可以把 alignment 设成 64。
+// 只支持定长的数值类型（整数、浮点、date32、timestamp 等），不支持 null：
+// 字符串和有效位图的内存布局和 C++ 的容器不一样，做不到零复制。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/util/align_util.h>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct ZeroCopyOptions {
+  // 数据地址需要满足的对齐（字节），kValueAlignment 表示按值类型的大小对齐
+  int64_t alignment = arrow::util::kValueAlignment;
+  // 地址不满足对齐要求时复制用的内存池
+  arrow::MemoryPool* pool = arrow::default_memory_pool();
+};
+
+struct ZeroCopyStats {
+  int64_t wrapped_buffers = 0;
+  int64_t wrapped_bytes = 0;
+  // 因为对齐不满足而复制的缓冲区
+  int64_t copied_buffers = 0;
+  int64_t copied_bytes = 0;
+};
+
+// 拥有一个 std::vector<T> 的 Buffer，数据就是 vector 的内存
+template <typename T>
+class VectorBuffer : public arrow::Buffer {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>, "VectorBuffer needs a trivially copyable type");
+
+  explicit VectorBuffer(std::vector<T> values)
+      : arrow::Buffer(nullptr, 0), values_(std::move(values)) {
+    // vector 不再修改，data() 在 Buffer 的整个生命周期内不变
+    data_ = reinterpret_cast<const uint8_t*>(values_.data());
+    size_ = static_cast<int64_t>(values_.size() * sizeof(T));
+    capacity_ = static_cast<int64_t>(values_.capacity() * sizeof(T));
+  }
+
+  const std::vector<T>& values() const { return values_; }
+
+ private:
+  const std::vector<T> values_;
+};
+
+// 借用一段内存，同时持有 owner，owner 释放前内存一直有效
+class KeepAliveBuffer : public arrow::Buffer {
+ public:
+  KeepAliveBuffer(const uint8_t* data, int64_t size, std::shared_ptr<const void> owner)
+      : arrow::Buffer(data, size), owner_(std::move(owner)) {}
+
+ private:
+  std::shared_ptr<const void> owner_;
+};
+
+namespace zero_copy_internal {
+
+// 满足对齐要求时原样返回，否则复制到内存池
+inline arrow::Result<std::shared_ptr<arrow::Buffer>> Align(std::shared_ptr<arrow::Buffer> buffer,
+                                                           int64_t alignment,
+                                                           const ZeroCopyOptions& options,
+                                                           ZeroCopyStats* stats) {
+  const uint8_t* data = buffer->data();
+  const int64_t size = buffer->size();
+  ARROW_ASSIGN_OR_RAISE(auto aligned,
+                        arrow::util::EnsureAlignment(std::move(buffer), alignment, options.pool));
+  if (stats != nullptr) {
+    if (aligned->data() == data) {
+      ++stats->wrapped_buffers;
+      stats->wrapped_bytes += size;
+    } else {
+      ++stats->copied_buffers;
+      stats->copied_bytes += size;
+    }
+  }
+  return aligned;
+}
+
+template <typename T>
+int64_t AlignmentFor(const ZeroCopyOptions& options) {
+  return options.alignment == arrow::util::kValueAlignment ? static_cast<int64_t>(alignof(T))
+                                                           : options.alignment;
+}
+
+// type 为空时按 T 推断（double -> float64 等）；否则检查 C++ 类型和 Arrow 类型的宽度一致，
+// 例如 int32_t 可以作为 date32 的值。dictionary 虽然也算定长类型（值是索引），
+// 但数组还需要字典本身，只包装索引缓冲区得到的数组一访问就会崩溃，所以不接受
+template <typename T>
+arrow::Result<std::shared_ptr<arrow::DataType>> ResolveType(
+    std::shared_ptr<arrow::DataType> type) {
+  if (type == nullptr) return arrow::CTypeTraits<T>::type_singleton();
+  if (type->id() == arrow::Type::DICTIONARY) {
+    return arrow::Status::TypeError("zero-copy wrapping cannot build a dictionary array, got ",
+                                    type->ToString());
+  }
+  if (!arrow::is_fixed_width(type->id()) || type->id() == arrow::Type::BOOL ||
+      type->id() == arrow::Type::NA) {
+    return arrow::Status::TypeError("zero-copy wrapping needs a fixed-width type, got ",
+                                    type->ToString());
+  }
+  const int bit_width = static_cast<const arrow::FixedWidthType&>(*type).bit_width();
+  if (bit_width != static_cast<int>(sizeof(T) * 8)) {
+    return arrow::Status::TypeError(type->ToString(), " has ", bit_width,
+                                    " bits per value, C++ type has ", sizeof(T) * 8);
+  }
+  return type;
+}
+
+template <typename T>
+arrow::Result<std::shared_ptr<arrow::Array>> MakeArray(std::shared_ptr<arrow::DataType> type,
+                                                       std::shared_ptr<arrow::Buffer> values) {
+  const int64_t length = values->size() / static_cast<int64_t>(sizeof(T));
+  auto data = arrow::ArrayData::Make(std::move(type), length, {nullptr, std::move(values)},
+                                     /*null_count=*/0);
+  return arrow::MakeArray(std::move(data));
+}
+
+}  // namespace zero_copy_internal
+
+// 拿走 values 的所有权，返回引用 vector 内存的 Buffer。vector 自己的分配总是按 T 对齐
+template <typename T>
+std::shared_ptr<arrow::Buffer> BufferFromVector(std::vector<T>&& values) {
+  return std::make_shared<VectorBuffer<T>>(std::move(values));
+}
+
+// 包装 [data, data + length) 这段内存。owner 为空时只借用，调用方保证内存比返回的 Buffer 活得久
+template <typename T>
+arrow::Result<std::shared_ptr<arrow::Buffer>> WrapRawBuffer(
+    const T* data, int64_t length, std::shared_ptr<const void> owner,
+    const ZeroCopyOptions& options = ZeroCopyOptions(), ZeroCopyStats* stats = nullptr) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+  const int64_t size = length * static_cast<int64_t>(sizeof(T));
+  std::shared_ptr<arrow::Buffer> buffer =
+      owner == nullptr ? std::make_shared<arrow::Buffer>(bytes, size)
+                       : std::make_shared<KeepAliveBuffer>(bytes, size, std::move(owner));
+  return zero_copy_internal::Align(std::move(buffer), zero_copy_internal::AlignmentFor<T>(options),
+                                   options, stats);
+}
+
+// 用一个装着 T 值的 Buffer 构建数组，type 为空时按 T 推断
+template <typename T>
+arrow::Result<std::shared_ptr<arrow::Array>> ArrayFromBuffer(
+    std::shared_ptr<arrow::Buffer> values, std::shared_ptr<arrow::DataType> type = nullptr) {
+  ARROW_ASSIGN_OR_RAISE(type, zero_copy_internal::ResolveType<T>(std::move(type)));
+  return zero_copy_internal::MakeArray<T>(std::move(type), std::move(values));
+}
+
+// 拿走 values 的所有权构建数组，例如把 returns 变成 float64 数组，或把 int32_t 天数变成 date32
+template <typename T>
+arrow::Result<std::shared_ptr<arrow::Array>> ArrayFromVector(
+    std::vector<T>&& values, std::shared_ptr<arrow::DataType> type = nullptr,
+    const ZeroCopyOptions& options = ZeroCopyOptions(), ZeroCopyStats* stats = nullptr) {
+  ARROW_ASSIGN_OR_RAISE(type, zero_copy_internal::ResolveType<T>(std::move(type)));
+  ARROW_ASSIGN_OR_RAISE(auto buffer,
+                        zero_copy_internal::Align(BufferFromVector(std::move(values)),
+                                                  zero_copy_internal::AlignmentFor<T>(options),
+                                                  options, stats));
+  return zero_copy_internal::MakeArray<T>(std::move(type), std::move(buffer));
+}
+
+// 包装原始缓冲区构建数组，owner 的含义和 WrapRawBuffer 一样
+template <typename T>
+arrow::Result<std::shared_ptr<arrow::Array>> ArrayFromRaw(
+    const T* data, int64_t length, std::shared_ptr<const void> owner,
+    std::shared_ptr<arrow::DataType> type = nullptr,
+    const ZeroCopyOptions& options = ZeroCopyOptions(), ZeroCopyStats* stats = nullptr) {
+  ARROW_ASSIGN_OR_RAISE(type, zero_copy_internal::ResolveType<T>(std::move(type)));
+  ARROW_ASSIGN_OR_RAISE(auto buffer,
+                        WrapRawBuffer(data, length, std::move(owner), options, stats));
+  return zero_copy_internal::MakeArray<T>(std::move(type), std::move(buffer));
+}
+
+// 逐列拿走 vector 或包装原始缓冲区，最后拼成 RecordBatch，所有列的行数必须相同
+class ZeroCopyBatchBuilder {
+ public:
+  explicit ZeroCopyBatchBuilder(ZeroCopyOptions options = ZeroCopyOptions())
+      : options_(options) {}
+
+  template <typename T>
+  arrow::Status AddVector(const std::string& name, std::vector<T>&& values,
+                          std::shared_ptr<arrow::DataType> type = nullptr) {
+    ARROW_ASSIGN_OR_RAISE(auto array,
+                          ArrayFromVector(std::move(values), std::move(type), options_, &stats_));
+    return AddArray(name, std::move(array));
+  }
+
+  template <typename T>
+  arrow::Status AddRaw(const std::string& name, const T* data, int64_t length,
+                       std::shared_ptr<const void> owner,
+                       std::shared_ptr<arrow::DataType> type = nullptr) {
+    ARROW_ASSIGN_OR_RAISE(auto array, ArrayFromRaw(data, length, std::move(owner),
+                                                   std::move(type), options_, &stats_));
+    return AddArray(name, std::move(array));
+  }
+
+  // 已经是 Arrow 数组的列（例如用 Builder 构建的字符串列）直接加入
+  arrow::Status AddArray(const std::string& name, std::shared_ptr<arrow::Array> array) {
+    if (!columns_.empty() && array->length() != columns_.front()->length()) {
+      return arrow::Status::Invalid("column ", name, " has ", array->length(),
+                                    " rows, expected ", columns_.front()->length());
+    }
+    fields_.push_back(arrow::field(name, array->type()));
+    columns_.push_back(std::move(array));
+    return arrow::Status::OK();
+  }
+
+  const ZeroCopyStats& stats() const { return stats_; }
+
+  // 返回 batch 后清空已加入的列，可以继续构建下一个 batch
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> Finish() {
+    const int64_t num_rows = columns_.empty() ? 0 : columns_.front()->length();
+    auto batch = arrow::RecordBatch::Make(arrow::schema(std::move(fields_)), num_rows,
+                                          std::move(columns_));
+    fields_.clear();
+    columns_.clear();
+    return batch;
+  }
+
+ private:
+  ZeroCopyOptions options_;
+  ZeroCopyStats stats_;
+  std::vector<std::shared_ptr<arrow::Field>> fields_;
+  std::vector<std::shared_ptr<arrow::Array>> columns_;
+};
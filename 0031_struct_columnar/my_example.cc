@@ -0,0 +1,175 @@
+// (文档部分: 包含)
+#include <arrow/api.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../fund_panel/fund_panel.h"
+#include "struct_columnar.h"
+// (文档部分: 包含)
+
+// (文档部分: 行结构体)
+// 行情程序里一行净值记录。date 是 date32 的天数
+struct NavRow {
+  int32_t date;
+  double nav;
+  double cum_nav;
+  double adj_nav;
+};
+
+template <>
+struct ColumnarRow<NavRow> {
+  static constexpr auto columns() {
+    return std::make_tuple(Column<arrow::Date32Type>("date", &NavRow::date),
+                           Column("nav", &NavRow::nav), Column("cum_nav", &NavRow::cum_nav),
+                           Column("adj_nav", &NavRow::adj_nav));
+  }
+};
+
+// 带基金代码的一行，列和 fund_panel 的 FundPanelSchema 一样
+struct FundNavRow {
+  std::string fund_code;
+  int32_t date;
+  double nav;
+  double cum_nav;
+  double adj_nav;
+};
+
+template <>
+struct ColumnarRow<FundNavRow> {
+  static constexpr auto columns() {
+    return std::make_tuple(Column("fund_code", &FundNavRow::fund_code),
+                           Column<arrow::Date32Type>("date", &FundNavRow::date),
+                           Column("nav", &FundNavRow::nav),
+                           Column("cum_nav", &FundNavRow::cum_nav),
+                           Column("adj_nav", &FundNavRow::adj_nav));
+  }
+};
+// (文档部分: 行结构体)
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+void PrintRate(const std::string& name, int64_t rows, double ms) {
+  std::cout << name << ": " << ms << " ms, " << rows / ms / 1000 << " M rows/s" << std::endl;
+}
+
+// (文档部分: 每列一个 Builder)
+// 0001_how_to_build 的做法：每列一个 Builder，每行每列调用一次 Append
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> BuildPerColumn(const std::vector<NavRow>& rows,
+                                                                   bool reserve) {
+  arrow::Date32Builder date_builder;
+  arrow::DoubleBuilder nav_builder, cum_nav_builder, adj_nav_builder;
+  const auto num_rows = static_cast<int64_t>(rows.size());
+  if (reserve) {
+    ARROW_RETURN_NOT_OK(date_builder.Reserve(num_rows));
+    ARROW_RETURN_NOT_OK(nav_builder.Reserve(num_rows));
+    ARROW_RETURN_NOT_OK(cum_nav_builder.Reserve(num_rows));
+    ARROW_RETURN_NOT_OK(adj_nav_builder.Reserve(num_rows));
+  }
+  for (const NavRow& row : rows) {
+    ARROW_RETURN_NOT_OK(date_builder.Append(row.date));
+    ARROW_RETURN_NOT_OK(nav_builder.Append(row.nav));
+    ARROW_RETURN_NOT_OK(cum_nav_builder.Append(row.cum_nav));
+    ARROW_RETURN_NOT_OK(adj_nav_builder.Append(row.adj_nav));
+  }
+  std::vector<std::shared_ptr<arrow::Array>> columns(4);
+  ARROW_RETURN_NOT_OK(date_builder.Finish(&columns[0]));
+  ARROW_RETURN_NOT_OK(nav_builder.Finish(&columns[1]));
+  ARROW_RETURN_NOT_OK(cum_nav_builder.Finish(&columns[2]));
+  ARROW_RETURN_NOT_OK(adj_nav_builder.Finish(&columns[3]));
+  // schema 也要手写一遍
+  auto schema = arrow::schema({arrow::field("date", arrow::date32()),
+                               arrow::field("nav", arrow::float64()),
+                               arrow::field("cum_nav", arrow::float64()),
+                               arrow::field("adj_nav", arrow::float64())});
+  return arrow::RecordBatch::Make(schema, num_rows, std::move(columns));
+}
+// (文档部分: 每列一个 Builder)
+
+arrow::Status RunMain() {
+  // (文档部分: 生成数据)
+  // 1000 万行随机游走的净值
+  const int64_t num_rows = 10000000;
+  std::vector<NavRow> rows(num_rows);
+  std::mt19937_64 rng(42);
+  std::normal_distribution<double> daily_return(0.0003, 0.01);
+  double nav = 1.0;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    nav *= 1.0 + daily_return(rng);
+    rows[i] = {static_cast<int32_t>(16440 + i % 5000), nav, nav + 0.5, nav * 1.1};
+  }
+  std::cout << "derived schema:\n" << RowSchema<NavRow>()->ToString() << std::endl;
+  // (文档部分: 生成数据)
+
+  // (文档部分: 对比)
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto per_column, BuildPerColumn(rows, false));
+  PrintRate("per-column Builder::Append", num_rows, ElapsedMs(start_time));
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto reserved, BuildPerColumn(rows, true));
+  PrintRate("per-column Builder::Append, reserved", num_rows, ElapsedMs(start_time));
+
+  // 一行一行追加，和从行情回调里收到一行就追加一行一样
+  start_time = std::chrono::high_resolution_clock::now();
+  RowAppender<NavRow> appender;
+  ARROW_RETURN_NOT_OK(appender.Reserve(num_rows));
+  for (const NavRow& row : rows) ARROW_RETURN_NOT_OK(appender.Append(row));
+  ARROW_ASSIGN_OR_RAISE(auto fused, appender.Finish());
+  PrintRate("RowAppender::Append(row)", num_rows, ElapsedMs(start_time));
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ARROW_RETURN_NOT_OK(appender.Append(rows));
+  ARROW_ASSIGN_OR_RAISE(auto fused_all, appender.Finish());
+  PrintRate("RowAppender::Append(rows)", num_rows, ElapsedMs(start_time));
+
+  ARROW_RETURN_NOT_OK(fused->ValidateFull());
+  std::cout << "same batches: " << std::boolalpha
+            << (per_column->Equals(*reserved) && per_column->Equals(*fused) &&
+                per_column->Equals(*fused_all))
+            << std::endl;
+  // (文档部分: 对比)
+
+  // (文档部分: 字符串列)
+  // 带基金代码的行：生成的 schema 和手写的 FundPanelSchema 一样，构建出来的表和面板数据一样
+  FundPanelOptions panel_options;
+  panel_options.num_funds = 100;
+  panel_options.num_days = 1000;
+  ARROW_ASSIGN_OR_RAISE(auto panel, MakeFundPanel(panel_options));
+  ARROW_ASSIGN_OR_RAISE(auto panel_batch, panel->CombineChunksToBatch());
+  const auto& codes = static_cast<const arrow::StringArray&>(*panel_batch->column(0));
+  const auto& dates = static_cast<const arrow::Date32Array&>(*panel_batch->column(1));
+  const auto& navs = static_cast<const arrow::DoubleArray&>(*panel_batch->column(2));
+  const auto& cum_navs = static_cast<const arrow::DoubleArray&>(*panel_batch->column(3));
+  const auto& adj_navs = static_cast<const arrow::DoubleArray&>(*panel_batch->column(4));
+  RowAppender<FundNavRow> fund_appender;
+  ARROW_RETURN_NOT_OK(fund_appender.Reserve(panel_batch->num_rows(), 7));
+  for (int64_t i = 0; i < panel_batch->num_rows(); ++i) {
+    ARROW_RETURN_NOT_OK(fund_appender.Append({codes.GetString(i), dates.Value(i), navs.Value(i),
+                                              cum_navs.Value(i), adj_navs.Value(i)}));
+  }
+  ARROW_ASSIGN_OR_RAISE(auto fund_batch, fund_appender.Finish());
+  ARROW_RETURN_NOT_OK(fund_batch->ValidateFull());
+  std::cout << "schema equals FundPanelSchema: "
+            << RowSchema<FundNavRow>()->Equals(*FundPanelSchema())
+            << ", batch equals the panel: " << fund_batch->Equals(*panel_batch) << std::endl;
+  // (文档部分: 字符串列)
+  return arrow::Status::OK();
+}
+
+// (文档部分: 主函数)
+int main() {
+  arrow::Status st = RunMain();
+  if (!st.ok()) {
+    std::cerr << st << std::endl;
+    return 1;
+  }
+  return 0;
+}
+// (文档部分: 主函数)
@@ -0,0 +1,270 @@
+// 从一个普通的 C++ 结构体生成 Arrow schema 和按行追加的构建器。
+// 前面的示例都是手写 schema（arrow::field("Day", arrow::int8()) ...），每一列一个 Builder，
+// 每追加一行要对每一列调用一次 Append 并检查一次 Status。行情程序收到的是一行一行的结构体，
+// 这里在编译期用成员指针描述每一列：
+//
+//   struct NavRow { int32_t date; double nav; double cum_nav; double adj_nav; };
+//   template <>
+//   struct ColumnarRow<NavRow> {
+//     static constexpr auto columns() {
+//       return std::make_tuple(Column<arrow::Date32Type>("date", &NavRow::date),
+//                              Column("nav", &NavRow::nav), ...);
+//     }
+//   };
+//
+// RowSchema<NavRow>() 生成 schema；RowAppender<NavRow> 为每一列保存一个 TypedBufferBuilder，
+// Append(row) 展开成对每一列的内联写入，只在行数用完预留的容量时检查一次，没有虚函数调用。
+// 支持没有类型参数的定长类型（整数、浮点、date32 等）和 utf8（成员是 std::string 或
+// std::string_view），不支持 null。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/buffer_builder.h>
+
+#include <algorithm>
+#include <memory>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 一列的描述：列名、结构体成员、Arrow 类型
+template <typename ArrowType, typename Row, typename Member>
+struct ColumnSpec {
+  using arrow_type = ArrowType;
+  const char* name;
+  Member Row::*member;
+};
+
+// 显式指定 Arrow 类型，例如 int32_t 成员作为 date32 列
+template <typename ArrowType, typename Row, typename Member>
+constexpr ColumnSpec<ArrowType, Row, Member> Column(const char* name, Member Row::*member) {
+  return {name, member};
+}
+
+namespace struct_columnar_internal {
+
+// 成员类型对应的默认 Arrow 类型：数值类型按 CTypeTraits，字符串是 utf8
+template <typename Member, typename Enable = void>
+struct DefaultArrowType {
+  using type = typename arrow::CTypeTraits<Member>::ArrowType;
+};
+
+template <typename Member>
+struct DefaultArrowType<Member, std::enable_if_t<std::is_convertible_v<Member, std::string_view>>> {
+  using type = arrow::StringType;
+};
+
+}  // namespace struct_columnar_internal
+
+// 按成员类型推断 Arrow 类型（double -> float64，int64_t -> int64，std::string -> utf8）
+template <typename Row, typename Member>
+constexpr auto Column(const char* name, Member Row::*member) {
+  using ArrowType = typename struct_columnar_internal::DefaultArrowType<Member>::type;
+  return ColumnSpec<ArrowType, Row, Member>{name, member};
+}
+
+// 为每个结构体特化，columns() 返回 Column(...) 组成的 tuple
+template <typename Row>
+struct ColumnarRow;
+
+namespace struct_columnar_internal {
+
+template <typename Row>
+using Columns = decltype(ColumnarRow<Row>::columns());
+
+template <typename Row>
+constexpr size_t kNumColumns = std::tuple_size_v<Columns<Row>>;
+
+template <typename Spec>
+using ArrowTypeOf = typename std::decay_t<Spec>::arrow_type;
+
+// 定长类型的一列：一个值缓冲区
+template <typename ArrowType, typename Enable = void>
+class ColumnStorage {
+ public:
+  static_assert(arrow::TypeTraits<ArrowType>::is_parameter_free,
+                "ColumnStorage needs an Arrow type without parameters");
+  using CType = typename arrow::TypeTraits<ArrowType>::CType;
+
+  explicit ColumnStorage(arrow::MemoryPool* pool) : values_(pool) {}
+
+  arrow::Status Reserve(int64_t rows, int64_t /*string_bytes*/) { return values_.Reserve(rows); }
+
+  // 调用方保证已经预留了容量
+  template <typename Member>
+  arrow::Status Append(const Member& value) {
+    values_.UnsafeAppend(static_cast<CType>(value));
+    return arrow::Status::OK();
+  }
+
+  arrow::Result<std::shared_ptr<arrow::ArrayData>> Finish(int64_t length) {
+    ARROW_ASSIGN_OR_RAISE(auto values, values_.Finish());
+    return arrow::ArrayData::Make(arrow::TypeTraits<ArrowType>::type_singleton(), length,
+                                  {nullptr, std::move(values)}, /*null_count=*/0);
+  }
+
+ private:
+  arrow::TypedBufferBuilder<CType> values_;
+};
+
+// utf8 的一列：偏移量和字符数据两个缓冲区，字符数据不够时自己扩容
+template <>
+class ColumnStorage<arrow::StringType> {
+ public:
+  explicit ColumnStorage(arrow::MemoryPool* pool) : offsets_(pool), data_(pool) {}
+
+  arrow::Status Reserve(int64_t rows, int64_t string_bytes) {
+    // 第一次预留时多留一个位置给开头的 0
+    ARROW_RETURN_NOT_OK(offsets_.Reserve(rows + (offsets_.length() == 0)));
+    if (offsets_.length() == 0) offsets_.UnsafeAppend(0);
+    return data_.Reserve(string_bytes);
+  }
+
+  template <typename Member>
+  arrow::Status Append(const Member& value) {
+    const std::string_view view(value);
+    if (data_.length() + static_cast<int64_t>(view.size()) > arrow::kBinaryMemoryLimit) {
+      return arrow::Status::CapacityError("utf8 column exceeds ", arrow::kBinaryMemoryLimit,
+                                          " bytes");
+    }
+    ARROW_RETURN_NOT_OK(
+        data_.Append(reinterpret_cast<const uint8_t*>(view.data()), view.size()));
+    offsets_.UnsafeAppend(static_cast<int32_t>(data_.length()));
+    return arrow::Status::OK();
+  }
+
+  arrow::Result<std::shared_ptr<arrow::ArrayData>> Finish(int64_t length) {
+    if (offsets_.length() == 0) ARROW_RETURN_NOT_OK(offsets_.Append(0));
+    ARROW_ASSIGN_OR_RAISE(auto offsets, offsets_.Finish());
+    ARROW_ASSIGN_OR_RAISE(auto data, data_.Finish());
+    return arrow::ArrayData::Make(arrow::utf8(), length,
+                                  {nullptr, std::move(offsets), std::move(data)},
+                                  /*null_count=*/0);
+  }
+
+ private:
+  arrow::TypedBufferBuilder<int32_t> offsets_;
+  arrow::TypedBufferBuilder<uint8_t> data_;
+};
+
+template <typename Row, typename Indices>
+struct StorageTuple;
+
+template <typename Row, size_t... I>
+struct StorageTuple<Row, std::index_sequence<I...>> {
+  using type = std::tuple<ColumnStorage<ArrowTypeOf<std::tuple_element_t<I, Columns<Row>>>>...>;
+};
+
+template <typename Spec>
+std::shared_ptr<arrow::Field> FieldFor(const Spec& spec) {
+  return arrow::field(spec.name, arrow::TypeTraits<ArrowTypeOf<Spec>>::type_singleton());
+}
+
+}  // namespace struct_columnar_internal
+
+// 按 ColumnarRow<Row>::columns() 生成 schema，列的顺序和描述的顺序一样
+template <typename Row>
+std::shared_ptr<arrow::Schema> RowSchema() {
+  return std::apply(
+      [](const auto&... specs) {
+        return arrow::schema({struct_columnar_internal::FieldFor(specs)...});
+      },
+      ColumnarRow<Row>::columns());
+}
+
+// 把一行一行的 Row 追加到各列的缓冲区，Finish 得到 RecordBatch。
+// Append 出错（内存不足、字符串列超过 2GB）时可能只追加了一部分列，之后不能再使用
+template <typename Row>
+class RowAppender {
+ public:
+  explicit RowAppender(arrow::MemoryPool* pool = arrow::default_memory_pool())
+      : storages_(MakeStorages(pool, Indices())) {}
+
+  int64_t length() const { return length_; }
+
+  // 预留 rows 行，string_bytes_per_row 是每行所有字符串列加起来的平均字节数
+  arrow::Status Reserve(int64_t rows, int64_t string_bytes_per_row = 0) {
+    ARROW_RETURN_NOT_OK(ReserveAll(rows, rows * string_bytes_per_row, Indices()));
+    capacity_ = length_ + rows;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Append(const Row& row) {
+    if (ARROW_PREDICT_FALSE(length_ == capacity_)) {
+      ARROW_RETURN_NOT_OK(Reserve(std::max<int64_t>(length_, 1024)));
+    }
+    ARROW_RETURN_NOT_OK(AppendAll(row, Indices()));
+    ++length_;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Append(const Row* rows, int64_t num_rows) {
+    if (capacity_ - length_ < num_rows) ARROW_RETURN_NOT_OK(Reserve(num_rows));
+    for (int64_t i = 0; i < num_rows; ++i) {
+      ARROW_RETURN_NOT_OK(AppendAll(rows[i], Indices()));
+      ++length_;
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Append(const std::vector<Row>& rows) {
+    return Append(rows.data(), static_cast<int64_t>(rows.size()));
+  }
+
+  // 返回已追加的行，之后可以继续追加下一个 batch
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> Finish() {
+    std::vector<std::shared_ptr<arrow::ArrayData>> columns;
+    ARROW_RETURN_NOT_OK(FinishAll(&columns, Indices()));
+    auto batch = arrow::RecordBatch::Make(RowSchema<Row>(), length_, std::move(columns));
+    length_ = 0;
+    capacity_ = 0;
+    return batch;
+  }
+
+ private:
+  using Indices = std::make_index_sequence<struct_columnar_internal::kNumColumns<Row>>;
+  using Storages = typename struct_columnar_internal::StorageTuple<Row, Indices>::type;
+
+  template <size_t... I>
+  static Storages MakeStorages(arrow::MemoryPool* pool, std::index_sequence<I...>) {
+    return Storages((static_cast<void>(I), pool)...);
+  }
+
+  template <size_t... I>
+  arrow::Status ReserveAll(int64_t rows, int64_t string_bytes, std::index_sequence<I...>) {
+    arrow::Status status;
+    ((status &= std::get<I>(storages_).Reserve(rows, string_bytes)), ...);
+    return status;
+  }
+
+  template <size_t... I>
+  arrow::Status AppendAll(const Row& row, std::index_sequence<I...>) {
+    static constexpr auto kColumns = ColumnarRow<Row>::columns();
+    arrow::Status status;
+    ((status &= std::get<I>(storages_).Append(row.*(std::get<I>(kColumns).member))), ...);
+    return status;
+  }
+
+  template <size_t... I>
+  arrow::Status FinishAll(std::vector<std::shared_ptr<arrow::ArrayData>>* columns,
+                          std::index_sequence<I...>) {
+    arrow::Status status;
+    auto finish = [&](auto& storage) {
+      if (!status.ok()) return;
+      auto data = storage.Finish(length_);
+      if (data.ok()) {
+        columns->push_back(*std::move(data));
+      } else {
+        status = data.status();
+      }
+    };
+    (finish(std::get<I>(storages_)), ...);
+    return status;
+  }
+
+  Storages storages_;
+  int64_t length_ = 0;
+  int64_t capacity_ = 0;
+};
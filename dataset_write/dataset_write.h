@@ -0,0 +1,33 @@
+// 数据集写入的公共工具，供 0027_sidecar_index、0028_partial_aggregates 等在写完数据集后
+// 还要逐个处理新文件的示例使用。
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/dataset/api.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 0004 的 FileSystemDataset::Write，返回写出的每个文件的路径。
+// writer_post_finish 只记下文件路径，写完后要读回新文件的调用方在 Write 返回后再读
+// （文件刚写完还在页缓存里）。回调在 IO 线程池里执行，在回调里同步读文件要等同一个线程池，
+// 同时结束的文件一多就会占满线程池而死锁
+inline arrow::Result<std::vector<std::string>> WriteDatasetCollectingPaths(
+    arrow::dataset::FileSystemDatasetWriteOptions write_options,
+    const std::shared_ptr<arrow::dataset::Scanner>& scanner) {
+  auto written = std::make_shared<std::vector<std::string>>();
+  auto mutex = std::make_shared<std::mutex>();
+  auto previous = write_options.writer_post_finish;
+  write_options.writer_post_finish =
+      [previous, written, mutex](arrow::dataset::FileWriter* writer) -> arrow::Status {
+    ARROW_RETURN_NOT_OK(previous(writer));
+    std::lock_guard<std::mutex> lock(*mutex);
+    written->push_back(writer->destination().path);
+    return arrow::Status::OK();
+  };
+  ARROW_RETURN_NOT_OK(arrow::dataset::FileSystemDataset::Write(write_options, scanner));
+  return std::move(*written);
+}
@@ -0,0 +1,140 @@
+// 生成模拟的基金净值面板数据（多只基金 × 多个交易日），供后续各个示例做基准测试使用。
+// 列与 0006_cal_sharpe_ratio/fund_nav.csv 对应：净值日期 -> date，单位净值 -> nav，
+// 累计净值 -> cum_nav，复权净值 -> adj_nav，另外加上基金代码 fund_code。
+#pragma once
+
+#include <arrow/api.h>
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+
+struct FundPanelOptions {
+  // 基金数量
+  int num_funds = 1000;
+  // 每只基金的交易日数量
+  int num_days = 750;
+  // 第一个交易日，date32 表示（自 1970-01-01 起的天数），默认 2015-01-05
+  int32_t start_date = 16440;
+  // 停牌或缺失净值的概率，缺失时三列净值都为 null
+  double null_probability = 0.0;
+  // 随机数种子，保证每次生成的数据一样
+  uint64_t seed = 42;
+  // false: 按 (fund_code, date) 排序；true: 按 (date, fund_code) 排序，模拟每天追加一批数据
+  bool date_major = false;
+};
+
+// 基金代码，例如 F000001
+inline std::string FundCode(int fund) {
+  char buf[16];
+  std::snprintf(buf, sizeof(buf), "F%06d", fund);
+  return buf;
+}
+
+// 从 start_date 开始的第 k 个交易日（只跳过周末）
+inline int32_t TradingDay(int32_t start_date, int k) {
+  // 1970-01-01 是星期四，(days + 4) % 7 得到 0 = 星期日 ... 6 = 星期六
+  int32_t day = start_date;
+  while ((day + 4) % 7 == 0 || (day + 4) % 7 == 6) ++day;
+  for (int i = 0; i < k; ++i) {
+    ++day;
+    while ((day + 4) % 7 == 0 || (day + 4) % 7 == 6) ++day;
+  }
+  return day;
+}
+
+inline std::shared_ptr<arrow::Schema> FundPanelSchema() {
+  return arrow::schema({arrow::field("fund_code", arrow::utf8()),
+                        arrow::field("date", arrow::date32()),
+                        arrow::field("nav", arrow::float64()),
+                        arrow::field("cum_nav", arrow::float64()),
+                        arrow::field("adj_nav", arrow::float64())});
+}
+
+// 按 options 生成整张面板表，净值保留 4 位小数。
+inline arrow::Result<std::shared_ptr<arrow::Table>> MakeFundPanel(
+    const FundPanelOptions& options = FundPanelOptions()) {
+  const int64_t num_rows = static_cast<int64_t>(options.num_funds) * options.num_days;
+
+  std::vector<int32_t> dates(options.num_days);
+  for (int d = 0; d < options.num_days; ++d) {
+    dates[d] = TradingDay(options.start_date, d);
+  }
+
+  // 先按基金生成每一天的净值，再按要求的顺序写入构建器
+  std::mt19937_64 rng(options.seed);
+  std::normal_distribution<double> daily_return(0.0003, 0.01);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<double> nav(num_rows), cum_nav(num_rows), adj_nav(num_rows);
+  std::vector<bool> valid(num_rows, true);
+  for (int f = 0; f < options.num_funds; ++f) {
+    double unit = 1.0;
+    double dividend = 0.0;
+    double adjusted = 1.0;
+    for (int d = 0; d < options.num_days; ++d) {
+      const int64_t i = static_cast<int64_t>(f) * options.num_days + d;
+      const double r = daily_return(rng);
+      unit *= 1.0 + r;
+      adjusted *= 1.0 + r;
+      // 偶尔分红：单位净值下降，累计净值不变
+      if (uniform(rng) < 0.002 && unit > 1.1) {
+        dividend += 0.1;
+        unit -= 0.1;
+      }
+      nav[i] = std::round(unit * 1e4) / 1e4;
+      cum_nav[i] = std::round((unit + dividend) * 1e4) / 1e4;
+      adj_nav[i] = std::round(adjusted * 1e4) / 1e4;
+      if (options.null_probability > 0 && uniform(rng) < options.null_probability) {
+        valid[i] = false;
+      }
+    }
+  }
+
+  arrow::StringBuilder code_builder;
+  arrow::Date32Builder date_builder;
+  arrow::DoubleBuilder nav_builder, cum_nav_builder, adj_nav_builder;
+  ARROW_RETURN_NOT_OK(code_builder.Reserve(num_rows));
+  ARROW_RETURN_NOT_OK(code_builder.ReserveData(num_rows * 7));
+  ARROW_RETURN_NOT_OK(date_builder.Reserve(num_rows));
+  ARROW_RETURN_NOT_OK(nav_builder.Reserve(num_rows));
+  ARROW_RETURN_NOT_OK(cum_nav_builder.Reserve(num_rows));
+  ARROW_RETURN_NOT_OK(adj_nav_builder.Reserve(num_rows));
+
+  std::vector<std::string> codes(options.num_funds);
+  for (int f = 0; f < options.num_funds; ++f) codes[f] = FundCode(f + 1);
+
+  auto append_row = [&](int f, int d) {
+    const int64_t i = static_cast<int64_t>(f) * options.num_days + d;
+    code_builder.UnsafeAppend(codes[f]);
+    date_builder.UnsafeAppend(dates[d]);
+    if (valid[i]) {
+      nav_builder.UnsafeAppend(nav[i]);
+      cum_nav_builder.UnsafeAppend(cum_nav[i]);
+      adj_nav_builder.UnsafeAppend(adj_nav[i]);
+    } else {
+      nav_builder.UnsafeAppendNull();
+      cum_nav_builder.UnsafeAppendNull();
+      adj_nav_builder.UnsafeAppendNull();
+    }
+  };
+  if (options.date_major) {
+    for (int d = 0; d < options.num_days; ++d) {
+      for (int f = 0; f < options.num_funds; ++f) append_row(f, d);
+    }
+  } else {
+    for (int f = 0; f < options.num_funds; ++f) {
+      for (int d = 0; d < options.num_days; ++d) append_row(f, d);
+    }
+  }
+
+  std::shared_ptr<arrow::Array> code_array, date_array, nav_array, cum_nav_array,
+      adj_nav_array;
+  ARROW_ASSIGN_OR_RAISE(code_array, code_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(date_array, date_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(nav_array, nav_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(cum_nav_array, cum_nav_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(adj_nav_array, adj_nav_builder.Finish());
+  return arrow::Table::Make(
+      FundPanelSchema(), {code_array, date_array, nav_array, cum_nav_array, adj_nav_array});
+}